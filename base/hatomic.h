@@ -127,4 +127,102 @@ typedef atomic_long                 hatomic_t;
 #define hatomic_inc                 ATOMIC_INC
 #define hatomic_dec                 ATOMIC_DEC
 
+// NOTE: sequentially consistent ops on plain variables, for lock-free structures.
+#include "hplatform.h"
+#if defined(__GNUC__) || defined(__clang__)
+static inline void* hatomic_ptr_load(void* volatile* p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static inline void hatomic_ptr_store(void* volatile* p, void* v) {
+    __atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+}
+static inline void* hatomic_ptr_exchange(void* volatile* p, void* v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+// @return true if *p == expected and *p = desired
+static inline bool hatomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static inline long hatomic_long_exchange(volatile long* p, long v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+// @return old value
+static inline long hatomic_long_add(volatile long* p, long v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+}
+#elif defined(_WIN32)
+static inline void* hatomic_ptr_load(void* volatile* p) {
+    return InterlockedCompareExchangePointer(p, NULL, NULL);
+}
+static inline void hatomic_ptr_store(void* volatile* p, void* v) {
+    InterlockedExchangePointer(p, v);
+}
+static inline void* hatomic_ptr_exchange(void* volatile* p, void* v) {
+    return InterlockedExchangePointer(p, v);
+}
+static inline bool hatomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    return InterlockedCompareExchangePointer(p, desired, expected) == expected;
+}
+static inline long hatomic_long_exchange(volatile long* p, long v) {
+    return InterlockedExchange((volatile LONG*)p, v);
+}
+static inline long hatomic_long_add(volatile long* p, long v) {
+    return InterlockedExchangeAdd((volatile LONG*)p, v);
+}
+#else
+static inline void* hatomic_ptr_load(void* volatile* p) {
+    return *p;
+}
+static inline void hatomic_ptr_store(void* volatile* p, void* v) {
+    *p = v;
+}
+static inline void* hatomic_ptr_exchange(void* volatile* p, void* v) {
+    void* old = *p;
+    *p = v;
+    return old;
+}
+static inline bool hatomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    if (*p != expected) return false;
+    *p = desired;
+    return true;
+}
+static inline long hatomic_long_exchange(volatile long* p, long v) {
+    long old = *p;
+    *p = v;
+    return old;
+}
+static inline long hatomic_long_add(volatile long* p, long v) {
+    long old = *p;
+    *p += v;
+    return old;
+}
+#endif
+
+// NOTE: ops on plain integers written by one thread and read by others,
+// relaxed ones are atomic but not ordered, pair with fences for a seqlock.
+#if defined(__GNUC__) || defined(__clang__)
+#define hatomic_load_relaxed(p)         __atomic_load_n(p, __ATOMIC_RELAXED)
+#define hatomic_load_acquire(p)         __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define hatomic_store_relaxed(p, v)     __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define hatomic_store_release(p, v)     __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define hatomic_fence_acquire()         __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define hatomic_fence_release()         __atomic_thread_fence(__ATOMIC_RELEASE)
+#elif defined(_WIN32)
+#define hatomic_load_relaxed(p)         (*(p))
+#define hatomic_load_acquire(p)         (*(p))
+#define hatomic_store_relaxed(p, v)     (*(p) = (v))
+#define hatomic_store_release(p, v)     (*(p) = (v))
+#define hatomic_fence_acquire()         MemoryBarrier()
+#define hatomic_fence_release()         MemoryBarrier()
+#else
+#define hatomic_load_relaxed(p)         (*(p))
+#define hatomic_load_acquire(p)         (*(p))
+#define hatomic_store_relaxed(p, v)     (*(p) = (v))
+#define hatomic_store_release(p, v)     (*(p) = (v))
+#define hatomic_fence_acquire()
+#define hatomic_fence_release()
+#endif
+// only by the writer thread
+#define hatomic_add_relaxed(p, n)       hatomic_store_relaxed(p, *(p) + (n))
+
 #endif // HV_ATOMIC_H_
@@ -6,6 +6,13 @@
 
 #include "hatomic.h"
 
+#ifdef OS_UNIX
+#include <sys/mman.h>
+#endif
+#ifdef OS_LINUX
+#include <sys/syscall.h>
+#endif
+
 #ifndef RAND_MAX
 #define RAND_MAX 2147483647
 #endif
@@ -74,6 +81,62 @@ void hv_free(void* ptr) {
     }
 }
 
+#ifdef OS_UNIX
+static int mirror_fd() {
+#if defined(OS_LINUX) && defined(SYS_memfd_create)
+    return syscall(SYS_memfd_create, "hv_mirror", 1U /* MFD_CLOEXEC */);
+#elif defined(OS_LINUX)
+    return -1;
+#else
+    static hatomic_t s_mirror_cnt = HATOMIC_VAR_INIT(0);
+    char name[64];
+    snprintf(name, sizeof(name), "/hv_mirror.%d.%ld", (int)getpid(), (long)hatomic_inc(&s_mirror_cnt));
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(name);
+    return fd;
+#endif
+}
+#endif
+
+void* hv_mirror_alloc(size_t* len) {
+#ifdef OS_UNIX
+    size_t pagesize = sysconf(_SC_PAGESIZE);
+    size_t size = (*len + pagesize - 1) & ~(pagesize - 1);
+    if (size == 0) return NULL;
+    int fd = mirror_fd();
+    if (fd < 0) return NULL;
+    char* ptr = NULL;
+    if (ftruncate(fd, size) == 0) {
+        // reserve 2*size address space, then map the same pages twice.
+        ptr = (char*)mmap(NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (ptr == MAP_FAILED) {
+            ptr = NULL;
+        } else if (mmap(ptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+                   mmap(ptr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(ptr, size * 2);
+            ptr = NULL;
+        }
+    }
+    close(fd);
+    if (ptr) {
+        hatomic_inc(&s_alloc_cnt);
+        *len = size;
+    }
+    return ptr;
+#else
+    return NULL;
+#endif
+}
+
+void hv_mirror_free(void* ptr, size_t len) {
+#ifdef OS_UNIX
+    if (ptr) {
+        munmap(ptr, len * 2);
+        hatomic_inc(&s_free_cnt);
+    }
+#endif
+}
+
 char* hv_strupper(char* str) {
     char* p = str;
     while (*p != '\0') {
@@ -48,6 +48,13 @@ HV_EXPORT void  hv_free(void* ptr);
 #define HV_STACK_ALLOC(ptr, size)   STACK_OR_HEAP_ALLOC(ptr, size, HV_DEFAULT_STACKBUF_SIZE)
 #define HV_STACK_FREE(ptr)          STACK_OR_HEAP_FREE(ptr)
 
+// mirrored memory: [ptr, ptr+len) and [ptr+len, ptr+2*len) map the same pages,
+// so data of a ring buffer wrapped around the end is always contiguous.
+// @param len: in: wanted size, out: rounded up to page size
+// @return NULL if not supported (windows) or failed
+HV_EXPORT void* hv_mirror_alloc(size_t* len);
+HV_EXPORT void  hv_mirror_free(void* ptr, size_t len);
+
 HV_EXPORT long hv_alloc_cnt();
 HV_EXPORT long hv_free_cnt();
 HV_INLINE void hv_memcheck(void) {
@@ -5,6 +5,7 @@
 #include "herr.h"
 #include "htime.h"
 #include "hthread.h"
+#include "hatomic.h"
 
 #ifdef OS_DARWIN
 #include <crt_externs.h>
@@ -681,8 +682,15 @@ bool signal_handle_noexit(const char* signal) {
 }
 
 // master-workers processes
+static int      s_worker_proc_idx = 0;
+static hatomic_t s_worker_thread_cnt = HATOMIC_VAR_INIT(0);
+
 static HTHREAD_ROUTINE(worker_thread) {
     hlogi("worker_thread pid=%ld tid=%ld", hv_getpid(), hv_gettid());
+    if (g_main_ctx.worker_cpu_affinity.policy != CPU_AFFINITY_NONE) {
+        int idx = s_worker_proc_idx * g_main_ctx.worker_threads + (int)hatomic_inc(&s_worker_thread_cnt);
+        cpu_affinity_apply(&g_main_ctx.worker_cpu_affinity, idx);
+    }
     if (g_main_ctx.worker_fn) {
         g_main_ctx.worker_fn(g_main_ctx.worker_userdata);
     }
@@ -690,6 +698,8 @@ static HTHREAD_ROUTINE(worker_thread) {
 }
 
 static void worker_init(void* userdata) {
+    proc_ctx_t* ctx = (proc_ctx_t*)userdata;
+    s_worker_proc_idx = ctx - g_main_ctx.proc_ctxs;
 #ifdef OS_UNIX
     setproctitle("%s: worker process", g_main_ctx.program_name);
     signal(SIGNAL_RELOAD, signal_handler);
@@ -718,6 +728,9 @@ int master_workers_run(procedure_t worker_fn, void* worker_userdata,
     g_main_ctx.worker_threads = worker_threads;
     g_main_ctx.worker_fn = worker_fn;
     g_main_ctx.worker_userdata = worker_userdata;
+    if (g_main_ctx.worker_cpu_affinity.policy != CPU_AFFINITY_NONE) {
+        cpu_affinity_report(&g_main_ctx.worker_cpu_affinity, MAX(worker_processes, 1) * worker_threads);
+    }
 
     if (worker_processes == 0) {
         // single process
@@ -748,6 +761,7 @@ int master_workers_run(procedure_t worker_fn, void* worker_userdata,
         proc_ctx_t* ctx = g_main_ctx.proc_ctxs;
         for (int i = 0; i < g_main_ctx.worker_processes; ++i, ++ctx) {
             ctx->init = worker_init;
+            ctx->init_userdata = ctx;
             ctx->proc = worker_proc;
             hproc_spawn(ctx);
             hlogi("workers[%d] start/running, pid=%d", i, ctx->pid);
@@ -5,6 +5,7 @@
 #include "hplatform.h"
 #include "hdef.h"
 #include "hproc.h"
+#include "hsysinfo.h"
 
 #ifdef _MSC_VER
 #pragma comment(lib, "winmm.lib") // for timeSetEvent
@@ -52,6 +53,8 @@ typedef struct main_ctx_s {
     procedure_t     worker_fn;
     void*           worker_userdata;
     proc_ctx_t*     proc_ctxs;
+    // worker[i] = worker_processes[i / worker_threads] worker_threads[i % worker_threads]
+    cpu_affinity_t  worker_cpu_affinity;
 } main_ctx_t;
 
 // arg_type
@@ -111,6 +114,7 @@ HV_EXPORT extern main_ctx_t   g_main_ctx;
 HV_EXPORT extern printf_t     printf_fn;
 
 // master-workers processes
+// NOTE: set g_main_ctx.worker_cpu_affinity to bind workers to cpus, @see cpu_affinity_parse
 HV_EXPORT int master_workers_run(
         procedure_t worker_fn,
         void* worker_userdata DEFAULT(NULL),
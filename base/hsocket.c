@@ -7,6 +7,10 @@
 #include <poll.h>
 #endif
 
+#ifdef OS_LINUX
+#include <linux/filter.h>
+#endif
+
 #ifdef OS_WIN
 #include "hatomic.h"
 static hatomic_flag_t s_wsa_initialized = HATOMIC_FLAG_INIT;
@@ -196,7 +200,7 @@ int sockaddr_compare(const sockaddr_u* addr1, const sockaddr_u* addr2) {
     return memcmp(addr1, addr2, sizeof(sockaddr_u));
 }
 
-static int sockaddr_bind(sockaddr_u* localaddr, int type) {
+static int sockaddr_bind(sockaddr_u* localaddr, int type, int reuseport) {
     // socket -> setsockopt -> bind
 #ifdef SOCK_CLOEXEC
     type |= SOCK_CLOEXEC;
@@ -209,7 +213,9 @@ static int sockaddr_bind(sockaddr_u* localaddr, int type) {
 
 #ifdef OS_UNIX
     so_reuseaddr(sockfd, 1);
-    // so_reuseport(sockfd, 1);
+    if (reuseport) {
+        so_reuseport(sockfd, 1);
+    }
 #endif
 
     if (localaddr->sa.sa_family == AF_INET6) {
@@ -314,7 +320,7 @@ int Bind(int port, const char* host, int type) {
     if (ret != 0) {
         return NABS(ret);
     }
-    return sockaddr_bind(&localaddr, type);
+    return sockaddr_bind(&localaddr, type, 0);
 }
 
 int Listen(int port, const char* host) {
@@ -323,6 +329,37 @@ int Listen(int port, const char* host) {
     return ListenFD(sockfd);
 }
 
+int ListenReusePort(int port, const char* host) {
+#ifdef OS_WIN
+    WSAInit();
+#endif
+    sockaddr_u localaddr;
+    memset(&localaddr, 0, sizeof(localaddr));
+    int ret = sockaddr_set_ipport(&localaddr, host, port);
+    if (ret != 0) {
+        return NABS(ret);
+    }
+    return ListenFD(sockaddr_bind(&localaddr, SOCK_STREAM, 1));
+}
+
+int so_reuseport_steer_by_cpu(int sockfd, int nsockets) {
+#if defined(OS_LINUX) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    if (nsockets <= 0) return -1;
+    // A = cpu % nsockets; return A
+    struct sock_filter code[] = {
+        { BPF_LD  | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)nsockets },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog prog;
+    prog.len = ARRAY_SIZE(code);
+    prog.filter = code;
+    return setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+#else
+    return -1;
+#endif
+}
+
 int Connect(const char* host, int port, int nonblock) {
 #ifdef OS_WIN
     WSAInit();
@@ -358,7 +395,7 @@ int BindUnix(const char* path, int type) {
     sockaddr_u localaddr;
     memset(&localaddr, 0, sizeof(localaddr));
     sockaddr_set_path(&localaddr, path);
-    return sockaddr_bind(&localaddr, type);
+    return sockaddr_bind(&localaddr, type, 0);
 }
 
 int ListenUnix(const char* path) {
@@ -155,6 +155,18 @@ HV_EXPORT int Bind(int port, const char* host DEFAULT(ANYADDR), int type DEFAULT
 // @return listenfd
 HV_EXPORT int Listen(int port, const char* host DEFAULT(ANYADDR));
 
+// Bind with SO_REUSEPORT -> listen
+// NOTE: every socket of the same port must set SO_REUSEPORT,
+// kernel distributes connections between them.
+HV_EXPORT int ListenReusePort(int port, const char* host DEFAULT(ANYADDR));
+
+// Attach a classic BPF program to the SO_REUSEPORT group of sockfd,
+// which selects socket index cpu % nsockets, index is the order of bind.
+// So a connection is accepted by the socket bound by the worker pinned to the cpu
+// which handled its packets.
+// @return 0 on success, -1 if not supported (linux >= 4.5).
+HV_EXPORT int so_reuseport_steer_by_cpu(int sockfd, int nsockets);
+
 // @return connfd
 // ResolveAddr -> socket -> nonblocking -> connect
 HV_EXPORT int Connect(const char* host, int port, int nonblock DEFAULT(0));
@@ -266,6 +278,21 @@ HV_INLINE int so_reuseport(int sockfd, int on DEFAULT(1)) {
 #endif
 }
 
+// NOTE: SO_BUSY_POLL busy poll the device queue in blocking recv/poll for usec,
+// SO_PREFER_BUSY_POLL (linux 5.11+) defer softirq processing while busy polling.
+HV_INLINE int so_busy_poll(int sockfd, int usec, int prefer DEFAULT(1)) {
+    int ret = 0;
+#ifdef SO_BUSY_POLL
+    ret = setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, (const char*)&usec, sizeof(int));
+#endif
+#ifdef SO_PREFER_BUSY_POLL
+    if (ret == 0 && prefer) {
+        setsockopt(sockfd, SOL_SOCKET, SO_PREFER_BUSY_POLL, (const char*)&prefer, sizeof(int));
+    }
+#endif
+    return ret;
+}
+
 HV_INLINE int so_linger(int sockfd, int timeout DEFAULT(1)) {
 #ifdef SO_LINGER
     struct linger linger;
@@ -0,0 +1,281 @@
+#include "hsysinfo.h"
+
+#include "hdef.h"
+#include "hlog.h"
+#include "hthread.h"
+
+#ifdef OS_LINUX
+#include <sched.h>
+#endif
+
+#ifdef OS_LINUX
+// @return bytes read, file content is NULL-terminated
+static int read_sysfs(const char* filepath, char* buf, int len) {
+    FILE* fp = fopen(filepath, "r");
+    if (fp == NULL) return -1;
+    int nread = fread(buf, 1, len - 1, fp);
+    fclose(fp);
+    if (nread < 0) nread = 0;
+    buf[nread] = '\0';
+    return nread;
+}
+#endif
+
+int get_nnode() {
+#ifdef OS_LINUX
+    char buf[256];
+    int nodes[HV_MAX_CPUS];
+    if (read_sysfs("/sys/devices/system/node/online", buf, sizeof(buf)) > 0) {
+        int n = cpulist_parse(buf, nodes, HV_MAX_CPUS);
+        if (n > 0) return nodes[n-1] + 1;
+    }
+#endif
+    return 1;
+}
+
+int get_cpu_node(int cpu) {
+#ifdef OS_LINUX
+    char filepath[64];
+    int nnode = get_nnode();
+    if (nnode <= 1) return 0;
+    for (int node = 0; node < nnode; ++node) {
+        snprintf(filepath, sizeof(filepath), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        if (access(filepath, F_OK) == 0) return node;
+    }
+#endif
+    return 0;
+}
+
+int get_current_cpu() {
+#if defined(OS_LINUX)
+    return sched_getcpu();
+#elif defined(OS_WIN)
+    return GetCurrentProcessorNumber();
+#else
+    return -1;
+#endif
+}
+
+int get_allowed_cpus(int* cpus, int maxcpus) {
+    int ncpus = 0;
+#ifdef OS_LINUX
+    char buf[1024];
+    if (read_sysfs("/sys/devices/system/cpu/online", buf, sizeof(buf)) > 0) {
+        ncpus = cpulist_parse(buf, cpus, maxcpus);
+    }
+#endif
+    if (ncpus <= 0) {
+        ncpus = MIN(get_ncpu(), maxcpus);
+        for (int i = 0; i < ncpus; ++i) {
+            cpus[i] = i;
+        }
+    }
+#ifdef OS_LINUX
+    // NOTE: exclude cpus not allowed by taskset or cgroup cpuset
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        int n = 0;
+        for (int i = 0; i < ncpus; ++i) {
+            if (cpus[i] < CPU_SETSIZE && CPU_ISSET(cpus[i], &mask)) {
+                cpus[n++] = cpus[i];
+            }
+        }
+        if (n > 0) ncpus = n;
+    }
+#endif
+    return ncpus;
+}
+
+int cpulist_parse(const char* str, int* cpus, int maxcpus) {
+    if (str == NULL) return -1;
+    int ncpus = 0;
+    const char* p = str;
+    while (*p) {
+        while (*p == ' ' || *p == ',' || *p == '\n') ++p;
+        if (*p == '\0') break;
+        if (!IS_DIGIT(*p)) return -1;
+        int first = strtol(p, (char**)&p, 10);
+        int last = first;
+        if (*p == '-') {
+            ++p;
+            if (!IS_DIGIT(*p)) return -1;
+            last = strtol(p, (char**)&p, 10);
+        }
+        if (last < first) return -1;
+        for (int cpu = first; cpu <= last && ncpus < maxcpus; ++cpu) {
+            cpus[ncpus++] = cpu;
+        }
+    }
+    return ncpus;
+}
+
+char* cpulist_dump(const int* cpus, int ncpus, char* buf, int len) {
+    int off = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < ncpus && off < len; ++i) {
+        int j = i;
+        while (j + 1 < ncpus && cpus[j+1] == cpus[j] + 1) ++j;
+        if (j == i) {
+            off += snprintf(buf + off, len - off, "%s%d", off ? "," : "", cpus[i]);
+        } else {
+            off += snprintf(buf + off, len - off, "%s%d-%d", off ? "," : "", cpus[i], cpus[j]);
+        }
+        i = j;
+    }
+    return buf;
+}
+
+int hv_setaffinity(const int* cpus, int ncpus) {
+    if (ncpus <= 0) return -1;
+#if defined(OS_LINUX)
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int i = 0; i < ncpus; ++i) {
+        if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &mask);
+        }
+    }
+    return sched_setaffinity(0, sizeof(mask), &mask);
+#elif defined(OS_WIN)
+    DWORD_PTR mask = 0;
+    for (int i = 0; i < ncpus; ++i) {
+        if (cpus[i] >= 0 && cpus[i] < (int)(sizeof(mask) * 8)) {
+            mask |= (DWORD_PTR)1 << cpus[i];
+        }
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) ? 0 : -1;
+#else
+    // NOTE: macOS has no hard cpu affinity
+    return -1;
+#endif
+}
+
+int cpu_affinity_parse(cpu_affinity_t* affinity, const char* str) {
+    memset(affinity, 0, sizeof(cpu_affinity_t));
+    if (str == NULL || *str == '\0' || strcmp(str, "none") == 0) {
+        affinity->policy = CPU_AFFINITY_NONE;
+    } else if (strcmp(str, "compact") == 0) {
+        affinity->policy = CPU_AFFINITY_COMPACT;
+    } else if (strcmp(str, "scatter") == 0) {
+        affinity->policy = CPU_AFFINITY_SCATTER;
+    } else if (strcmp(str, "node") == 0) {
+        affinity->policy = CPU_AFFINITY_NODE;
+    } else {
+        int cpus[HV_MAX_CPUS];
+        if (cpulist_parse(str, cpus, HV_MAX_CPUS) <= 0) return -1;
+        affinity->policy = CPU_AFFINITY_CPULIST;
+        strncpy(affinity->cpulist, str, sizeof(affinity->cpulist) - 1);
+    }
+    return 0;
+}
+
+const char* cpu_affinity_str(const cpu_affinity_t* affinity) {
+    switch (affinity->policy) {
+    case CPU_AFFINITY_COMPACT:  return "compact";
+    case CPU_AFFINITY_SCATTER:  return "scatter";
+    case CPU_AFFINITY_NODE:     return "node";
+    case CPU_AFFINITY_CPULIST:  return affinity->cpulist;
+    default:                    return "none";
+    }
+}
+
+typedef struct cpu_node_s {
+    int cpu;
+    int node;
+} cpu_node_t;
+
+static int cpu_node_cmp(const void* lhs, const void* rhs) {
+    const cpu_node_t* a = (const cpu_node_t*)lhs;
+    const cpu_node_t* b = (const cpu_node_t*)rhs;
+    if (a->node != b->node) return a->node - b->node;
+    return a->cpu - b->cpu;
+}
+
+int cpu_affinity_select(const cpu_affinity_t* affinity, int idx, int* cpus, int maxcpus) {
+    if (affinity == NULL || idx < 0 || maxcpus <= 0) return 0;
+    if (affinity->policy == CPU_AFFINITY_NONE) return 0;
+    int allowed[HV_MAX_CPUS];
+    if (affinity->policy == CPU_AFFINITY_CPULIST) {
+        int n = cpulist_parse(affinity->cpulist, allowed, HV_MAX_CPUS);
+        if (n <= 0) return 0;
+        cpus[0] = allowed[idx % n];
+        return 1;
+    }
+
+    int n = get_allowed_cpus(allowed, HV_MAX_CPUS);
+    if (n <= 0) return 0;
+    cpu_node_t topo[HV_MAX_CPUS];
+    for (int i = 0; i < n; ++i) {
+        topo[i].cpu = allowed[i];
+        topo[i].node = get_cpu_node(allowed[i]);
+    }
+    qsort(topo, n, sizeof(cpu_node_t), cpu_node_cmp);
+    if (affinity->policy == CPU_AFFINITY_COMPACT) {
+        cpus[0] = topo[idx % n].cpu;
+        return 1;
+    }
+
+    // nodes which have allowed cpus: topo[node_start[k], node_start[k+1])
+    int nnode = 0;
+    int node_start[HV_MAX_CPUS + 1];
+    for (int i = 0; i < n; ++i) {
+        if (i == 0 || topo[i].node != topo[i-1].node) {
+            node_start[nnode++] = i;
+        }
+    }
+    node_start[nnode] = n;
+    int k = idx % nnode;
+    int count = node_start[k+1] - node_start[k];
+    if (affinity->policy == CPU_AFFINITY_SCATTER) {
+        cpus[0] = topo[node_start[k] + (idx / nnode) % count].cpu;
+        return 1;
+    }
+    // CPU_AFFINITY_NODE
+    int ncpus = MIN(count, maxcpus);
+    for (int i = 0; i < ncpus; ++i) {
+        cpus[i] = topo[node_start[k] + i].cpu;
+    }
+    return ncpus;
+}
+
+int cpu_affinity_apply(const cpu_affinity_t* affinity, int idx) {
+    int cpus[HV_MAX_CPUS];
+    int ncpus = cpu_affinity_select(affinity, idx, cpus, HV_MAX_CPUS);
+    if (ncpus <= 0) return -1;
+    char buf[256];
+    cpulist_dump(cpus, ncpus, buf, sizeof(buf));
+    if (hv_setaffinity(cpus, ncpus) != 0) {
+        hlogw("worker[%d] pid=%ld tid=%ld bind cpus=%s failed!", idx, hv_getpid(), hv_gettid(), buf);
+        return -1;
+    }
+    int node = get_cpu_node(cpus[0]);
+    hlogi("worker[%d] pid=%ld tid=%ld bind cpus=%s node=%d", idx, hv_getpid(), hv_gettid(), buf, node);
+    return node;
+}
+
+void cpu_affinity_report(const cpu_affinity_t* affinity, int nworkers) {
+    int allowed[HV_MAX_CPUS];
+    int n = get_allowed_cpus(allowed, HV_MAX_CPUS);
+    int nnode = get_nnode();
+    char buf[256];
+    hlogi("cpu topology: ncpu=%d allowed=%s nnode=%d", get_ncpu(), cpulist_dump(allowed, n, buf, sizeof(buf)), nnode);
+    int cpus[HV_MAX_CPUS];
+    for (int node = 0; node < nnode; ++node) {
+        int ncpus = 0;
+        for (int i = 0; i < n; ++i) {
+            if (get_cpu_node(allowed[i]) == node) {
+                cpus[ncpus++] = allowed[i];
+            }
+        }
+        if (ncpus) {
+            hlogi("node%d: cpus=%s", node, cpulist_dump(cpus, ncpus, buf, sizeof(buf)));
+        }
+    }
+    hlogi("cpu affinity: %s workers=%d", cpu_affinity_str(affinity), nworkers);
+    for (int i = 0; i < nworkers; ++i) {
+        int ncpus = cpu_affinity_select(affinity, i, cpus, HV_MAX_CPUS);
+        if (ncpus <= 0) break;
+        hlogi("worker[%d] => cpus=%s node=%d", i, cpulist_dump(cpus, ncpus, buf, sizeof(buf)), get_cpu_node(cpus[0]));
+    }
+}
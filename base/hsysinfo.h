@@ -1,6 +1,7 @@
 #ifndef HV_SYS_INFO_H_
 #define HV_SYS_INFO_H_
 
+#include "hexport.h"
 #include "hplatform.h"
 
 #ifdef OS_LINUX
@@ -65,4 +66,59 @@ static inline int get_meminfo(meminfo_t* mem) {
 #endif
 }
 
+//-----------------------------cpu topology------------------------------------
+BEGIN_EXTERN_C
+
+#define HV_MAX_CPUS     1024
+
+// @return numa nodes, 1 if unknown
+HV_EXPORT int get_nnode();
+// @return numa node of cpu, 0 if unknown
+HV_EXPORT int get_cpu_node(int cpu);
+// @return cpu of current thread, -1 if unknown
+HV_EXPORT int get_current_cpu();
+// online cpus allowed to this process
+// @return ncpus
+HV_EXPORT int get_allowed_cpus(int* cpus, int maxcpus);
+
+// "0-3,8,10-11" => [0,1,2,3,8,10,11]
+// @return ncpus, <0 if invalid
+HV_EXPORT int cpulist_parse(const char* str, int* cpus, int maxcpus);
+// [0,1,2,3,8] => "0-3,8"
+HV_EXPORT char* cpulist_dump(const int* cpus, int ncpus, char* buf, int len);
+
+// bind current thread to cpus
+// @return 0 on success, -1 if failed or not supported
+HV_EXPORT int hv_setaffinity(const int* cpus, int ncpus);
+
+typedef enum {
+    CPU_AFFINITY_NONE = 0,
+    CPU_AFFINITY_COMPACT,   // worker[i] => i-th cpu ordered by node, fill node by node
+    CPU_AFFINITY_SCATTER,   // worker[i] => a cpu of node[i % nnode], spread across nodes
+    CPU_AFFINITY_NODE,      // worker[i] => all cpus of node[i % nnode]
+    CPU_AFFINITY_CPULIST,   // worker[i] => cpulist[i % ncpus]
+} cpu_affinity_e;
+
+typedef struct cpu_affinity_s {
+    cpu_affinity_e  policy;
+    char            cpulist[256]; // for CPU_AFFINITY_CPULIST
+} cpu_affinity_t;
+
+// "none", "compact", "scatter", "node", "0-3,8"
+// @return 0 on success
+HV_EXPORT int cpu_affinity_parse(cpu_affinity_t* affinity, const char* str);
+HV_EXPORT const char* cpu_affinity_str(const cpu_affinity_t* affinity);
+// cpus of worker[idx]
+// @return ncpus, 0 if CPU_AFFINITY_NONE
+HV_EXPORT int cpu_affinity_select(const cpu_affinity_t* affinity, int idx, int* cpus, int maxcpus);
+// cpu_affinity_select -> hv_setaffinity
+// NOTE: call it at the beginning of worker thread, before allocating per-thread memory,
+// then the memory will be allocated on the node of the worker on first touch.
+// @return numa node of worker[idx], -1 if not bound
+HV_EXPORT int cpu_affinity_apply(const cpu_affinity_t* affinity, int idx);
+// log cpu topology and the cpus of nworkers
+HV_EXPORT void cpu_affinity_report(const cpu_affinity_t* affinity, int nworkers);
+
+END_EXTERN_C
+
 #endif // HV_SYS_INFO_H_
@@ -44,6 +44,8 @@ set(CPPUTIL_HEADERS
     cpputil/hurl.h
     cpputil/hscope.h
     cpputil/hthreadpool.h
+    cpputil/hworkstealingpool.h
+    cpputil/hconsistenthash.h
     cpputil/hasync.h
     cpputil/hobjectpool.h
     cpputil/ifconfig.h
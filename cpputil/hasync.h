@@ -2,15 +2,17 @@
 #define HV_ASYNC_H_
 
 #include "hexport.h"
-#include "hthreadpool.h"
+#include "hworkstealingpool.h"
 #include "singleton.h"
 
 namespace hv {
 
-class HV_EXPORT GlobalThreadPool : public HThreadPool {
+// NOTE: committed by io loops and http async handlers concurrently,
+// so use work-stealing pool instead of HThreadPool with one task queue.
+class HV_EXPORT GlobalThreadPool : public HWorkStealingPool {
     SINGLETON_DECL(GlobalThreadPool)
 protected:
-    GlobalThreadPool() : HThreadPool() {}
+    GlobalThreadPool() : HWorkStealingPool() {}
     ~GlobalThreadPool() {}
 };
 
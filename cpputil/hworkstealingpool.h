@@ -0,0 +1,514 @@
+#ifndef HV_WORK_STEALING_POOL_H_
+#define HV_WORK_STEALING_POOL_H_
+
+/*
+ * @usage unittest/threadpool_test.cpp
+ *
+ * Same interface as HThreadPool, but without a global task queue:
+ * - each worker owns a Chase-Lev deque, tasks committed by a worker are pushed to its own deque (LIFO),
+ * - tasks committed by other threads (e.g. io loops) are pushed to the inbox of a paired worker,
+ * - idle workers steal from others (FIFO) starting at a random victim.
+ */
+
+#include <time.h>
+#include <stdint.h>
+#include <thread>
+#include <list>
+#include <deque>
+#include <vector>
+#include <random>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <utility>
+#include <chrono>
+
+#include "hthreadpool.h" // for DEFAULT_THREAD_POOL_*
+
+// Chase-Lev work-stealing deque, @see "Correct and Efficient Work-Stealing for Weak Memory Models"
+// NOTE: push/pop only by owner, steal by any thread.
+template<typename T>
+class HWorkStealingDeque {
+public:
+    HWorkStealingDeque(int64_t capacity = 256) : top(0), bottom(0) {
+        Array* a = new Array(capacity);
+        array.store(a, std::memory_order_relaxed);
+        garbage.emplace_back(a);
+    }
+
+    int64_t size() const {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void push(T x) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = a->grow(b, t);
+            // NOTE: thieves may still read the old array, free it in destructor.
+            garbage.emplace_back(a);
+            array.store(a, std::memory_order_release);
+        }
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // @return T() if empty
+    T pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        T x = T();
+        if (t <= b) {
+            x = a->get(b);
+            if (t == b) {
+                // last one, race with thieves
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    x = T();
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return x;
+    }
+
+    // @return T() if empty or lost the race
+    T steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        T x = T();
+        if (t < b) {
+            Array* a = array.load(std::memory_order_acquire);
+            x = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return T();
+            }
+        }
+        return x;
+    }
+
+private:
+    struct Array {
+        int64_t capacity; // power of 2
+        std::unique_ptr<std::atomic<T>[]> buf;
+
+        explicit Array(int64_t cap) : capacity(cap), buf(new std::atomic<T>[cap]) {}
+
+        T get(int64_t i) {
+            return buf[i & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t i, T x) {
+            buf[i & (capacity - 1)].store(x, std::memory_order_relaxed);
+        }
+
+        Array* grow(int64_t b, int64_t t) {
+            Array* a = new Array(capacity * 2);
+            for (int64_t i = t; i < b; ++i) {
+                a->put(i, get(i));
+            }
+            return a;
+        }
+    };
+
+    std::atomic<int64_t>    top;
+    std::atomic<int64_t>    bottom;
+    std::atomic<Array*>     array;
+    std::vector<std::unique_ptr<Array>> garbage;
+};
+
+class HWorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    HWorkStealingPool(int min_threads = DEFAULT_THREAD_POOL_MIN_THREAD_NUM,
+                      int max_threads = DEFAULT_THREAD_POOL_MAX_THREAD_NUM,
+                      int max_idle_ms = DEFAULT_THREAD_POOL_MAX_IDLE_TIME)
+        : min_thread_num(min_threads)
+        , max_thread_num(max_threads)
+        , max_idle_time(max_idle_ms)
+        , status(STOP)
+        , cur_thread_num(0)
+        , idle_thread_num(0)
+        , task_num(0)
+        , sleeping_num(0)
+        , next_pair_idx(0)
+    {}
+
+    virtual ~HWorkStealingPool() {
+        stop();
+    }
+
+    void setMinThreadNum(int min_threads) {
+        min_thread_num = min_threads;
+    }
+    void setMaxThreadNum(int max_threads) {
+        max_thread_num = max_threads;
+    }
+    void setMaxIdleTime(int ms) {
+        max_idle_time = ms;
+    }
+    int currentThreadNum() {
+        return cur_thread_num;
+    }
+    int idleThreadNum() {
+        return idle_thread_num;
+    }
+    size_t taskNum() {
+        return task_num;
+    }
+    bool isStarted() {
+        return status != STOP;
+    }
+    bool isStopped() {
+        return status == STOP;
+    }
+
+    int start(int start_threads = 0) {
+        // NOTE: commit may start concurrently, only one thread builds workers, others wait it done.
+        Status expected = STOP;
+        if (!status.compare_exchange_strong(expected, STARTING)) {
+            while (status == STARTING) {
+                std::this_thread::yield();
+            }
+            return -1;
+        }
+        // NOTE: max_thread_num is fixed after start, workers are slots of deques.
+        if (max_thread_num < 1) max_thread_num = 1;
+        workers.clear();
+        for (int i = 0; i < max_thread_num; ++i) {
+            workers.emplace_back(new Worker);
+        }
+        status = RUNNING;
+        if (start_threads < min_thread_num) start_threads = min_thread_num;
+        if (start_threads > max_thread_num) start_threads = max_thread_num;
+        for (int i = 0; i < start_threads; ++i) {
+            createThread();
+        }
+        return 0;
+    }
+
+    int stop() {
+        while (status == STARTING) {
+            std::this_thread::yield();
+        }
+        if (status == STOP) return -1;
+        {
+            std::lock_guard<std::mutex> locker(sleep_mutex);
+            status = STOP;
+        }
+        sleep_cond.notify_all();
+        thread_mutex.lock();
+        std::list<ThreadData> stopped;
+        stopped.swap(threads);
+        thread_mutex.unlock();
+        for (auto& i : stopped) {
+            if (i.thread->joinable()) {
+                i.thread->join();
+            }
+        }
+        // drop tasks not run
+        for (auto& worker : workers) {
+            while (Task* task = worker->deque.steal()) delete task;
+            for (Task* task : worker->inbox) delete task;
+            worker->inbox.clear();
+        }
+        workers.clear();
+        cur_thread_num = 0;
+        idle_thread_num = 0;
+        task_num = 0;
+        return 0;
+    }
+
+    int pause() {
+        if (status == RUNNING) {
+            status = PAUSE;
+        }
+        return 0;
+    }
+
+    int resume() {
+        if (status == PAUSE) {
+            status = RUNNING;
+        }
+        return 0;
+    }
+
+    int wait() {
+        while (status != STOP) {
+            if (task_num == 0 && idle_thread_num == cur_thread_num) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        return 0;
+    }
+
+    /*
+     * return a future, calling future.get() will wait task done and return RetType.
+     * commit(fn, args...)
+     * commit(std::bind(&Class::mem_fn, &obj))
+     * commit(std::mem_fn(&Class::mem_fn, &obj))
+     *
+     */
+    template<class Fn, class... Args>
+    auto commit(Fn&& fn, Args&&... args) -> std::future<decltype(fn(args...))> {
+        if (status == STOP || status == STARTING) start();
+        if (idle_thread_num <= (int)task_num && cur_thread_num < max_thread_num) {
+            createThread();
+        }
+        using RetType = decltype(fn(args...));
+        auto task = std::make_shared<std::packaged_task<RetType()> >(
+            std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...));
+        std::future<RetType> future = task->get_future();
+        push(new Task([task]{
+            (*task)();
+        }));
+        return future;
+    }
+
+protected:
+    struct Worker {
+        HWorkStealingDeque<Task*>   deque;  // pushed by owner
+        std::deque<Task*>           inbox;  // pushed by other threads
+        std::mutex                  inbox_mutex;
+        std::atomic<int>            inbox_size;
+        std::atomic<bool>           active;
+
+        Worker() : inbox_size(0), active(false) {}
+    };
+
+    // NOTE: a worker of one pool may commit into another pool,
+    // so the worker index and the pairing are kept for different pools.
+    struct LocalContext {
+        HWorkStealingPool*  pool;           // pool this thread is a worker of
+        int                 idx;            // worker index in pool, -1 if not a worker
+        HWorkStealingPool*  paired_pool;    // pool this thread last committed into as a non-worker
+        int                 paired;         // worker index in paired_pool paired with this thread
+    };
+
+    static LocalContext& localContext() {
+        static thread_local LocalContext ctx = { NULL, -1, NULL, -1 };
+        return ctx;
+    }
+
+    void push(Task* task) {
+        ++task_num;
+        LocalContext& ctx = localContext();
+        if (ctx.pool == this && ctx.idx >= 0) {
+            workers[ctx.idx]->deque.push(task);
+        } else {
+            // NOTE: one paired worker per committing thread for locality, others steal if it is busy.
+            if (ctx.paired_pool != this) {
+                ctx.paired_pool = this;
+                ctx.paired = -1;
+            }
+            if (ctx.paired < 0 || ctx.paired >= (int)workers.size() || !workers[ctx.paired]->active) {
+                ctx.paired = pairWorker();
+            }
+            if (ctx.paired < 0) {
+                // stopped, no worker to run it
+                --task_num;
+                delete task;
+                return;
+            }
+            Worker* worker = workers[ctx.paired].get();
+            std::lock_guard<std::mutex> locker(worker->inbox_mutex);
+            worker->inbox.push_back(task);
+            ++worker->inbox_size;
+        }
+        if (sleeping_num > 0) {
+            // NOTE: lock to avoid lost wakeup, @see waitTask
+            { std::lock_guard<std::mutex> locker(sleep_mutex); }
+            sleep_cond.notify_one();
+        }
+    }
+
+    // @return -1 if no workers
+    int pairWorker() {
+        int n = (int)workers.size();
+        if (n == 0) return -1;
+        int start = next_pair_idx++ % n;
+        for (int i = 0; i < n; ++i) {
+            int idx = (start + i) % n;
+            if (workers[idx]->active) return idx;
+        }
+        return start;
+    }
+
+    Task* popInbox(Worker* worker) {
+        if (worker->inbox_size == 0) return NULL;
+        std::lock_guard<std::mutex> locker(worker->inbox_mutex);
+        if (worker->inbox.empty()) return NULL;
+        Task* task = worker->inbox.front();
+        worker->inbox.pop_front();
+        --worker->inbox_size;
+        return task;
+    }
+
+    Task* getTask(int idx, std::minstd_rand& rng) {
+        Worker* self = workers[idx].get();
+        Task* task = self->deque.pop();
+        if (task) return task;
+        task = popInbox(self);
+        if (task) return task;
+        // steal from a random victim
+        int n = (int)workers.size();
+        int start = (int)(rng() % n);
+        for (int i = 0; i < n; ++i) {
+            int victim = (start + i) % n;
+            if (victim == idx) continue;
+            Worker* worker = workers[victim].get();
+            task = worker->deque.steal();
+            if (task) return task;
+            task = popInbox(worker);
+            if (task) return task;
+        }
+        return NULL;
+    }
+
+    // @return false if timeout
+    bool waitTask() {
+        std::unique_lock<std::mutex> locker(sleep_mutex);
+        ++sleeping_num;
+        bool ok = sleep_cond.wait_for(locker, std::chrono::milliseconds(max_idle_time), [this]() {
+            return status == STOP || task_num > 0;
+        });
+        --sleeping_num;
+        return ok;
+    }
+
+    bool createThread() {
+        std::lock_guard<std::mutex> locker(thread_mutex);
+        if (status == STOP || cur_thread_num >= max_thread_num) return false;
+        int idx = -1;
+        for (int i = 0; i < (int)workers.size(); ++i) {
+            if (!workers[i]->active) {
+                idx = i;
+                break;
+            }
+        }
+        if (idx < 0) return false;
+        workers[idx]->active = true;
+        std::thread* thread = new std::thread([this, idx] {
+            LocalContext& ctx = localContext();
+            ctx.pool = this;
+            ctx.idx = idx;
+            std::minstd_rand rng((unsigned)std::hash<std::thread::id>()(std::this_thread::get_id()));
+            const int spin_rounds = 64;
+            int spins = 0;
+            while (status != STOP) {
+                while (status == PAUSE) {
+                    std::this_thread::yield();
+                }
+                Task* task = getTask(idx, rng);
+                if (task) {
+                    --task_num;
+                    --idle_thread_num;
+                    (*task)();
+                    delete task;
+                    ++idle_thread_num;
+                    spins = 0;
+                    continue;
+                }
+                if (++spins < spin_rounds) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                spins = 0;
+                if (!waitTask() && task_num == 0) {
+                    // no task in max_idle_time, close this thread
+                    if (delThread(idx)) return;
+                }
+            }
+        });
+        ++cur_thread_num;
+        ++idle_thread_num;
+        ThreadData data;
+        data.thread = std::shared_ptr<std::thread>(thread);
+        data.id = thread->get_id();
+        data.status = RUNNING;
+        data.start_time = time(NULL);
+        data.stop_time = 0;
+        threads.emplace_back(data);
+        return true;
+    }
+
+    // @return false if cur_thread_num <= min_thread_num
+    bool delThread(int idx) {
+        std::thread::id id = std::this_thread::get_id();
+        time_t now = time(NULL);
+        std::lock_guard<std::mutex> locker(thread_mutex);
+        if (status == STOP || cur_thread_num <= min_thread_num) return false;
+        // NOTE: tasks still in deque will be stolen by others.
+        --cur_thread_num;
+        --idle_thread_num;
+        auto iter = threads.begin();
+        while (iter != threads.end()) {
+            // join threads marked stopped
+            if (iter->status == STOP && now > iter->stop_time) {
+                if (iter->thread->joinable()) {
+                    iter->thread->join();
+                    iter = threads.erase(iter);
+                    continue;
+                }
+            } else if (iter->id == id) {
+                iter->status = STOP;
+                iter->stop_time = now;
+            }
+            ++iter;
+        }
+        workers[idx]->active = false;
+        return true;
+    }
+
+public:
+    int min_thread_num;
+    int max_thread_num;
+    int max_idle_time;
+
+protected:
+    enum Status {
+        STOP,
+        STARTING,
+        RUNNING,
+        PAUSE,
+    };
+    struct ThreadData {
+        std::shared_ptr<std::thread> thread;
+        std::thread::id id;
+        Status          status;
+        time_t          start_time;
+        time_t          stop_time;
+    };
+    std::atomic<Status>     status;
+    std::atomic<int>        cur_thread_num;
+    std::atomic<int>        idle_thread_num;
+    std::list<ThreadData>   threads;
+    std::mutex              thread_mutex;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<int64_t>    task_num;
+    std::atomic<int>        sleeping_num;
+    std::atomic<unsigned>   next_pair_idx;
+    std::mutex              sleep_mutex;
+    std::condition_variable sleep_cond;
+};
+
+#endif // HV_WORK_STEALING_POOL_H_
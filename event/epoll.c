@@ -17,10 +17,13 @@ typedef int     epoll_handle_t;
 #include "array.h"
 #define EVENTS_INIT_SIZE    64
 ARRAY_DECL(struct epoll_event, events);
+ARRAY_DECL(int, fds);
 
 typedef struct epoll_ctx_s {
     epoll_handle_t      epfd;
     struct events       events;
+    // HLOOP_FLAG_EDGE_TRIGGERED: fds with io->ready_events
+    struct fds          readyfds;
 } epoll_ctx_t;
 
 int iowatcher_init(hloop_t* loop) {
@@ -29,6 +32,7 @@ int iowatcher_init(hloop_t* loop) {
     HV_ALLOC_SIZEOF(epoll_ctx);
     epoll_ctx->epfd = epoll_create(EVENTS_INIT_SIZE);
     events_init(&epoll_ctx->events, EVENTS_INIT_SIZE);
+    fds_init(&epoll_ctx->readyfds, EVENTS_INIT_SIZE);
     loop->iowatcher = epoll_ctx;
     return 0;
 }
@@ -38,6 +42,7 @@ int iowatcher_cleanup(hloop_t* loop) {
     epoll_ctx_t* epoll_ctx = (epoll_ctx_t*)loop->iowatcher;
     epoll_close(epoll_ctx->epfd);
     events_cleanup(&epoll_ctx->events);
+    fds_cleanup(&epoll_ctx->readyfds);
     HV_FREE(loop->iowatcher);
     return 0;
 }
@@ -52,6 +57,25 @@ int iowatcher_add_event(hloop_t* loop, int fd, int events) {
     struct epoll_event ee;
     memset(&ee, 0, sizeof(ee));
     ee.data.fd = fd;
+#ifdef OS_LINUX
+    if (iowatcher_edge_triggered(loop)) {
+        // NOTE: register once, no epoll_ctl until all events deleted.
+        if (io->events == 0) {
+            ee.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            epoll_ctl(epoll_ctx->epfd, EPOLL_CTL_ADD, fd, &ee);
+            if (epoll_ctx->events.size == epoll_ctx->events.maxsize) {
+                events_double_resize(&epoll_ctx->events);
+            }
+            epoll_ctx->events.size++;
+        }
+        else if ((events & HV_READ) && !(io->events & HV_READ)) {
+            // NOTE: read maybe stopped before drained, no more edge for data in buffer.
+            // HV_WRITE is added only after EAGAIN or short write, so wait for edge.
+            iowatcher_set_ready(loop, fd, HV_READ);
+        }
+        return 0;
+    }
+#endif
     // pre events
     if (io->events & HV_READ) {
         ee.events |= EPOLLIN;
@@ -85,6 +109,16 @@ int iowatcher_del_event(hloop_t* loop, int fd, int events) {
     struct epoll_event ee;
     memset(&ee, 0, sizeof(ee));
     ee.data.fd = fd;
+#ifdef OS_LINUX
+    if (iowatcher_edge_triggered(loop)) {
+        io->ready_events &= ~events;
+        if ((io->events & ~events) == 0) {
+            epoll_ctl(epoll_ctx->epfd, EPOLL_CTL_DEL, fd, &ee);
+            epoll_ctx->events.size--;
+        }
+        return 0;
+    }
+#endif
     // pre events
     if (io->events & HV_READ) {
         ee.events |= EPOLLIN;
@@ -107,19 +141,59 @@ int iowatcher_del_event(hloop_t* loop, int fd, int events) {
     return 0;
 }
 
+#ifdef OS_LINUX
+int iowatcher_set_ready(hloop_t* loop, int fd, int events) {
+    epoll_ctx_t* epoll_ctx = (epoll_ctx_t*)loop->iowatcher;
+    if (epoll_ctx == NULL) return -1;
+    hio_t* io = loop->ios.ptr[fd];
+    if (io->ready_events == 0) {
+        if (epoll_ctx->readyfds.size == epoll_ctx->readyfds.maxsize) {
+            fds_double_resize(&epoll_ctx->readyfds);
+        }
+        epoll_ctx->readyfds.ptr[epoll_ctx->readyfds.size++] = fd;
+    }
+    io->ready_events |= events;
+    return 0;
+}
+
+static int iowatcher_pending_ready(hloop_t* loop, epoll_ctx_t* epoll_ctx) {
+    int nevents = 0;
+    for (int i = 0; i < epoll_ctx->readyfds.size; ++i) {
+        hio_t* io = loop->ios.ptr[epoll_ctx->readyfds.ptr[i]];
+        // NOTE: fd maybe closed and reused
+        if (io && (io->ready_events & io->events)) {
+            io->revents |= io->ready_events & io->events;
+            EVENT_PENDING(io);
+            ++nevents;
+        }
+        if (io) io->ready_events = 0;
+    }
+    epoll_ctx->readyfds.size = 0;
+    return nevents;
+}
+#endif
+
 int iowatcher_poll_events(hloop_t* loop, int timeout) {
     epoll_ctx_t* epoll_ctx = (epoll_ctx_t*)loop->iowatcher;
     if (epoll_ctx == NULL)  return 0;
-    if (epoll_ctx->events.size == 0) return 0;
+    int nready = 0;
+#ifdef OS_LINUX
+    if (epoll_ctx->readyfds.size) {
+        // NOTE: no wait, handle ready events after polling new events.
+        timeout = 0;
+        nready = iowatcher_pending_ready(loop, epoll_ctx);
+    }
+#endif
+    if (epoll_ctx->events.size == 0) return nready;
     int nepoll = epoll_wait(epoll_ctx->epfd, epoll_ctx->events.ptr, epoll_ctx->events.size, timeout);
     if (nepoll < 0) {
         if (errno == EINTR) {
-            return 0;
+            return nready;
         }
         perror("epoll");
         return nepoll;
     }
-    if (nepoll == 0) return 0;
+    if (nepoll == 0) return nready;
     int nevents = 0;
     for (int i = 0; i < epoll_ctx->events.size; ++i) {
         struct epoll_event* ee = epoll_ctx->events.ptr + i;
@@ -129,9 +203,15 @@ int iowatcher_poll_events(hloop_t* loop, int timeout) {
             ++nevents;
             hio_t* io = loop->ios.ptr[fd];
             if (io) {
-                if (revents & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                if (revents & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
                     io->revents |= HV_READ;
                 }
+#ifdef OS_LINUX
+                // NOTE: FIN maybe queued with data, no more edge after a short read, @see nio_read
+                if (revents & EPOLLRDHUP) {
+                    io->rdhup = 1;
+                }
+#endif
                 if (revents & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
                     io->revents |= HV_WRITE;
                 }
@@ -140,6 +220,6 @@ int iowatcher_poll_events(hloop_t* loop, int timeout) {
         }
         if (nevents == nepoll) break;
     }
-    return nevents;
+    return nevents + nready;
 }
 #endif
@@ -5,6 +5,9 @@
 #include "herr.h"
 
 #include "unpack.h"
+#ifdef EVENT_IO_URING
+#include "uringio.h"
+#endif
 
 uint64_t hloop_next_event_id() {
     static hatomic_t s_id = HATOMIC_VAR_INIT(0);
@@ -89,52 +92,50 @@ void hio_ready(hio_t* io) {
     io->recv = io->send = 0;
     io->recvfrom = io->sendto = 0;
     io->close = 0;
+    io->rdhup = 0;
+    io->migrating = 0;
+    io->over_high_water = 0;
+    io->upstream_water = 0;
+    io->splice = io->splice_eof = 0;
+    io->ktls_tx = io->ktls_rx = 0;
     // public:
     io->id = hio_next_id();
     io->io_type = HIO_TYPE_UNKNOWN;
     io->error = 0;
     io->events = io->revents = 0;
+    io->ready_events = 0;
     io->last_read_hrtime = io->last_write_hrtime = io->loop->cur_hrtime;
     // readbuf
     io->alloced_readbuf = 0;
+    io->mirror_readbuf = 0;
     hio_use_loop_readbuf(io);
     io->readbuf.head = io->readbuf.tail = 0;
     io->read_flags = 0;
     io->read_until_length = 0;
     io->max_read_bufsize = MAX_READ_BUFSIZE;
     io->small_readbytes_cnt = 0;
+    io->read_batch = 0;
+    io->event_cnt = 0;
+    io->udp_gro = io->udp_gso = 0;
     // write_queue
     io->write_bufsize = 0;
+    io->sendfile_bufsize = 0;
     io->max_write_bufsize = MAX_WRITE_BUFSIZE;
+    io->zerocopy_bufsize = 0;
+    io->zerocopy_threshold = 0;
+    io->zerocopy_seq = io->zerocopy_done = 0;
     // callbacks
     io->read_cb = NULL;
+    io->read_batch_cb = NULL;
     io->write_cb = NULL;
     io->close_cb = NULL;
     io->accept_cb = NULL;
     io->connect_cb = NULL;
-    // timers
-    io->connect_timeout = 0;
-    io->connect_timer = NULL;
-    io->close_timeout = 0;
-    io->close_timer = NULL;
-    io->read_timeout = 0;
-    io->read_timer = NULL;
-    io->write_timeout = 0;
-    io->write_timer = NULL;
-    io->keepalive_timeout = 0;
-    io->keepalive_timer = NULL;
-    io->heartbeat_interval = 0;
-    io->heartbeat_fn = NULL;
-    io->heartbeat_timer = NULL;
-    // upstream
-    io->upstream_io = NULL;
-    // unpack
-    io->unpack_setting = NULL;
-    // ssl
-    io->ssl = NULL;
-    io->ssl_ctx = NULL;
+    // timers, upstream, unpack, ssl
+    if (io->ext) {
+        memset(io->ext, 0, sizeof(hio_ext_t));
+    }
     io->alloced_ssl_ctx = 0;
-    io->hostname = NULL;
     // context
     io->ctx = NULL;
     // private:
@@ -144,6 +145,9 @@ void hio_ready(hio_t* io) {
 #ifdef EVENT_IOCP
     io->hovlp = NULL;
 #endif
+#ifdef EVENT_IO_URING
+    io->uring_rop = io->uring_wop = NULL;
+#endif
 
     // io_type
     fill_io_type(io);
@@ -153,7 +157,7 @@ void hio_ready(hio_t* io) {
 
 #if WITH_RUDP
     if ((io->io_type & HIO_TYPE_SOCK_DGRAM) || (io->io_type & HIO_TYPE_SOCK_RAW)) {
-        rudp_init(&io->rudp);
+        rudp_init(&hio_ext(io)->rudp);
     }
 #endif
 }
@@ -163,24 +167,35 @@ void hio_done(hio_t* io) {
     io->ready = 0;
 
     hio_del(io, HV_RDWR);
+#ifdef EVENT_IO_URING
+    uring_done_ops(io);
+#endif
 
     // readbuf
     hio_free_readbuf(io);
 
     // write_queue
-    offset_buf_t* pbuf = NULL;
+    hio_wbuf_t wbuf;
     hrecursive_mutex_lock(&io->write_mutex);
     while (!write_queue_empty(&io->write_queue)) {
-        pbuf = write_queue_front(&io->write_queue);
-        HV_FREE(pbuf->base);
+        wbuf = *write_queue_front(&io->write_queue);
         write_queue_pop_front(&io->write_queue);
+        hio_free_wbuf(&wbuf);
     }
     write_queue_cleanup(&io->write_queue);
+    // NOTE: pages pinned by kernel are still referenced after free, it is safe to free after close.
+    while (!zerocopy_queue_empty(&io->zerocopy_queue)) {
+        wbuf = *zerocopy_queue_front(&io->zerocopy_queue);
+        zerocopy_queue_pop_front(&io->zerocopy_queue);
+        hio_free_wbuf(&wbuf);
+    }
+    zerocopy_queue_cleanup(&io->zerocopy_queue);
+    io->zerocopy_bufsize = 0;
     hrecursive_mutex_unlock(&io->write_mutex);
 
 #if WITH_RUDP
     if ((io->io_type & HIO_TYPE_SOCK_DGRAM) || (io->io_type & HIO_TYPE_SOCK_RAW)) {
-        rudp_cleanup(&io->rudp);
+        if (io->ext) rudp_cleanup(&io->ext->rudp);
     }
 #endif
 }
@@ -192,7 +207,97 @@ void hio_free(hio_t* io) {
     hrecursive_mutex_destroy(&io->write_mutex);
     HV_FREE(io->localaddr);
     HV_FREE(io->peeraddr);
-    HV_FREE(io);
+    HV_FREE(io->ext);
+    if (io->slab) {
+        hio_slab_free(io->slab, io);
+    } else {
+        HV_FREE(io);
+    }
+}
+
+hio_ext_t* hio_ext(hio_t* io) {
+    if (io->ext == NULL) {
+        HV_ALLOC_SIZEOF(io->ext);
+    }
+    return io->ext;
+}
+
+//-----------------slab---------------------------------------------
+// chunk: hio_slab_chunk_t | padding | HIO_SLAB_CHUNK_SIZE * stride
+typedef struct hio_slab_chunk_s {
+    struct list_node node;
+} hio_slab_chunk_t;
+
+#define HIO_SLAB_STRIDE     ((sizeof(hio_t) + HIO_SLAB_ALIGN - 1) & ~(size_t)(HIO_SLAB_ALIGN - 1))
+#define HIO_SLAB_CHUNK_LEN  (sizeof(hio_slab_chunk_t) + HIO_SLAB_ALIGN + HIO_SLAB_CHUNK_SIZE * HIO_SLAB_STRIDE)
+
+hio_slab_t* hio_slab_new() {
+    hio_slab_t* slab = NULL;
+    HV_ALLOC_SIZEOF(slab);
+    hmutex_init(&slab->mutex);
+    list_init(&slab->chunks);
+    return slab;
+}
+
+static void hio_slab_destroy(hio_slab_t* slab) {
+    struct list_node* node = slab->chunks.next;
+    while (node != &slab->chunks) {
+        hio_slab_chunk_t* chunk = container_of(node, hio_slab_chunk_t, node);
+        node = node->next;
+        HV_FREE(chunk);
+    }
+    hmutex_destroy(&slab->mutex);
+    HV_FREE(slab);
+}
+
+static void hio_slab_grow(hio_slab_t* slab) {
+    hio_slab_chunk_t* chunk = NULL;
+    HV_ALLOC(chunk, HIO_SLAB_CHUNK_LEN);
+    list_add(&chunk->node, &slab->chunks);
+    ++slab->nchunks;
+    uintptr_t base = ((uintptr_t)(chunk + 1) + HIO_SLAB_ALIGN - 1) & ~(uintptr_t)(HIO_SLAB_ALIGN - 1);
+    // NOTE: push backward, so pop forward for address order.
+    for (int i = HIO_SLAB_CHUNK_SIZE - 1; i >= 0; --i) {
+        void** p = (void**)(base + i * HIO_SLAB_STRIDE);
+        *p = slab->free_list;
+        slab->free_list = p;
+    }
+}
+
+hio_t* hio_slab_alloc(hio_slab_t* slab) {
+    hmutex_lock(&slab->mutex);
+    if (slab->free_list == NULL) {
+        hio_slab_grow(slab);
+    }
+    hio_t* io = (hio_t*)slab->free_list;
+    slab->free_list = *(void**)io;
+    ++slab->nused;
+    hmutex_unlock(&slab->mutex);
+    memset(io, 0, sizeof(hio_t));
+    io->slab = slab;
+    return io;
+}
+
+void hio_slab_free(hio_slab_t* slab, hio_t* io) {
+    hmutex_lock(&slab->mutex);
+    *(void**)io = slab->free_list;
+    slab->free_list = io;
+    --slab->nused;
+    int destroy = slab->closed && slab->nused == 0;
+    hmutex_unlock(&slab->mutex);
+    if (destroy) {
+        hio_slab_destroy(slab);
+    }
+}
+
+void hio_slab_close(hio_slab_t* slab) {
+    hmutex_lock(&slab->mutex);
+    slab->closed = 1;
+    int destroy = slab->nused == 0;
+    hmutex_unlock(&slab->mutex);
+    if (destroy) {
+        hio_slab_destroy(slab);
+    }
 }
 
 bool hio_is_opened(hio_t* io) {
@@ -234,6 +339,12 @@ int hio_revents(hio_t* io) {
     return io->revents;
 }
 
+uint32_t hio_take_event_count(hio_t* io) {
+    uint32_t cnt = io->event_cnt;
+    io->event_cnt = 0;
+    return cnt;
+}
+
 struct sockaddr* hio_localaddr(hio_t* io) {
     return io->localaddr;
 }
@@ -282,6 +393,10 @@ void hio_setcb_read(hio_t* io, hread_cb read_cb) {
     io->read_cb = read_cb;
 }
 
+void hio_setcb_read_batch(hio_t* io, hread_batch_cb read_batch_cb) {
+    io->read_batch_cb = read_batch_cb;
+}
+
 void hio_setcb_write(hio_t* io, hwrite_cb write_cb) {
     io->write_cb = write_cb;
 }
@@ -330,7 +445,7 @@ void hio_handle_read(hio_t* io, void* buf, int readbytes) {
     }
 #endif
 
-    if (io->unpack_setting) {
+    if (hio_ext_field(io, unpack_setting)) {
         // hio_set_unpack
         hio_unpack(io, buf, readbytes);
     } else {
@@ -370,10 +485,12 @@ void hio_handle_read(hio_t* io, void* buf, int readbytes) {
 
     if (io->readbuf.head == io->readbuf.tail) {
         io->readbuf.head = io->readbuf.tail = 0;
+    } else if (hio_is_mirrored_readbuf(io)) {
+        hio_memmove_readbuf(io);
     }
     // readbuf autosize
-    if (io->readbuf.tail == io->readbuf.len) {
-        if (io->readbuf.head == 0) {
+    if (io->readbuf.tail == hio_readbuf_end(io)) {
+        if (io->readbuf.head == 0 || hio_is_mirrored_readbuf(io)) {
             // scale up * 2
             hio_alloc_readbuf(io, io->readbuf.len * 2);
         } else {
@@ -381,7 +498,9 @@ void hio_handle_read(hio_t* io, void* buf, int readbytes) {
         }
     } else {
         size_t small_size = io->readbuf.len / 2;
-        if (io->readbuf.tail < small_size &&
+        // NOTE: mirrored readbuf moves [head, tail) to the front when scaled
+        size_t used = hio_is_mirrored_readbuf(io) ? io->readbuf.tail - io->readbuf.head : io->readbuf.tail;
+        if (used < small_size &&
             io->small_readbytes_cnt >= 3) {
             // scale down / 2
             hio_alloc_readbuf(io, small_size);
@@ -412,6 +531,29 @@ void hio_read_cb(hio_t* io, void* buf, int len) {
     }
 }
 
+void hio_read_batch_cb(hio_t* io, hio_dgram_t* pkgs, int cnt) {
+    if (io->read_flags & HIO_READ_ONCE) {
+        io->read_flags &= ~HIO_READ_ONCE;
+        hio_read_stop(io);
+    }
+
+    if (io->read_batch_cb && !io->closed) {
+        io->read_batch_cb(io, pkgs, cnt);
+    }
+
+    // for readbuf autosize
+    if (hio_is_alloced_readbuf(io) && io->readbuf.len > READ_BUFSIZE_HIGH_WATER) {
+        size_t small_size = io->readbuf.len / 2;
+        for (int i = 0; i < cnt; ++i) {
+            if (pkgs[i].len < small_size) {
+                ++io->small_readbytes_cnt;
+            } else {
+                io->small_readbytes_cnt = 0;
+            }
+        }
+    }
+}
+
 void hio_write_cb(hio_t* io, const void* buf, int len) {
     if (io->write_cb  && !io->closed) {
         // printd("write_cb------\n");
@@ -459,22 +601,26 @@ bool hio_is_ssl(hio_t* io) {
 }
 
 hssl_t hio_get_ssl(hio_t* io) {
-    return io->ssl;
+    return hio_ext_field(io, ssl);
+}
+
+int hio_get_ktls(hio_t* io) {
+    return (io->ktls_tx ? HSSL_KTLS_TX : 0) | (io->ktls_rx ? HSSL_KTLS_RX : 0);
 }
 
 hssl_ctx_t hio_get_ssl_ctx(hio_t* io) {
-    return io->ssl_ctx;
+    return hio_ext_field(io, ssl_ctx);
 }
 
 int hio_set_ssl(hio_t* io, hssl_t ssl) {
     io->io_type = HIO_TYPE_SSL;
-    io->ssl = ssl;
+    hio_ext(io)->ssl = ssl;
     return 0;
 }
 
 int hio_set_ssl_ctx(hio_t* io, hssl_ctx_t ssl_ctx) {
     io->io_type = HIO_TYPE_SSL;
-    io->ssl_ctx = ssl_ctx;
+    hio_ext(io)->ssl_ctx = ssl_ctx;
     return 0;
 }
 
@@ -486,77 +632,85 @@ int hio_new_ssl_ctx(hio_t* io, hssl_ctx_opt_t* opt) {
 }
 
 int hio_set_hostname(hio_t* io, const char* hostname) {
-    SAFE_FREE(io->hostname);
-    io->hostname = strdup(hostname);
+    hio_ext_t* ext = hio_ext(io);
+    SAFE_FREE(ext->hostname);
+    ext->hostname = strdup(hostname);
     return 0;
 }
 
 const char* hio_get_hostname(hio_t* io) {
-    return io->hostname;
+    return hio_ext_field(io, hostname);
 }
 
 void hio_del_connect_timer(hio_t* io) {
-    if (io->connect_timer) {
-        htimer_del(io->connect_timer);
-        io->connect_timer = NULL;
-        io->connect_timeout = 0;
+    hio_ext_t* ext = io->ext;
+    if (ext && ext->connect_timer) {
+        htimer_del(ext->connect_timer);
+        ext->connect_timer = NULL;
+        ext->connect_timeout = 0;
     }
 }
 
 void hio_del_close_timer(hio_t* io) {
-    if (io->close_timer) {
-        htimer_del(io->close_timer);
-        io->close_timer = NULL;
-        io->close_timeout = 0;
+    hio_ext_t* ext = io->ext;
+    if (ext && ext->close_timer) {
+        htimer_del(ext->close_timer);
+        ext->close_timer = NULL;
+        ext->close_timeout = 0;
     }
 }
 
 void hio_del_read_timer(hio_t* io) {
-    if (io->read_timer) {
-        htimer_del(io->read_timer);
-        io->read_timer = NULL;
-        io->read_timeout = 0;
+    hio_ext_t* ext = io->ext;
+    if (ext && ext->read_timer) {
+        htimer_del(ext->read_timer);
+        ext->read_timer = NULL;
+        ext->read_timeout = 0;
     }
 }
 
 void hio_del_write_timer(hio_t* io) {
-    if (io->write_timer) {
-        htimer_del(io->write_timer);
-        io->write_timer = NULL;
-        io->write_timeout = 0;
+    hio_ext_t* ext = io->ext;
+    if (ext && ext->write_timer) {
+        htimer_del(ext->write_timer);
+        ext->write_timer = NULL;
+        ext->write_timeout = 0;
     }
 }
 
 void hio_del_keepalive_timer(hio_t* io) {
-    if (io->keepalive_timer) {
-        htimer_del(io->keepalive_timer);
-        io->keepalive_timer = NULL;
-        io->keepalive_timeout = 0;
+    hio_ext_t* ext = io->ext;
+    if (ext && ext->keepalive_timer) {
+        htimer_del(ext->keepalive_timer);
+        ext->keepalive_timer = NULL;
+        ext->keepalive_timeout = 0;
     }
 }
 
 void hio_del_heartbeat_timer(hio_t* io) {
-    if (io->heartbeat_timer) {
-        htimer_del(io->heartbeat_timer);
-        io->heartbeat_timer = NULL;
-        io->heartbeat_interval = 0;
-        io->heartbeat_fn = NULL;
+    hio_ext_t* ext = io->ext;
+    if (ext && ext->heartbeat_timer) {
+        htimer_del(ext->heartbeat_timer);
+        ext->heartbeat_timer = NULL;
+        ext->heartbeat_interval = 0;
+        ext->heartbeat_fn = NULL;
     }
 }
 
 void hio_set_connect_timeout(hio_t* io, int timeout_ms) {
-    io->connect_timeout = timeout_ms;
+    hio_ext(io)->connect_timeout = timeout_ms;
 }
 
 void hio_set_close_timeout(hio_t* io, int timeout_ms) {
-    io->close_timeout = timeout_ms;
+    hio_ext(io)->close_timeout = timeout_ms;
 }
 
 static void __read_timeout_cb(htimer_t* timer) {
     hio_t* io = (hio_t*)timer->privdata;
+    hio_ext_t* ext = io->ext;
     uint64_t inactive_ms = (io->loop->cur_hrtime - io->last_read_hrtime) / 1000;
-    if (inactive_ms + 100 < io->read_timeout) {
-        htimer_reset(io->read_timer, io->read_timeout - inactive_ms);
+    if (inactive_ms + 100 < ext->read_timeout) {
+        htimer_reset(ext->read_timer, ext->read_timeout - inactive_ms);
     } else {
         if (io->io_type & HIO_TYPE_SOCKET) {
             char localaddrstr[SOCKADDR_STRLEN] = {0};
@@ -577,22 +731,24 @@ void hio_set_read_timeout(hio_t* io, int timeout_ms) {
         return;
     }
 
-    if (io->read_timer) {
+    hio_ext_t* ext = hio_ext(io);
+    if (ext->read_timer) {
         // reset
-        htimer_reset(io->read_timer, timeout_ms);
+        htimer_reset(ext->read_timer, timeout_ms);
     } else {
         // add
-        io->read_timer = htimer_add(io->loop, __read_timeout_cb, timeout_ms, 1);
-        io->read_timer->privdata = io;
+        ext->read_timer = htimer_add_wheel(io->loop, __read_timeout_cb, timeout_ms, 1);
+        ext->read_timer->privdata = io;
     }
-    io->read_timeout = timeout_ms;
+    ext->read_timeout = timeout_ms;
 }
 
 static void __write_timeout_cb(htimer_t* timer) {
     hio_t* io = (hio_t*)timer->privdata;
+    hio_ext_t* ext = io->ext;
     uint64_t inactive_ms = (io->loop->cur_hrtime - io->last_write_hrtime) / 1000;
-    if (inactive_ms + 100 < io->write_timeout) {
-        htimer_reset(io->write_timer, io->write_timeout - inactive_ms);
+    if (inactive_ms + 100 < ext->write_timeout) {
+        htimer_reset(ext->write_timer, ext->write_timeout - inactive_ms);
     } else {
         if (io->io_type & HIO_TYPE_SOCKET) {
             char localaddrstr[SOCKADDR_STRLEN] = {0};
@@ -613,23 +769,25 @@ void hio_set_write_timeout(hio_t* io, int timeout_ms) {
         return;
     }
 
-    if (io->write_timer) {
+    hio_ext_t* ext = hio_ext(io);
+    if (ext->write_timer) {
         // reset
-        htimer_reset(io->write_timer, timeout_ms);
+        htimer_reset(ext->write_timer, timeout_ms);
     } else {
         // add
-        io->write_timer = htimer_add(io->loop, __write_timeout_cb, timeout_ms, 1);
-        io->write_timer->privdata = io;
+        ext->write_timer = htimer_add_wheel(io->loop, __write_timeout_cb, timeout_ms, 1);
+        ext->write_timer->privdata = io;
     }
-    io->write_timeout = timeout_ms;
+    ext->write_timeout = timeout_ms;
 }
 
 static void __keepalive_timeout_cb(htimer_t* timer) {
     hio_t* io = (hio_t*)timer->privdata;
+    hio_ext_t* ext = io->ext;
     uint64_t last_rw_hrtime = MAX(io->last_read_hrtime, io->last_write_hrtime);
     uint64_t inactive_ms = (io->loop->cur_hrtime - last_rw_hrtime) / 1000;
-    if (inactive_ms + 100 < io->keepalive_timeout) {
-        htimer_reset(io->keepalive_timer, io->keepalive_timeout - inactive_ms);
+    if (inactive_ms + 100 < ext->keepalive_timeout) {
+        htimer_reset(ext->keepalive_timer, ext->keepalive_timeout - inactive_ms);
     } else {
         if (io->io_type & HIO_TYPE_SOCKET) {
             char localaddrstr[SOCKADDR_STRLEN] = {0};
@@ -650,21 +808,22 @@ void hio_set_keepalive_timeout(hio_t* io, int timeout_ms) {
         return;
     }
 
-    if (io->keepalive_timer) {
+    hio_ext_t* ext = hio_ext(io);
+    if (ext->keepalive_timer) {
         // reset
-        htimer_reset(io->keepalive_timer, timeout_ms);
+        htimer_reset(ext->keepalive_timer, timeout_ms);
     } else {
         // add
-        io->keepalive_timer = htimer_add(io->loop, __keepalive_timeout_cb, timeout_ms, 1);
-        io->keepalive_timer->privdata = io;
+        ext->keepalive_timer = htimer_add_wheel(io->loop, __keepalive_timeout_cb, timeout_ms, 1);
+        ext->keepalive_timer->privdata = io;
     }
-    io->keepalive_timeout = timeout_ms;
+    ext->keepalive_timeout = timeout_ms;
 }
 
 static void __heartbeat_timer_cb(htimer_t* timer) {
     hio_t* io = (hio_t*)timer->privdata;
-    if (io && io->heartbeat_fn) {
-        io->heartbeat_fn(io);
+    if (io && io->ext && io->ext->heartbeat_fn) {
+        io->ext->heartbeat_fn(io);
     }
 }
 
@@ -675,19 +834,46 @@ void hio_set_heartbeat(hio_t* io, int interval_ms, hio_send_heartbeat_fn fn) {
         return;
     }
 
-    if (io->heartbeat_timer) {
+    hio_ext_t* ext = hio_ext(io);
+    if (ext->heartbeat_timer) {
         // reset
-        htimer_reset(io->heartbeat_timer, interval_ms);
+        htimer_reset(ext->heartbeat_timer, interval_ms);
     } else {
         // add
-        io->heartbeat_timer = htimer_add(io->loop, __heartbeat_timer_cb, interval_ms, INFINITE);
-        io->heartbeat_timer->privdata = io;
+        ext->heartbeat_timer = htimer_add_wheel(io->loop, __heartbeat_timer_cb, interval_ms, INFINITE);
+        ext->heartbeat_timer->privdata = io;
     }
-    io->heartbeat_interval = interval_ms;
-    io->heartbeat_fn = fn;
+    ext->heartbeat_interval = interval_ms;
+    ext->heartbeat_fn = fn;
 }
 
 //-----------------iobuf---------------------------------------------
+// new readbuf, [head, tail) is moved to the front
+static int hio_move_readbuf(hio_t* io, size_t len, int mirror) {
+    fifo_buf_t* buf = &io->readbuf;
+    size_t remain = buf->tail - buf->head;
+    char* base = NULL;
+    if (mirror) {
+        base = (char*)hv_mirror_alloc(&len);
+        if (base == NULL) return -1;
+    } else {
+        HV_ALLOC(base, len);
+    }
+    assert(remain <= len);
+    if (remain) {
+        memcpy(base, buf->base + buf->head, remain);
+    }
+    hio_free_readbuf(io);
+    buf->base = base;
+    buf->len = len;
+    buf->head = 0;
+    buf->tail = remain;
+    io->alloced_readbuf = 1;
+    io->mirror_readbuf = mirror;
+    io->small_readbytes_cnt = 0;
+    return 0;
+}
+
 void hio_alloc_readbuf(hio_t* io, int len) {
     if (len > io->max_read_bufsize) {
         hloge("read bufsize > %u, close it!", io->max_read_bufsize);
@@ -695,6 +881,12 @@ void hio_alloc_readbuf(hio_t* io, int len) {
         hio_close_async(io);
         return;
     }
+    if (io->mirror_readbuf) {
+        if (hio_move_readbuf(io, len, 1) == 0) return;
+        hlogw("alloc mirrored readbuf failed, fallback to heap");
+        hio_move_readbuf(io, len, 0);
+        return;
+    }
     if (hio_is_alloced_readbuf(io)) {
         io->readbuf.base = (char*)hv_realloc(io->readbuf.base, len, io->readbuf.len);
     } else {
@@ -706,6 +898,10 @@ void hio_alloc_readbuf(hio_t* io, int len) {
 }
 
 void hio_free_readbuf(hio_t* io) {
+    if (hio_is_mirrored_readbuf(io)) {
+        hv_mirror_free(io->readbuf.base, io->readbuf.len);
+        io->readbuf.base = NULL;
+    }
     if (hio_is_alloced_readbuf(io)) {
         HV_FREE(io->readbuf.base);
         io->alloced_readbuf = 0;
@@ -721,6 +917,14 @@ void hio_memmove_readbuf(hio_t* io) {
         buf->head = buf->tail = 0;
         return;
     }
+    if (hio_is_mirrored_readbuf(io)) {
+        // [head, tail] is contiguous in the mirror, wrap around
+        if (buf->head >= buf->len) {
+            buf->head -= buf->len;
+            buf->tail -= buf->len;
+        }
+        return;
+    }
     if (buf->tail > buf->head) {
         size_t size = buf->tail - buf->head;
         // [head, tail] => [0, tail - head]
@@ -730,6 +934,41 @@ void hio_memmove_readbuf(hio_t* io) {
     }
 }
 
+void hio_keep_readbuf(hio_t* io, const void* data, size_t len) {
+    fifo_buf_t* buf = &io->readbuf;
+    if (len == 0) {
+        buf->head = buf->tail = 0;
+        return;
+    }
+    if (hio_is_mirrored_readbuf(io)) {
+        buf->head = (const char*)data - buf->base;
+        buf->tail = buf->head + len;
+        hio_memmove_readbuf(io);
+        return;
+    }
+    // [data, data+len] => [base, base+len]
+    if (data != buf->base) {
+        memmove(buf->base, data, len);
+    }
+    buf->head = 0;
+    buf->tail = len;
+}
+
+int hio_set_readbuf_mirror(hio_t* io, int on) {
+    on = on ? 1 : 0;
+#if defined(EVENT_IOCP) || defined(EVENT_IO_URING)
+    // NOTE: readbuf may be handed over to the kernel in flight
+    if (on) return -1;
+#endif
+    if (io->mirror_readbuf == on) return 0;
+    if (!hio_is_alloced_readbuf(io)) {
+        // mirrored when hio_alloc_readbuf
+        io->mirror_readbuf = on;
+        return 0;
+    }
+    return hio_move_readbuf(io, io->readbuf.len, on);
+}
+
 void hio_set_readbuf(hio_t* io, void* buf, size_t len) {
     assert(io && buf && len != 0);
     hio_free_readbuf(io);
@@ -755,6 +994,49 @@ size_t hio_write_bufsize(hio_t* io) {
     return io->write_bufsize;
 }
 
+void hio_set_write_water(hio_t* io, uint32_t high_water, uint32_t low_water) {
+    hio_ext_t* ext = hio_ext(io);
+    ext->write_high_water = high_water;
+    // NOTE: low_water 0 means high_water / 2, not to wait for an empty write queue to resume
+    ext->write_low_water = low_water == 0 ? high_water / 2 : MIN(low_water, high_water);
+    if (high_water == 0) {
+        io->over_high_water = 0;
+    }
+}
+
+void hio_setcb_high_water(hio_t* io, hwater_cb high_water_cb) {
+    hio_ext(io)->high_water_cb = high_water_cb;
+}
+
+void hio_setcb_drained(hio_t* io, hwater_cb drained_cb) {
+    hio_ext(io)->drained_cb = drained_cb;
+}
+
+bool hio_is_over_high_water(hio_t* io) {
+    return io->over_high_water;
+}
+
+void hio_write_water_cb(hio_t* io) {
+    hio_ext_t* ext = io->ext;
+    if (ext == NULL || ext->write_high_water == 0 || io->closed) return;
+    if (!io->over_high_water) {
+        if (io->write_bufsize > ext->write_high_water) {
+            io->over_high_water = 1;
+            if (ext->high_water_cb) {
+                ext->high_water_cb(io, io->write_bufsize);
+            }
+        }
+    } else if (io->write_bufsize <= ext->write_low_water) {
+        io->over_high_water = 0;
+        if (io->upstream_water) {
+            hio_read_upstream_on_drained(io, io->write_bufsize);
+        }
+        if (ext->drained_cb) {
+            ext->drained_cb(io, io->write_bufsize);
+        }
+    }
+}
+
 int hio_read_once (hio_t* io) {
     io->read_flags |= HIO_READ_ONCE;
     return hio_read_start(io);
@@ -777,7 +1059,7 @@ int hio_read_until_length(hio_t* io, unsigned int len) {
         hio_memmove_readbuf(io);
     }
     // NOTE: prepare readbuf
-    int need_len = io->readbuf.head + len;
+    int need_len = hio_is_mirrored_readbuf(io) ? len : io->readbuf.head + len;
     if (hio_is_loop_readbuf(io) ||
         io->readbuf.len < need_len) {
         hio_alloc_readbuf(io, need_len);
@@ -828,41 +1110,41 @@ void hio_set_unpack(hio_t* io, unpack_setting_t* setting) {
     hio_unset_unpack(io);
     if (setting == NULL) return;
 
-    io->unpack_setting = setting;
-    if (io->unpack_setting->package_max_length == 0) {
-        io->unpack_setting->package_max_length = DEFAULT_PACKAGE_MAX_LENGTH;
+    hio_ext(io)->unpack_setting = setting;
+    if (setting->package_max_length == 0) {
+        setting->package_max_length = DEFAULT_PACKAGE_MAX_LENGTH;
     }
-    if (io->unpack_setting->mode == UNPACK_BY_FIXED_LENGTH) {
-        assert(io->unpack_setting->fixed_length != 0 &&
-               io->unpack_setting->fixed_length <= io->unpack_setting->package_max_length);
+    if (setting->mode == UNPACK_BY_FIXED_LENGTH) {
+        assert(setting->fixed_length != 0 &&
+               setting->fixed_length <= setting->package_max_length);
     }
-    else if (io->unpack_setting->mode == UNPACK_BY_DELIMITER) {
-        if (io->unpack_setting->delimiter_bytes == 0) {
-            io->unpack_setting->delimiter_bytes = strlen((char*)io->unpack_setting->delimiter);
+    else if (setting->mode == UNPACK_BY_DELIMITER) {
+        if (setting->delimiter_bytes == 0) {
+            setting->delimiter_bytes = strlen((char*)setting->delimiter);
         }
     }
-    else if (io->unpack_setting->mode == UNPACK_BY_LENGTH_FIELD) {
-        assert(io->unpack_setting->body_offset >=
-               io->unpack_setting->length_field_offset +
-               io->unpack_setting->length_field_bytes);
-        if (io->unpack_setting->length_field_coding == 0) {
-            io->unpack_setting->length_field_coding = ENCODE_BY_BIG_ENDIAN;
+    else if (setting->mode == UNPACK_BY_LENGTH_FIELD) {
+        assert(setting->body_offset >=
+               setting->length_field_offset +
+               setting->length_field_bytes);
+        if (setting->length_field_coding == 0) {
+            setting->length_field_coding = ENCODE_BY_BIG_ENDIAN;
         }
     }
 
     // NOTE: unpack must have own readbuf
-    if (io->unpack_setting->mode == UNPACK_BY_FIXED_LENGTH) {
-        io->readbuf.len = io->unpack_setting->fixed_length;
+    if (setting->mode == UNPACK_BY_FIXED_LENGTH) {
+        io->readbuf.len = setting->fixed_length;
     } else {
-        io->readbuf.len = MIN(HLOOP_READ_BUFSIZE, io->unpack_setting->package_max_length);
+        io->readbuf.len = MIN(HLOOP_READ_BUFSIZE, setting->package_max_length);
     }
-    io->max_read_bufsize = io->unpack_setting->package_max_length;
+    io->max_read_bufsize = setting->package_max_length;
     hio_alloc_readbuf(io, io->readbuf.len);
 }
 
 void hio_unset_unpack(hio_t* io) {
-    if (io->unpack_setting) {
-        io->unpack_setting = NULL;
+    if (hio_ext_field(io, unpack_setting)) {
+        io->ext->unpack_setting = NULL;
         // NOTE: unpack has own readbuf
         hio_free_readbuf(io);
     }
@@ -870,7 +1152,7 @@ void hio_unset_unpack(hio_t* io) {
 
 //-----------------upstream---------------------------------------------
 void hio_read_upstream(hio_t* io) {
-    hio_t* upstream_io = io->upstream_io;
+    hio_t* upstream_io = hio_ext_field(io, upstream_io);
     if (upstream_io) {
         hio_read(io);
         hio_read(upstream_io);
@@ -878,19 +1160,32 @@ void hio_read_upstream(hio_t* io) {
 }
 
 void hio_read_upstream_on_write_complete(hio_t* io, const void* buf, int writebytes) {
-    hio_t* upstream_io = io->upstream_io;
+    hio_t* upstream_io = hio_ext_field(io, upstream_io);
     if (upstream_io && hio_write_is_complete(io)) {
         hio_setcb_write(io, NULL);
         hio_read(upstream_io);
     }
 }
 
+void hio_read_upstream_on_drained(hio_t* io, size_t write_bufsize) {
+    hio_t* upstream_io = hio_ext_field(io, upstream_io);
+    if (upstream_io && !upstream_io->closed) {
+        hio_read(upstream_io);
+    }
+}
+
 void hio_write_upstream(hio_t* io, void* buf, int bytes) {
-    hio_t* upstream_io = io->upstream_io;
+    hio_t* upstream_io = hio_ext_field(io, upstream_io);
     if (upstream_io) {
         int nwrite = hio_write(upstream_io, buf, bytes);
+        if (hio_ext_field(upstream_io, write_high_water)) {
+            // NOTE: keep reading until over high water, resume on drained
+            if (upstream_io->over_high_water) {
+                hio_read_stop(io);
+            }
+        }
         // if (!hio_write_is_complete(upstream_io)) {
-        if (nwrite >= 0 && nwrite < bytes) {
+        else if (nwrite >= 0 && nwrite < bytes) {
             hio_read_stop(io);
             hio_setcb_write(upstream_io, hio_read_upstream_on_write_complete);
         }
@@ -898,19 +1193,34 @@ void hio_write_upstream(hio_t* io, void* buf, int bytes) {
 }
 
 void hio_close_upstream(hio_t* io) {
-    hio_t* upstream_io = io->upstream_io;
+    hio_t* upstream_io = hio_ext_field(io, upstream_io);
     if (upstream_io) {
         hio_close(upstream_io);
     }
 }
 
+static void hio_setup_upstream_water(hio_t* io) {
+    hio_ext_t* ext = hio_ext(io);
+    if (ext->write_high_water == 0) {
+        hio_set_write_water(io, UPSTREAM_WRITE_HIGH_WATER, UPSTREAM_WRITE_LOW_WATER);
+    }
+    // NOTE: not ext->drained_cb, which is left to hio_setcb_drained
+    io->upstream_water = 1;
+}
+
 void hio_setup_upstream(hio_t* io1, hio_t* io2) {
-    io1->upstream_io = io2;
-    io2->upstream_io = io1;
+    hio_ext(io1)->upstream_io = io2;
+    hio_ext(io2)->upstream_io = io1;
+    hio_setup_upstream_water(io1);
+    hio_setup_upstream_water(io2);
+}
+
+uint64_t hio_splice_bytes(hio_t* io) {
+    return hio_ext_field(io, splice_bytes);
 }
 
 hio_t* hio_get_upstream(hio_t* io) {
-    return io->upstream_io;
+    return hio_ext_field(io, upstream_io);
 }
 
 hio_t* hio_setup_tcp_upstream(hio_t* io, const char* host, int port, int ssl) {
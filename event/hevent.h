@@ -7,6 +7,7 @@
 
 #include "hbuf.h"
 #include "hmutex.h"
+#include "hatomic.h"
 
 #include "array.h"
 #include "list.h"
@@ -18,6 +19,8 @@
 #define WRITE_BUFSIZE_HIGH_WATER    (1U << 23)  // 8M
 #define MAX_READ_BUFSIZE            (1U << 24)  // 16M
 #define MAX_WRITE_BUFSIZE           (1U << 24)  // 16M
+#define UPSTREAM_WRITE_HIGH_WATER   (1U << 18)  // 256K
+#define UPSTREAM_WRITE_LOW_WATER    (1U << 16)  // 64K
 
 // hio_read_flags
 #define HIO_READ_ONCE           0x1
@@ -26,7 +29,33 @@
 
 ARRAY_DECL(hio_t*, io_array);
 ARRAY_DECL(hsignal_t*, signal_array);
-QUEUE_DECL(hevent_t, event_queue);
+
+// @see hio_migrate
+typedef struct hio_migration_s {
+    hio_t*          io;
+    uint32_t        id;
+    hloop_t*        src;
+    hloop_t*        dst;
+    hio_migrate_cb  cb;
+    void*           userdata;
+    // timers restarted in dst loop
+    int             read_timeout;
+    int             write_timeout;
+    int             keepalive_timeout;
+    int             heartbeat_interval;
+    hio_send_heartbeat_fn heartbeat_fn;
+} hio_migration_t;
+ARRAY_DECL(hio_migration_t, migration_array);
+
+// hashed timing wheel for hio timers, coarse granularity but O(1) add/reset/del.
+#define HTIMER_WHEEL_SLOTS      1024    // must be power of 2
+#define HTIMER_WHEEL_TICK       10      // ms
+typedef struct htimer_wheel_s {
+    uint64_t            tick;       // next tick to process
+    uint32_t            ntimers;
+    uint64_t            bitmap[HTIMER_WHEEL_SLOTS / 64]; // non-empty slots
+    struct list_head    slots[HTIMER_WHEEL_SLOTS];
+} htimer_wheel_t;
 
 struct hloop_s {
     uint32_t    flags;
@@ -56,19 +85,71 @@ struct hloop_s {
     struct heap                 timers;     // monotonic time
     struct heap                 realtimers; // realtime
     uint32_t                    ntimers;
+    htimer_wheel_t*             wheel;      // for hio timers
+    htimer_stats_t              timer_stats;
+    // busy poll, @see HLOOP_FLAG_BUSY_POLL
+    uint32_t                    busy_poll_us;
+    int                         sock_busy_poll_us;
+    uint64_t                    busy_poll_deadline; // us
+    hloop_busy_poll_stats_t     busy_poll_stats;
+    // stats, @see HLOOP_FLAG_STATS
+    // NOTE: written by the loop thread between HLOOP_STATS_WRITE_BEGIN/END,
+    // stalls and slowest by the watchdog thread under stalls_mutex.
+    hloop_stats_t               stats;
+    uint64_t                    stats_seq;  // seqlock, odd while writing
+    hmutex_t                    stalls_mutex;
+    // watchdog, @see hloop_watch
+    int                         watched;
+    volatile int                in_poll;
+    volatile long               cb_seq;     // incremented when enter and leave callback
+    hloop_stall_t               cur_cb;
     // ios: with fd as array.index
     struct io_array             ios;
     uint32_t                    nios;
+    // detached after pendings processed, @see hio_migrate
+    struct migration_array      migrations;
+    struct hio_slab_s*          ioslab;     // for hio_get
     // one loop per thread, so one readbuf per loop is OK.
     hbuf_t                      readbuf;
+    // for recvmmsg, @see hio_set_batch
+    hbuf_t                      mmsgbuf;
     void*                       iowatcher;
     // custom_events
     int                         eventfds[2];
-    event_queue                 custom_events;
-    hmutex_t                    custom_events_mutex;
+    // NOTE: lock-free MPSC, pushed by hloop_post_event, linked by pending_next, LIFO.
+    void* volatile              custom_events;
+    // eventfd written but not read yet, coalesce wakeups
+    volatile long               custom_events_wakeup;
+    volatile long               custom_events_posted;
+    volatile long               custom_events_depth;
+    // NOTE: recycled nodes, pushed by loop thread, popped by hloop_post_event under custom_events_free_lock.
+    void* volatile              custom_events_free;
+    volatile long               custom_events_free_lock;
+    volatile long               custom_events_nfree;
+    hmutex_t                    custom_events_mutex; // for eventfds
 };
 
 uint64_t hloop_next_event_id();
+// seqlock of loop->stats, for hloop_stats from any thread
+#define HLOOP_STATS_WRITE_BEGIN(loop) \
+    do {\
+        hatomic_store_relaxed(&(loop)->stats_seq, (loop)->stats_seq + 1);\
+        hatomic_fence_release();\
+    } while(0)
+
+#define HLOOP_STATS_WRITE_END(loop) \
+    hatomic_store_release(&(loop)->stats_seq, (loop)->stats_seq + 1)
+
+// loop->stats counter += n
+#define HLOOP_STATS_ADD(loop, field, n) \
+    do {\
+        HLOOP_STATS_WRITE_BEGIN(loop);\
+        hatomic_add_relaxed(&(loop)->stats.field, n);\
+        HLOOP_STATS_WRITE_END(loop);\
+    } while(0)
+
+// @see hloop_stats_t.slowest
+void hloop_stall_add_slowest(hloop_stats_t* stats, const hloop_stall_t* stall);
 
 struct hidle_s {
     HEVENT_FIELDS
@@ -90,6 +171,8 @@ struct htimer_s {
 struct htimeout_s {
     HTIMER_FIELDS
     uint32_t    timeout;                \
+    unsigned    wheel       :1;         // for htimer_add_wheel
+    struct list_node wheel_node;
 };
 
 struct hperiod_s {
@@ -101,8 +184,95 @@ struct hperiod_s {
     int8_t      month;
 };
 
-QUEUE_DECL(offset_buf_t, write_queue);
-// sizeof(struct hio_s)=416 on linux-x64
+// write_queue element, @see hio_write_owned
+typedef struct hio_wbuf_s {
+    char*       base;
+    size_t      len;
+    size_t      offset;
+    hfree_cb    free_cb;    // NULL: HV_FREE(base)
+    void*       userdata;
+    // MSG_ZEROCOPY: kernel still references base until notification zerocopy_seq
+    unsigned    zerocopy :1;
+    // hio_sendfile: base is NULL, send [offset, len) of file fd
+    unsigned    sendfile :1;
+    uint32_t    zerocopy_seq;
+    int         fd;
+} hio_wbuf_t;
+
+static inline void hio_free_wbuf(hio_wbuf_t* pbuf) {
+#ifdef OS_UNIX
+    if (pbuf->sendfile) {
+        close(pbuf->fd);
+        return;
+    }
+#endif
+    if (pbuf->free_cb) {
+        pbuf->free_cb(pbuf->base, pbuf->userdata);
+    } else {
+        HV_FREE(pbuf->base);
+    }
+}
+
+QUEUE_DECL(hio_wbuf_t, write_queue);
+QUEUE_DECL(hio_wbuf_t, zerocopy_queue);
+// cold fields of hio_t, allocated by hio_ext when first used.
+typedef struct hio_ext_s {
+    // timers
+    int         connect_timeout;    // ms, call hio_close when timeout
+    int         close_timeout;      // ms
+    int         read_timeout;       // ms
+    int         write_timeout;      // ms
+    int         keepalive_timeout;  // ms
+    int         heartbeat_interval; // ms, call heartbeat_fn when timeout
+    hio_send_heartbeat_fn heartbeat_fn;
+    htimer_t*   connect_timer;
+    htimer_t*   close_timer;
+    htimer_t*   read_timer;
+    htimer_t*   write_timer;
+    htimer_t*   keepalive_timer;
+    htimer_t*   heartbeat_timer;
+    // upstream
+    struct hio_s*       upstream_io;    // for hio_setup_upstream
+    // splice: io => splice_pipe => upstream_io, @see hio_set_splice_upstream
+    int         splice_pipe[2];
+    uint32_t    splice_pipe_size;
+    uint32_t    splice_pipe_bytes;  // in pipe, not yet spliced to upstream_io
+    uint64_t    splice_bytes;
+    // write water
+    uint32_t    write_high_water;   // for hio_set_write_water
+    uint32_t    write_low_water;
+    hwater_cb   high_water_cb;
+    hwater_cb   drained_cb;
+    // unpack
+    unpack_setting_t*   unpack_setting; // for hio_set_unpack
+    // ssl
+    void*       ssl;        // for hio_set_ssl
+    void*       ssl_ctx;    // for hio_set_ssl_ctx
+    char*       hostname;   // for hssl_set_sni_hostname
+#if WITH_RUDP
+    rudp_t          rudp;
+#if WITH_KCP
+    kcp_setting_t*  kcp_setting;
+#endif
+#endif
+} hio_ext_t;
+
+// hio_t slab per loop, hio_t are carved from cache line aligned chunks.
+// NOTE: hio_t may be detached and attached to another loop,
+// so slab is freed after both loop freed and all hio_t returned.
+#define HIO_SLAB_CHUNK_SIZE     64      // hio_t per chunk
+#define HIO_SLAB_ALIGN          64      // cache line
+typedef struct hio_slab_s {
+    hmutex_t            mutex;
+    void*               free_list;
+    struct list_head    chunks;
+    uint32_t            nchunks;
+    uint32_t            nused;
+    int                 closed;         // loop freed
+} hio_slab_t;
+
+// NOTE: fields touched on every event first, cold fields in hio_ext_t.
+// sizeof(struct hio_s)=384 on linux-x64
 struct hio_s {
     HEVENT_FIELDS
     // flags
@@ -118,18 +288,25 @@ struct hio_s {
     unsigned    sendto      :1;
     unsigned    close       :1;
     unsigned    alloced_readbuf :1; // for hio_alloc_readbuf
+    unsigned    mirror_readbuf  :1; // for hio_set_readbuf_mirror
     unsigned    alloced_ssl_ctx :1; // for hio_new_ssl_ctx
+    unsigned    udp_gro     :1; // for hio_set_batch
+    unsigned    udp_gso     :1;
+    unsigned    rdhup       :1; // EPOLLRDHUP, read until EOF for HLOOP_FLAG_EDGE_TRIGGERED
+    unsigned    migrating   :1; // detached but not attached yet, @see hio_migrate
+    unsigned    over_high_water :1; // @see hio_set_write_water
+    unsigned    upstream_water  :1; // hio_read(upstream_io) on drained, @see hio_setup_upstream
+    unsigned    splice      :1; // @see hio_set_splice_upstream
+    unsigned    splice_eof  :1; // read EOF, shutdown upstream_io after pipe drained
+    unsigned    ktls_tx     :1; // kernel owns the TLS record layer of write, @see hio_get_ktls
+    unsigned    ktls_rx     :1;
 // public:
     hio_type_e  io_type;
-    uint32_t    id; // fd cannot be used as unique identifier, so we provide an id
     int         fd;
-    int         error;
     int         events;
     int         revents;
-    struct sockaddr*    localaddr;
-    struct sockaddr*    peeraddr;
-    uint64_t            last_read_hrtime;
-    uint64_t            last_write_hrtime;
+    int         ready_events;   // HLOOP_FLAG_EDGE_TRIGGERED: still ready, @see iowatcher_set_ready
+    int         error;
     // read
     fifo_buf_t          readbuf;
     unsigned int        read_flags;
@@ -138,43 +315,19 @@ struct hio_s {
         unsigned int    read_until_length;
         unsigned char   read_until_delim;
     };
-    uint32_t            max_read_bufsize;
-    uint32_t            small_readbytes_cnt; // for readbuf autosize
-    // write
-    struct write_queue  write_queue;
-    hrecursive_mutex_t  write_mutex; // lock write and write_queue
-    uint32_t            write_bufsize;
-    uint32_t            max_write_bufsize;
     // callbacks
     hread_cb    read_cb;
     hwrite_cb   write_cb;
-    hclose_cb   close_cb;
-    haccept_cb  accept_cb;
-    hconnect_cb connect_cb;
-    // timers
-    int         connect_timeout;    // ms, call hio_close when timeout
-    int         close_timeout;      // ms
-    int         read_timeout;       // ms
-    int         write_timeout;      // ms
-    int         keepalive_timeout;  // ms
-    int         heartbeat_interval; // ms, call heartbeat_fn when timeout
-    hio_send_heartbeat_fn heartbeat_fn;
-    htimer_t*   connect_timer;
-    htimer_t*   close_timer;
-    htimer_t*   read_timer;
-    htimer_t*   write_timer;
-    htimer_t*   keepalive_timer;
-    htimer_t*   heartbeat_timer;
-    // upstream
-    struct hio_s*       upstream_io;    // for hio_setup_upstream
-    // unpack
-    unpack_setting_t*   unpack_setting; // for hio_set_unpack
-    // ssl
-    void*       ssl;        // for hio_set_ssl
-    void*       ssl_ctx;    // for hio_set_ssl_ctx
-    char*       hostname;   // for hssl_set_sni_hostname
     // context
     void*       ctx; // for hio_context / hio_set_context
+    uint64_t            last_read_hrtime;
+    uint64_t            last_write_hrtime;
+    // write
+    struct write_queue  write_queue;
+    uint32_t            write_bufsize;
+    uint32_t            sendfile_bufsize;   // file bytes of write_bufsize, not limited by max_write_bufsize
+    uint32_t            max_write_bufsize;
+    hrecursive_mutex_t  write_mutex; // lock write and write_queue
 // private:
 #if defined(EVENT_POLL) || defined(EVENT_KQUEUE)
     int         event_index[2]; // for poll,kqueue
@@ -184,13 +337,37 @@ struct hio_s {
     void*       hovlp;          // for iocp/overlapio
 #endif
 
-#if WITH_RUDP
-    rudp_t          rudp;
-#if WITH_KCP
-    kcp_setting_t*  kcp_setting;
-#endif
+#ifdef EVENT_IO_URING
+    void*       uring_rop;      // for io_uring accept/recv
+    void*       uring_wop;      // for io_uring connect/send
 #endif
+    // warm
+    uint32_t    id; // fd cannot be used as unique identifier, so we provide an id
+    uint32_t            max_read_bufsize;
+    uint32_t            small_readbytes_cnt; // for readbuf autosize
+    uint32_t            read_batch;     // for hio_set_batch
+    uint32_t            event_cnt;      // for hio_take_event_count
+    struct sockaddr*    localaddr;
+    struct sockaddr*    peeraddr;
+    hclose_cb   close_cb;
+    haccept_cb  accept_cb;
+    hconnect_cb connect_cb;
+    hread_batch_cb read_batch_cb;
+    // zerocopy: written with MSG_ZEROCOPY, wait for notification to free
+    struct zerocopy_queue zerocopy_queue;   // locked by write_mutex
+    uint32_t            zerocopy_bufsize;
+    uint32_t            zerocopy_threshold; // for hio_set_zerocopy, 0: disabled
+    uint32_t            zerocopy_seq;       // next notification id
+    uint32_t            zerocopy_done;      // notifications received before this id
+    // cold
+    hio_ext_t*          ext;
+    hio_slab_t*         slab;
 };
+// @return io->ext, alloc if NULL
+hio_ext_t* hio_ext(hio_t* io);
+// read cold field without alloc, 0 if io->ext NULL
+#define hio_ext_field(io, field)    ((io)->ext ? (io)->ext->field : 0)
+
 /*
  * hio lifeline:
  *
@@ -207,13 +384,23 @@ void hio_init(hio_t* io);
 void hio_ready(hio_t* io);
 void hio_done(hio_t* io);
 void hio_free(hio_t* io);
+
+hio_slab_t* hio_slab_new();
+hio_t*      hio_slab_alloc(hio_slab_t* slab);
+void        hio_slab_free(hio_slab_t* slab, hio_t* io);
+// loop freed, slab destroyed when all hio_t returned.
+void        hio_slab_close(hio_slab_t* slab);
 uint32_t hio_next_id();
 
 void hio_accept_cb(hio_t* io);
 void hio_connect_cb(hio_t* io);
 void hio_handle_read(hio_t* io, void* buf, int readbytes);
 void hio_read_cb(hio_t* io, void* buf, int len);
+// packages of hio_unpack, @see hio_setcb_read_batch
+void hio_read_batch_cb(hio_t* io, hio_dgram_t* pkgs, int cnt);
 void hio_write_cb(hio_t* io, const void* buf, int len);
+// call high_water_cb or drained_cb if crossed, @see hio_set_write_water
+void hio_write_water_cb(hio_t* io);
 void hio_close_cb(hio_t* io);
 
 void hio_del_connect_timer(hio_t* io);
@@ -223,6 +410,9 @@ void hio_del_write_timer(hio_t* io);
 void hio_del_keepalive_timer(hio_t* io);
 void hio_del_heartbeat_timer(hio_t* io);
 
+// NOTE: same as htimer_add, but use loop->wheel, @see HTIMER_WHEEL_TICK
+htimer_t* htimer_add_wheel(hloop_t* loop, htimer_cb cb, uint32_t timeout_ms, uint32_t repeat);
+
 static inline void hio_use_loop_readbuf(hio_t* io) {
     hloop_t* loop = io->loop;
     if (loop->readbuf.len == 0) {
@@ -238,9 +428,19 @@ static inline bool hio_is_loop_readbuf(hio_t* io) {
 static inline bool hio_is_alloced_readbuf(hio_t* io) {
     return io->alloced_readbuf;
 }
+static inline bool hio_is_mirrored_readbuf(hio_t* io) {
+    return io->alloced_readbuf && io->mirror_readbuf;
+}
+// end of writable space, tail of mirrored readbuf can go beyond len.
+static inline size_t hio_readbuf_end(hio_t* io) {
+    return hio_is_mirrored_readbuf(io) ? io->readbuf.head + io->readbuf.len : io->readbuf.len;
+}
 void hio_alloc_readbuf(hio_t* io, int len);
 void hio_free_readbuf(hio_t* io);
+// NOTE: mirrored readbuf only wraps around, no memmove.
 void hio_memmove_readbuf(hio_t* io);
+// keep [data, data+len) in readbuf as unconsumed data, @see hio_unpack
+void hio_keep_readbuf(hio_t* io, const void* data, size_t len);
 
 #define EVENT_ENTRY(p)          container_of(p, hevent_t, pending_node)
 #define IDLE_ENTRY(p)           container_of(p, hidle_t,  node)
@@ -249,13 +449,13 @@ void hio_memmove_readbuf(hio_t* io);
 #define EVENT_ACTIVE(ev) \
     if (!ev->active) {\
         ev->active = 1;\
-        ev->loop->nactives++;\
+        hatomic_add_relaxed(&ev->loop->nactives, 1);\
     }\
 
 #define EVENT_INACTIVE(ev) \
     if (ev->active) {\
         ev->active = 0;\
-        ev->loop->nactives--;\
+        hatomic_add_relaxed(&ev->loop->nactives, -1);\
     }\
 
 // 将事件根据优先级放入对应的pendings队列中，以等待处理
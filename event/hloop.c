@@ -9,6 +9,7 @@
 #include "htime.h"
 #include "hsocket.h"
 #include "hthread.h"
+#include "hatomic.h"
 
 #if defined(OS_UNIX) && HAVE_EVENTFD
 #include "sys/eventfd.h"
@@ -19,11 +20,14 @@
 #define HLOOP_STAT_TIMEOUT      60000   // ms
 
 #define IO_ARRAY_INIT_SIZE              1024
-#define CUSTOM_EVENT_QUEUE_INIT_SIZE    16
 
 #define EVENTFDS_READ_INDEX     0
 #define EVENTFDS_WRITE_INDEX    1
 
+#define WHEEL_TICK_US           (HTIMER_WHEEL_TICK * 1000)
+#define WHEEL_SLOT_MASK         (HTIMER_WHEEL_SLOTS - 1)
+#define WHEEL_ENTRY(p)          container_of(p, htimeout_t, wheel_node)
+
 static void __hidle_del(hidle_t* idle);
 static void __htimer_del(htimer_t* timer);
 
@@ -52,7 +56,103 @@ static int hloop_process_idles(hloop_t* loop) {
     return nidles;
 }
 
-static int __hloop_process_timers(struct heap* timers, uint64_t timeout) {
+//-----------------timing wheel---------------------------------------------
+static void wheel_insert(hloop_t* loop, htimeout_t* timer) {
+    htimer_wheel_t* wheel = loop->wheel;
+    // NOTE: round up, timer fires at the first tick not earlier than next_timeout.
+    uint64_t tick = (timer->next_timeout + WHEEL_TICK_US - 1) / WHEEL_TICK_US;
+    if (tick < wheel->tick) tick = wheel->tick;
+    unsigned slot = tick & WHEEL_SLOT_MASK;
+    list_add_tail(&timer->wheel_node, &wheel->slots[slot]);
+    wheel->bitmap[slot >> 6] |= (uint64_t)1 << (slot & 63);
+    ++wheel->ntimers;
+    ++loop->timer_stats.wheel_inserts;
+}
+
+static void wheel_remove(hloop_t* loop, htimeout_t* timer) {
+    htimer_wheel_t* wheel = loop->wheel;
+    struct list_node* next = timer->wheel_node.next;
+    struct list_node* prev = timer->wheel_node.prev;
+    list_del(&timer->wheel_node);
+    // next == prev means slot list is empty now
+    if (next == prev) {
+        unsigned slot = (unsigned)(((struct list_head*)next) - wheel->slots);
+        if (slot < HTIMER_WHEEL_SLOTS) {
+            wheel->bitmap[slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+        }
+    }
+    --wheel->ntimers;
+    ++loop->timer_stats.wheel_removes;
+}
+
+// @return ticks to next non-empty slot, -1 if wheel empty
+static int64_t wheel_next_ticks(htimer_wheel_t* wheel) {
+    if (wheel->ntimers == 0) return -1;
+    unsigned start = wheel->tick & WHEEL_SLOT_MASK;
+    for (unsigned n = 0; n < HTIMER_WHEEL_SLOTS; ) {
+        unsigned slot = (start + n) & WHEEL_SLOT_MASK;
+        uint64_t bits = wheel->bitmap[slot >> 6] >> (slot & 63);
+        if (bits) {
+            unsigned i = 0;
+            while ((bits & 1) == 0) { bits >>= 1; ++i; }
+            return n + i;
+        }
+        n += 64 - (slot & 63);
+    }
+    return -1;
+}
+
+static int hloop_process_wheel(hloop_t* loop) {
+    htimer_wheel_t* wheel = loop->wheel;
+    uint64_t now_tick = loop->cur_hrtime / WHEEL_TICK_US;
+    if (now_tick < wheel->tick) return 0;
+    // NOTE: one round is enough after a long block, timers of later rounds are skipped by next_timeout.
+    uint64_t nticks = now_tick - wheel->tick + 1;
+    if (nticks > HTIMER_WHEEL_SLOTS) {
+        nticks = HTIMER_WHEEL_SLOTS;
+    }
+    int ntimers = 0;
+    uint64_t deadline = now_tick * WHEEL_TICK_US;
+    for (uint64_t i = 0; i < nticks; ++i) {
+        unsigned slot = (wheel->tick + i) & WHEEL_SLOT_MASK;
+        if ((wheel->bitmap[slot >> 6] & ((uint64_t)1 << (slot & 63))) == 0) continue;
+        struct list_head* head = &wheel->slots[slot];
+        struct list_node* node = head->next;
+        // NOTE: re-inserted timers go to tail, stop at the last node of this round.
+        struct list_node* last = head->prev;
+        while (node != head) {
+            htimeout_t* timer = WHEEL_ENTRY(node);
+            struct list_node* next = node->next;
+            int is_last = node == last;
+            if (timer->next_timeout <= deadline) {
+                if (timer->repeat != INFINITE) {
+                    --timer->repeat;
+                }
+                if (timer->repeat == 0) {
+                    // NOTE: Just mark it as destroy and remove from wheel.
+                    // Real deletion occurs after hloop_process_pendings.
+                    __htimer_del((htimer_t*)timer);
+                } else {
+                    wheel_remove(loop, timer);
+                    while (timer->next_timeout <= loop->cur_hrtime) {
+                        timer->next_timeout += (uint64_t)timer->timeout * 1000;
+                    }
+                    wheel_insert(loop, timer);
+                }
+                EVENT_PENDING(timer);
+                ++ntimers;
+                ++loop->timer_stats.wheel_expires;
+            }
+            if (is_last) break;
+            node = next;
+        }
+    }
+    loop->timer_stats.wheel_ticks += nticks;
+    wheel->tick = now_tick + 1;
+    return ntimers;
+}
+
+static int __hloop_process_timers(hloop_t* loop, struct heap* timers, uint64_t timeout) {
     int ntimers = 0;
     htimer_t* timer = NULL;
     while (timers->root) {
@@ -72,6 +172,7 @@ static int __hloop_process_timers(struct heap* timers, uint64_t timeout) {
         else {
             // NOTE: calc next timeout, then re-insert heap.
             heap_dequeue(timers);
+            ++loop->timer_stats.heap_removes;
             if (timer->event_type == HEVENT_TYPE_TIMEOUT) {
                 while (timer->next_timeout <= timeout) {
                     timer->next_timeout += (uint64_t)((htimeout_t*)timer)->timeout * 1000;
@@ -83,6 +184,7 @@ static int __hloop_process_timers(struct heap* timers, uint64_t timeout) {
                         period->week, period->month) * 1000000;
             }
             heap_insert(timers, &timer->node);
+            ++loop->timer_stats.heap_inserts;
         }
         EVENT_PENDING(timer);
         ++ntimers;
@@ -92,8 +194,11 @@ static int __hloop_process_timers(struct heap* timers, uint64_t timeout) {
 
 static int hloop_process_timers(hloop_t* loop) {
     uint64_t now = hloop_now_us(loop);
-    int ntimers = __hloop_process_timers(&loop->timers, loop->cur_hrtime);
-    ntimers +=    __hloop_process_timers(&loop->realtimers, now);
+    int ntimers = __hloop_process_timers(loop, &loop->timers, loop->cur_hrtime);
+    ntimers +=    __hloop_process_timers(loop, &loop->realtimers, now);
+    if (loop->wheel && loop->wheel->ntimers) {
+        ntimers += hloop_process_wheel(loop);
+    }
     return ntimers;
 }
 
@@ -106,6 +211,53 @@ static int hloop_process_ios(hloop_t* loop, int timeout) {
     return nevents < 0 ? 0 : nevents;
 }
 
+// @return -1 if not recorded
+static int hloop_event_hist(hevent_t* ev) {
+    switch (ev->event_type) {
+    case HEVENT_TYPE_IO:
+        // NOTE: custom events are recorded one by one in eventfd_read_cb
+        if (((hio_t*)ev)->fd == ev->loop->eventfds[EVENTFDS_READ_INDEX]) return -1;
+        return (((hio_t*)ev)->revents & HV_READ) ? HLOOP_HIST_IO_READ : HLOOP_HIST_IO_WRITE;
+    case HEVENT_TYPE_TIMEOUT:
+    case HEVENT_TYPE_PERIOD:
+        return HLOOP_HIST_TIMER;
+    case HEVENT_TYPE_IDLE:
+        return HLOOP_HIST_IDLE;
+    case HEVENT_TYPE_SIGNAL:
+        return HLOOP_HIST_SIGNAL;
+    default:
+        return HLOOP_HIST_CUSTOM;
+    }
+}
+
+// heartbeat for watchdog, @see hloop_watch
+static void hloop_callback_enter(hloop_t* loop, hevent_t* ev) {
+    hloop_stall_t* cur = &loop->cur_cb;
+    cur->event_type = ev->event_type;
+    cur->event_id = ev->event_id;
+    cur->fd = -1;
+    cur->cb = (void*)ev->cb;
+    if (ev->event_type == HEVENT_TYPE_IO) {
+        hio_t* io = (hio_t*)ev;
+        cur->fd = io->fd;
+        if (io->accept) {
+            cur->cb = (void*)io->accept_cb;
+        } else if (io->connect) {
+            cur->cb = (void*)io->connect_cb;
+        } else if (io->revents & HV_READ) {
+            cur->cb = (void*)io->read_cb;
+        } else {
+            cur->cb = (void*)io->write_cb;
+        }
+    }
+    hatomic_long_add(&loop->cb_seq, 1);
+}
+
+static void hloop_callback_leave(hloop_t* loop) {
+    loop->cur_cb.event_type = HEVENT_TYPE_NONE;
+    hatomic_long_add(&loop->cb_seq, 1);
+}
+
 static int hloop_process_pendings(hloop_t* loop) {
     if (loop->npendings == 0) return 0;
 
@@ -119,7 +271,20 @@ static int hloop_process_pendings(hloop_t* loop) {
             next = cur->pending_next;
             if (cur->pending && cur->loop == loop) {
                 if (cur->active && cur->cb) {
-                    cur->cb(cur);
+                    if (loop->watched) hloop_callback_enter(loop, cur);
+                    if (loop->flags & HLOOP_FLAG_STATS) {
+                        int hist = hloop_event_hist(cur);
+                        uint64_t start_hrtime = gethrtime_us();
+                        cur->cb(cur);
+                        if (hist >= 0) {
+                            HLOOP_STATS_WRITE_BEGIN(loop);
+                            hloop_histogram_add(&loop->stats.hists[hist], gethrtime_us() - start_hrtime);
+                            HLOOP_STATS_WRITE_END(loop);
+                        }
+                    } else {
+                        cur->cb(cur);
+                    }
+                    if (loop->watched) hloop_callback_leave(loop);
                     ++ncbs;
                 }
                 cur->pending = 0;
@@ -136,11 +301,16 @@ static int hloop_process_pendings(hloop_t* loop) {
     return ncbs;
 }
 
+static void hloop_process_migrations(hloop_t* loop);
+
 // hloop_process_ios -> hloop_process_timers -> hloop_process_idles -> hloop_process_pendings
 int hloop_process_events(hloop_t* loop, int timeout_ms) {
     // ios -> timers -> idles
     int nios, ntimers, nidles;
     nios = ntimers = nidles = 0;
+    int collect_stats = loop->flags & HLOOP_FLAG_STATS;
+    uint64_t start_hrtime = collect_stats ? gethrtime_us() : 0;
+    uint64_t poll_us = 0;
 
     // calc blocktime
     int32_t blocktime_ms = timeout_ms;
@@ -155,17 +325,53 @@ int hloop_process_events(hloop_t* loop, int timeout_ms) {
             int64_t min_timeout = TIMER_ENTRY(loop->realtimers.root)->next_timeout - hloop_now_us(loop);
             blocktime_us = MIN(blocktime_us, min_timeout);
         }
+        if (loop->wheel) {
+            int64_t nticks = wheel_next_ticks(loop->wheel);
+            if (nticks >= 0) {
+                int64_t min_timeout = (int64_t)((loop->wheel->tick + nticks) * WHEEL_TICK_US) - (int64_t)loop->cur_hrtime;
+                blocktime_us = MIN(blocktime_us, min_timeout);
+            }
+        }
         if (blocktime_us < 0) goto process_timers;
         blocktime_ms = blocktime_us / 1000 + 1;
         blocktime_ms = MIN(blocktime_ms, timeout_ms);
     }
 
+    if (collect_stats) poll_us = gethrtime_us();
+    loop->in_poll = 1;
+    int spinning = 0;
     if (loop->nios) {
+        if ((loop->flags & HLOOP_FLAG_BUSY_POLL) && loop->cur_hrtime < loop->busy_poll_deadline) {
+            // NOTE: spin while busy, avoid the wakeup latency of blocking poll
+            blocktime_ms = 0;
+            spinning = 1;
+        }
         nios = hloop_process_ios(loop, blocktime_ms);
     } else {
         hv_msleep(blocktime_ms);
     }
+    loop->in_poll = 0;
     hloop_update_time(loop);
+    if (collect_stats) {
+        poll_us = loop->cur_hrtime - poll_us;
+        HLOOP_STATS_WRITE_BEGIN(loop);
+        hloop_histogram_add(&loop->stats.hists[HLOOP_HIST_POLL], poll_us);
+        HLOOP_STATS_WRITE_END(loop);
+    }
+    if ((loop->flags & HLOOP_FLAG_BUSY_POLL) && loop->nios) {
+        hloop_busy_poll_stats_t* stats = &loop->busy_poll_stats;
+        // NOTE: zero timeout due to timers is neither a spin nor a sleep.
+        if (spinning) {
+            ++stats->spins;
+            if (nios) ++stats->spin_hits;
+        } else if (blocktime_ms > 0) {
+            ++stats->sleeps;
+            if (nios) ++stats->wakeups;
+        }
+        if (nios) {
+            loop->busy_poll_deadline = loop->cur_hrtime + loop->busy_poll_us;
+        }
+    }
     // wakeup by hloop_stop
     if (loop->status == HLOOP_STATUS_STOP) {
         return 0;
@@ -183,6 +389,14 @@ process_timers:
         }
     }
     int ncbs = hloop_process_pendings(loop);
+    if (loop->migrations.size) {
+        hloop_process_migrations(loop);
+    }
+    if (collect_stats) {
+        HLOOP_STATS_WRITE_BEGIN(loop);
+        hloop_histogram_add(&loop->stats.hists[HLOOP_HIST_ITERATION], gethrtime_us() - start_hrtime - poll_us);
+        HLOOP_STATS_WRITE_END(loop);
+    }
     // printd("blocktime=%d nios=%d/%u ntimers=%d/%u nidles=%d/%u nactives=%d npendings=%d ncbs=%d\n",
     //         blocktime, nios, loop->nios, ntimers, loop->ntimers, nidles, loop->nidles,
     //         loop->nactives, npendings, ncbs);
@@ -199,38 +413,123 @@ static void hloop_stat_timer_cb(htimer_t* timer) {
         (unsigned long long)loop->cur_hrtime - loop->start_hrtime,
         (unsigned long long)loop->loop_cnt,
         loop->nactives, loop->nios, loop->ntimers, loop->nidles);
+    if (loop->flags & HLOOP_FLAG_STATS) {
+        for (int i = 0; i < HLOOP_HIST_MAX; ++i) {
+            hloop_histogram_t* hist = &loop->stats.hists[i];
+            if (hist->count == 0) continue;
+            hlogd("[loop] %s count=%llu avg=%lluus p99=%lluus max=%lluus", hloop_hist_str((hloop_hist_e)i),
+                (unsigned long long)hist->count,
+                (unsigned long long)(hist->sum / hist->count),
+                (unsigned long long)hloop_histogram_percentile(hist, 99),
+                (unsigned long long)hist->max);
+        }
+    }
 }
 #endif
 
+// custom event copied by hloop_post_event
+typedef struct hcustom_event_s {
+    hevent_t    ev;
+    uint64_t    post_hrtime; // for HLOOP_HIST_CUSTOM_LATENCY
+} hcustom_event_t;
+
+#define HLOOP_MAX_FREE_CUSTOM_EVENTS    1024
+
+static hcustom_event_t* hloop_alloc_custom_event(hloop_t* loop) {
+    hevent_t* head = NULL;
+    // NOTE: only one poster pops at a time to avoid ABA, the others just allocate.
+    if (hatomic_long_exchange(&loop->custom_events_free_lock, 1) == 0) {
+        do {
+            head = (hevent_t*)hatomic_ptr_load(&loop->custom_events_free);
+        } while (head && !hatomic_ptr_cas(&loop->custom_events_free, head, head->pending_next));
+        hatomic_long_exchange(&loop->custom_events_free_lock, 0);
+    }
+    hcustom_event_t* cev = (hcustom_event_t*)head;
+    if (cev) {
+        hatomic_long_add(&loop->custom_events_nfree, -1);
+    } else {
+        HV_ALLOC_SIZEOF(cev);
+    }
+    return cev;
+}
+
+// @param head..tail: list linked by pending_next, popped by loop thread
+static void hloop_recycle_custom_events(hloop_t* loop, hevent_t* head, hevent_t* tail, long n) {
+    hatomic_long_add(&loop->custom_events_nfree, n);
+    void* top = NULL;
+    do {
+        top = hatomic_ptr_load(&loop->custom_events_free);
+        tail->pending_next = (hevent_t*)top;
+    } while (!hatomic_ptr_cas(&loop->custom_events_free, top, head));
+}
+
+// @return FIFO list of custom events
+static hevent_t* hloop_pop_custom_events(hloop_t* loop) {
+    hevent_t* head = (hevent_t*)hatomic_ptr_exchange(&loop->custom_events, NULL);
+    // LIFO => FIFO
+    hevent_t* prev = NULL;
+    hevent_t* next = NULL;
+    long npops = 0;
+    while (head) {
+        next = head->pending_next;
+        head->pending_next = prev;
+        prev = head;
+        head = next;
+        ++npops;
+    }
+    if (npops) {
+        long depth = hatomic_long_add(&loop->custom_events_depth, -npops);
+        if ((uint64_t)depth > loop->stats.custom_events_max_depth) {
+            HLOOP_STATS_WRITE_BEGIN(loop);
+            hatomic_store_relaxed(&loop->stats.custom_events_max_depth, (uint64_t)depth);
+            HLOOP_STATS_WRITE_END(loop);
+        }
+    }
+    return prev;
+}
+
 static void eventfd_read_cb(hio_t* io, void* buf, int readbytes) {
     hloop_t* loop = io->loop;
-    hevent_t* pev = NULL;
-    hevent_t ev;
-    uint64_t count = readbytes;
-#if defined(OS_UNIX) && HAVE_EVENTFD
-    assert(readbytes == sizeof(count));
-    count = *(uint64_t*)buf;
-#endif
-    for (uint64_t i = 0; i < count; ++i) {
-        hmutex_lock(&loop->custom_events_mutex);
-        if (event_queue_empty(&loop->custom_events)) {
-            goto unlock;
+    // NOTE: clear wakeup flag before pop, hloop_post_event after this will write eventfd again.
+    hatomic_long_exchange(&loop->custom_events_wakeup, 0);
+    hevent_t* pev = hloop_pop_custom_events(loop);
+    hevent_t* next = NULL;
+    hevent_t* free_head = NULL;
+    hevent_t* free_tail = NULL;
+    long nfree = 0;
+    long max_nfree = HLOOP_MAX_FREE_CUSTOM_EVENTS - hatomic_long_add(&loop->custom_events_nfree, 0);
+    while (pev) {
+        next = pev->pending_next;
+        pev->pending_next = NULL;
+        if (pev->cb) {
+            if (loop->watched) hloop_callback_enter(loop, pev);
+            uint64_t post_hrtime = ((hcustom_event_t*)pev)->post_hrtime;
+            if ((loop->flags & HLOOP_FLAG_STATS) && post_hrtime) {
+                uint64_t start_hrtime = gethrtime_us();
+                pev->cb(pev);
+                uint64_t end_hrtime = gethrtime_us();
+                HLOOP_STATS_WRITE_BEGIN(loop);
+                hloop_histogram_add(&loop->stats.hists[HLOOP_HIST_CUSTOM_LATENCY], start_hrtime - post_hrtime);
+                hloop_histogram_add(&loop->stats.hists[HLOOP_HIST_CUSTOM], end_hrtime - start_hrtime);
+                HLOOP_STATS_WRITE_END(loop);
+            } else {
+                pev->cb(pev);
+            }
+            if (loop->watched) hloop_callback_leave(loop);
         }
-        pev = event_queue_front(&loop->custom_events);
-        if (pev == NULL) {
-            goto unlock;
-        }
-        ev = *pev;
-        event_queue_pop_front(&loop->custom_events);
-        // NOTE: unlock before cb, avoid deadlock if hloop_post_event called in cb.
-        hmutex_unlock(&loop->custom_events_mutex);
-        if (ev.cb) {
-            ev.cb(&ev);
+        if (nfree < max_nfree) {
+            pev->pending_next = free_head;
+            free_head = pev;
+            if (free_tail == NULL) free_tail = pev;
+            ++nfree;
+        } else {
+            HV_FREE(pev);
         }
+        pev = next;
+    }
+    if (nfree) {
+        hloop_recycle_custom_events(loop, free_head, free_tail, nfree);
     }
-    return;
-unlock:
-    hmutex_unlock(&loop->custom_events_mutex);
 }
 
 static int hloop_create_eventfds(hloop_t* loop) {
@@ -284,13 +583,32 @@ void hloop_post_event(hloop_t* loop, hevent_t* ev) {
         ev->event_id = hloop_next_event_id();
     }
 
-    int nwrite = 0;
-    hmutex_lock(&loop->custom_events_mutex);
     if (loop->eventfds[EVENTFDS_WRITE_INDEX] == -1) {
-        if (hloop_create_eventfds(loop) != 0) {
-            goto unlock;
+        hmutex_lock(&loop->custom_events_mutex);
+        if (loop->eventfds[EVENTFDS_WRITE_INDEX] == -1) {
+            hloop_create_eventfds(loop);
         }
+        hmutex_unlock(&loop->custom_events_mutex);
+    }
+
+    hcustom_event_t* cev = hloop_alloc_custom_event(loop);
+    cev->ev = *ev;
+    cev->post_hrtime = (loop->flags & HLOOP_FLAG_STATS) ? gethrtime_us() : 0;
+    hevent_t* pev = &cev->ev;
+    hatomic_long_add(&loop->custom_events_posted, 1);
+    hatomic_long_add(&loop->custom_events_depth, 1);
+    // push front, lock-free
+    void* head = NULL;
+    do {
+        head = hatomic_ptr_load(&loop->custom_events);
+        pev->pending_next = (hevent_t*)head;
+    } while (!hatomic_ptr_cas(&loop->custom_events, head, pev));
+
+    // NOTE: only the first post after eventfd_read_cb writes eventfd.
+    if (hatomic_long_exchange(&loop->custom_events_wakeup, 1) != 0) {
+        return;
     }
+    int nwrite = 0;
 #if defined(OS_UNIX) && HAVE_EVENTFD
     uint64_t count = 1;
     nwrite = write(loop->eventfds[EVENTFDS_WRITE_INDEX], &count, sizeof(count));
@@ -301,14 +619,9 @@ void hloop_post_event(hloop_t* loop, hevent_t* ev) {
 #endif
     if (nwrite <= 0) {
         hloge("hloop_post_event failed!");
-        goto unlock;
-    }
-    if (loop->custom_events.maxsize == 0) {
-        event_queue_init(&loop->custom_events, CUSTOM_EVENT_QUEUE_INIT_SIZE);
+        // NOTE: let next post try again
+        hatomic_long_exchange(&loop->custom_events_wakeup, 0);
     }
-    event_queue_push_back(&loop->custom_events, ev);
-unlock:
-    hmutex_unlock(&loop->custom_events_mutex);
 }
 
 static void hloop_init(hloop_t* loop) {
@@ -334,6 +647,7 @@ static void hloop_init(hloop_t* loop) {
     // ios
     // NOTE: io_array_init when hio_get -> io_array_resize
     // io_array_init(&loop->ios, IO_ARRAY_INIT_SIZE);
+    loop->ioslab = hio_slab_new();
 
     // readbuf
     // NOTE: alloc readbuf when hio_use_loop_readbuf
@@ -345,12 +659,16 @@ static void hloop_init(hloop_t* loop) {
 
     // custom_events
     hmutex_init(&loop->custom_events_mutex);
+    hmutex_init(&loop->stalls_mutex);
     // NOTE: hloop_create_eventfds when hloop_post_event or hloop_run
     loop->eventfds[0] = loop->eventfds[1] = -1;
 
     // NOTE: init start_time here, because htimer_add use it.
     loop->start_ms = gettimeofday_ms();
     loop->start_hrtime = loop->cur_hrtime = gethrtime_us();
+
+    // busy poll
+    loop->busy_poll_us = HLOOP_DEFAULT_BUSY_POLL_TIME;
 }
 
 static void hloop_cleanup(hloop_t* loop) {
@@ -369,6 +687,10 @@ static void hloop_cleanup(hloop_t* loop) {
         }
     }
     io_array_cleanup(&loop->ios);
+    migration_array_cleanup(&loop->migrations);
+    // NOTE: detached ios may still alive in other loops.
+    hio_slab_close(loop->ioslab);
+    loop->ioslab = NULL;
 
     // idles
     printd("cleanup idles...\n");
@@ -396,6 +718,18 @@ static void hloop_cleanup(hloop_t* loop) {
         HV_FREE(timer);
     }
     heap_init(&loop->realtimers, NULL);
+    if (loop->wheel) {
+        for (int i = 0; i < HTIMER_WHEEL_SLOTS; ++i) {
+            struct list_head* head = &loop->wheel->slots[i];
+            struct list_node* node = head->next;
+            while (node != head) {
+                timer = (htimer_t*)WHEEL_ENTRY(node);
+                node = node->next;
+                HV_FREE(timer);
+            }
+        }
+        HV_FREE(loop->wheel);
+    }
 
     // signals
     printd("cleanup signals...\n");
@@ -411,6 +745,11 @@ static void hloop_cleanup(hloop_t* loop) {
         loop->readbuf.base = NULL;
         loop->readbuf.len = 0;
     }
+    if (loop->mmsgbuf.base && loop->mmsgbuf.len) {
+        HV_FREE(loop->mmsgbuf.base);
+        loop->mmsgbuf.base = NULL;
+        loop->mmsgbuf.len = 0;
+    }
 
     // iowatcher
     iowatcher_cleanup(loop);
@@ -418,9 +757,23 @@ static void hloop_cleanup(hloop_t* loop) {
     // custom_events
     hmutex_lock(&loop->custom_events_mutex);
     hloop_destroy_eventfds(loop);
-    event_queue_cleanup(&loop->custom_events);
     hmutex_unlock(&loop->custom_events_mutex);
+    hevent_t* pev = hloop_pop_custom_events(loop);
+    hevent_t* next = NULL;
+    while (pev) {
+        next = pev->pending_next;
+        HV_FREE(pev);
+        pev = next;
+    }
+    pev = (hevent_t*)hatomic_ptr_exchange(&loop->custom_events_free, NULL);
+    while (pev) {
+        next = pev->pending_next;
+        HV_FREE(pev);
+        pev = next;
+    }
+    loop->custom_events_nfree = 0;
     hmutex_destroy(&loop->custom_events_mutex);
+    hmutex_destroy(&loop->stalls_mutex);
 }
 
 hloop_t* hloop_new(int flags) {
@@ -438,6 +791,9 @@ void hloop_free(hloop_t** pp) {
     if (loop->status == HLOOP_STATUS_DESTROY) return;
     loop->status = HLOOP_STATUS_DESTROY;
     hlogd("hloop_free tid=%ld", hv_gettid());
+    if (loop->watched) {
+        hloop_unwatch(loop);
+    }
     hloop_cleanup(loop);
     HV_FREE(loop);
     *pp = NULL;
@@ -472,7 +828,7 @@ int hloop_run(hloop_t* loop) {
             hloop_update_time(loop);
             continue;
         }
-        ++loop->loop_cnt;
+        hatomic_add_relaxed(&loop->loop_cnt, 1);
         if ((loop->flags & HLOOP_FLAG_QUIT_WHEN_NO_ACTIVE_EVENTS) &&
             loop->nactives <= loop->intern_nevents) {
             break;
@@ -571,23 +927,184 @@ long hloop_tid(hloop_t* loop) {
 }
 
 uint64_t hloop_count(hloop_t* loop) {
-    return loop->loop_cnt;
+    return hatomic_load_relaxed(&loop->loop_cnt);
 }
 
 uint32_t hloop_nios(hloop_t* loop) {
-    return loop->nios;
+    return hatomic_load_relaxed(&loop->nios);
 }
 
 uint32_t hloop_ntimers(hloop_t* loop) {
-    return loop->ntimers;
+    return hatomic_load_relaxed(&loop->ntimers);
 }
 
 uint32_t hloop_nidles(hloop_t* loop) {
-    return loop->nidles;
+    return hatomic_load_relaxed(&loop->nidles);
 }
 
 uint32_t hloop_nactives(hloop_t* loop) {
-    return loop->nactives;
+    return hatomic_load_relaxed(&loop->nactives);
+}
+
+void hloop_timer_stats(hloop_t* loop, htimer_stats_t* stats) {
+    *stats = loop->timer_stats;
+    stats->wheel_timers = loop->wheel ? loop->wheel->ntimers : 0;
+    stats->heap_timers = loop->ntimers - stats->wheel_timers;
+}
+
+void hloop_set_busy_poll(hloop_t* loop, uint32_t spin_us, int sock_busy_poll_us) {
+    loop->busy_poll_us = spin_us;
+    loop->sock_busy_poll_us = sock_busy_poll_us;
+    if (spin_us) {
+        loop->flags |= HLOOP_FLAG_BUSY_POLL;
+    } else {
+        loop->flags &= ~HLOOP_FLAG_BUSY_POLL;
+    }
+}
+
+void hloop_busy_poll_stats(hloop_t* loop, hloop_busy_poll_stats_t* stats) {
+    *stats = loop->busy_poll_stats;
+}
+
+void hloop_histogram_add(hloop_histogram_t* hist, uint64_t us) {
+    int idx = 0;
+    if (us) {
+        // floor(log2(us)) + 1
+        uint64_t v = us;
+        while (v && idx < HLOOP_HISTOGRAM_BUCKETS - 1) {
+            v >>= 1;
+            ++idx;
+        }
+    }
+    // NOTE: relaxed stores for hloop_stats from other threads
+    hatomic_add_relaxed(&hist->buckets[idx], 1);
+    hatomic_add_relaxed(&hist->count, 1);
+    hatomic_add_relaxed(&hist->sum, us);
+    if (us > hist->max) hatomic_store_relaxed(&hist->max, us);
+}
+
+void hloop_histogram_merge(hloop_histogram_t* dst, const hloop_histogram_t* src) {
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->max > dst->max) dst->max = src->max;
+    for (int i = 0; i < HLOOP_HISTOGRAM_BUCKETS; ++i) {
+        dst->buckets[i] += src->buckets[i];
+    }
+}
+
+uint64_t hloop_histogram_percentile(const hloop_histogram_t* hist, double percent) {
+    if (hist->count == 0) return 0;
+    uint64_t rank = (uint64_t)(hist->count * percent / 100);
+    if (rank >= hist->count) rank = hist->count - 1;
+    uint64_t cnt = 0;
+    for (int i = 0; i < HLOOP_HISTOGRAM_BUCKETS; ++i) {
+        cnt += hist->buckets[i];
+        if (cnt > rank) {
+            // bucket i: [2^(i-1), 2^i)
+            uint64_t upper = (uint64_t)1 << i;
+            return i == HLOOP_HISTOGRAM_BUCKETS - 1 || upper > hist->max ? hist->max : upper;
+        }
+    }
+    return hist->max;
+}
+
+const char* hloop_hist_str(hloop_hist_e hist) {
+    switch (hist) {
+    case HLOOP_HIST_ITERATION:      return "iteration";
+    case HLOOP_HIST_POLL:           return "poll";
+    case HLOOP_HIST_IO_READ:        return "io_read";
+    case HLOOP_HIST_IO_WRITE:       return "io_write";
+    case HLOOP_HIST_TIMER:          return "timer";
+    case HLOOP_HIST_IDLE:           return "idle";
+    case HLOOP_HIST_SIGNAL:         return "signal";
+    case HLOOP_HIST_CUSTOM:         return "custom";
+    case HLOOP_HIST_CUSTOM_LATENCY: return "custom_latency";
+    default:                        return "unknown";
+    }
+}
+
+void hloop_enable_stats(hloop_t* loop, int on) {
+    if (on) {
+        loop->flags |= HLOOP_FLAG_STATS;
+    } else {
+        loop->flags &= ~HLOOP_FLAG_STATS;
+    }
+}
+
+void hloop_stats(hloop_t* loop, hloop_stats_t* stats) {
+    const hloop_stats_t* src = &loop->stats;
+    const uint64_t* hists = (const uint64_t*)src->hists;
+    uint64_t* dst_hists = (uint64_t*)stats->hists;
+    uint64_t seq = 0;
+    // seqlock: retry if the loop thread wrote meanwhile
+    do {
+        seq = hatomic_load_acquire(&loop->stats_seq);
+        stats->custom_events_max_depth = hatomic_load_relaxed(&src->custom_events_max_depth);
+        stats->migrated_in = hatomic_load_relaxed(&src->migrated_in);
+        stats->migrated_out = hatomic_load_relaxed(&src->migrated_out);
+        stats->ssl_handshakes = hatomic_load_relaxed(&src->ssl_handshakes);
+        stats->ssl_resumed = hatomic_load_relaxed(&src->ssl_resumed);
+        stats->ktls_tx = hatomic_load_relaxed(&src->ktls_tx);
+        stats->ktls_rx = hatomic_load_relaxed(&src->ktls_rx);
+        for (size_t i = 0; i < sizeof(src->hists) / sizeof(uint64_t); ++i) {
+            dst_hists[i] = hatomic_load_relaxed(&hists[i]);
+        }
+        hatomic_fence_acquire();
+    } while ((seq & 1) || seq != hatomic_load_relaxed(&loop->stats_seq));
+    stats->loop_cnt = hatomic_load_relaxed(&loop->loop_cnt);
+    stats->nactives = hatomic_load_relaxed(&loop->nactives);
+    stats->nios = hatomic_load_relaxed(&loop->nios);
+    stats->ntimers = hatomic_load_relaxed(&loop->ntimers);
+    stats->nidles = hatomic_load_relaxed(&loop->nidles);
+    stats->custom_events_posted = hatomic_load_relaxed(&loop->custom_events_posted);
+    stats->custom_events_depth = hatomic_load_relaxed(&loop->custom_events_depth);
+    hmutex_lock(&loop->stalls_mutex);
+    stats->stalls = src->stalls;
+    stats->nslowest = src->nslowest;
+    memcpy(stats->slowest, src->slowest, sizeof(src->slowest));
+    hmutex_unlock(&loop->stalls_mutex);
+}
+
+void hloop_stats_merge(hloop_stats_t* dst, const hloop_stats_t* src) {
+    dst->loop_cnt += src->loop_cnt;
+    dst->nactives += src->nactives;
+    dst->nios += src->nios;
+    dst->ntimers += src->ntimers;
+    dst->nidles += src->nidles;
+    dst->custom_events_posted += src->custom_events_posted;
+    dst->custom_events_depth += src->custom_events_depth;
+    dst->migrated_in += src->migrated_in;
+    dst->migrated_out += src->migrated_out;
+    dst->ssl_handshakes += src->ssl_handshakes;
+    dst->ssl_resumed += src->ssl_resumed;
+    dst->ktls_tx += src->ktls_tx;
+    dst->ktls_rx += src->ktls_rx;
+    if (src->custom_events_max_depth > dst->custom_events_max_depth) {
+        dst->custom_events_max_depth = src->custom_events_max_depth;
+    }
+    for (int i = 0; i < HLOOP_HIST_MAX; ++i) {
+        hloop_histogram_merge(&dst->hists[i], &src->hists[i]);
+    }
+    dst->stalls += src->stalls;
+    for (uint32_t i = 0; i < src->nslowest; ++i) {
+        hloop_stall_add_slowest(dst, &src->slowest[i]);
+    }
+}
+
+void hloop_stall_add_slowest(hloop_stats_t* stats, const hloop_stall_t* stall) {
+    // insertion sort by duration desc, drop the fastest one if full
+    uint32_t n = stats->nslowest;
+    if (n == HLOOP_MAX_STALLS) {
+        if (stall->duration <= stats->slowest[n-1].duration) return;
+        --n;
+    }
+    uint32_t i = n;
+    while (i > 0 && stats->slowest[i-1].duration < stall->duration) {
+        stats->slowest[i] = stats->slowest[i-1];
+        --i;
+    }
+    stats->slowest[i] = *stall;
+    stats->nslowest = n + 1;
 }
 
 void  hloop_set_userdata(hloop_t* loop, void* userdata) {
@@ -655,7 +1172,7 @@ hidle_t* hidle_add(hloop_t* loop, hidle_cb cb, uint32_t repeat) {
     idle->repeat = repeat;
     list_add(&idle->node, &loop->idles);
     EVENT_ADD(loop, idle, cb);
-    loop->nidles++;
+    hatomic_add_relaxed(&loop->nidles, 1);
     return idle;
 }
 
@@ -663,7 +1180,7 @@ static void __hidle_del(hidle_t* idle) {
     if (idle->destroy) return;
     idle->destroy = 1;
     list_del(&idle->node);
-    idle->loop->nidles--;
+    hatomic_add_relaxed(&idle->loop->nidles, -1);
 }
 
 void hidle_del(hidle_t* idle) {
@@ -687,8 +1204,33 @@ htimer_t* htimer_add(hloop_t* loop, htimer_cb cb, uint32_t timeout_ms, uint32_t
         timer->next_timeout = timer->next_timeout / 100000 * 100000;
     }
     heap_insert(&loop->timers, &timer->node);
+    ++loop->timer_stats.heap_inserts;
+    EVENT_ADD(loop, timer, cb);
+    hatomic_add_relaxed(&loop->ntimers, 1);
+    return (htimer_t*)timer;
+}
+
+htimer_t* htimer_add_wheel(hloop_t* loop, htimer_cb cb, uint32_t timeout_ms, uint32_t repeat) {
+    if (timeout_ms == 0)   return NULL;
+    if (loop->wheel == NULL) {
+        HV_ALLOC_SIZEOF(loop->wheel);
+        for (int i = 0; i < HTIMER_WHEEL_SLOTS; ++i) {
+            list_init(&loop->wheel->slots[i]);
+        }
+        hloop_update_time(loop);
+        loop->wheel->tick = loop->cur_hrtime / WHEEL_TICK_US;
+    }
+    htimeout_t* timer;
+    HV_ALLOC_SIZEOF(timer);
+    timer->event_type = HEVENT_TYPE_TIMEOUT;
+    timer->priority = HEVENT_HIGHEST_PRIORITY;
+    timer->repeat = repeat;
+    timer->timeout = timeout_ms;
+    timer->wheel = 1;
+    timer->next_timeout = loop->cur_hrtime + (uint64_t)timeout_ms * 1000;
+    wheel_insert(loop, timer);
     EVENT_ADD(loop, timer, cb);
-    loop->ntimers++;
+    hatomic_add_relaxed(&loop->ntimers, 1);
     return (htimer_t*)timer;
 }
 
@@ -698,10 +1240,28 @@ void htimer_reset(htimer_t* timer, uint32_t timeout_ms) {
     }
     hloop_t* loop = timer->loop;
     htimeout_t* timeout = (htimeout_t*)timer;
+    if (timeout->wheel) {
+        if (timer->destroy) {
+            hatomic_add_relaxed(&loop->ntimers, 1);
+        } else {
+            wheel_remove(loop, timeout);
+        }
+        if (timer->repeat == 0) {
+            timer->repeat = 1;
+        }
+        if (timeout_ms > 0) {
+            timeout->timeout = timeout_ms;
+        }
+        timer->next_timeout = loop->cur_hrtime + (uint64_t)timeout->timeout * 1000;
+        wheel_insert(loop, timeout);
+        EVENT_RESET(timer);
+        return;
+    }
     if (timer->destroy) {
-        loop->ntimers++;
+        hatomic_add_relaxed(&loop->ntimers, 1);
     } else {
         heap_remove(&loop->timers, &timer->node);
+        ++loop->timer_stats.heap_removes;
     }
     if (timer->repeat == 0) {
         timer->repeat = 1;
@@ -715,6 +1275,7 @@ void htimer_reset(htimer_t* timer, uint32_t timeout_ms) {
         timer->next_timeout = timer->next_timeout / 100000 * 100000;
     }
     heap_insert(&loop->timers, &timer->node);
+    ++loop->timer_stats.heap_inserts;
     EVENT_RESET(timer);
 }
 
@@ -736,19 +1297,26 @@ htimer_t* htimer_add_period(hloop_t* loop, htimer_cb cb,
     timer->week   = week;
     timer->next_timeout = (uint64_t)cron_next_timeout(minute, hour, day, week, month) * 1000000;
     heap_insert(&loop->realtimers, &timer->node);
+    ++loop->timer_stats.heap_inserts;
     EVENT_ADD(loop, timer, cb);
-    loop->ntimers++;
+    hatomic_add_relaxed(&loop->ntimers, 1);
     return (htimer_t*)timer;
 }
 
 static void __htimer_del(htimer_t* timer) {
     if (timer->destroy) return;
     if (timer->event_type == HEVENT_TYPE_TIMEOUT) {
-        heap_remove(&timer->loop->timers, &timer->node);
+        if (((htimeout_t*)timer)->wheel) {
+            wheel_remove(timer->loop, (htimeout_t*)timer);
+        } else {
+            heap_remove(&timer->loop->timers, &timer->node);
+            ++timer->loop->timer_stats.heap_removes;
+        }
     } else if (timer->event_type == HEVENT_TYPE_PERIOD) {
         heap_remove(&timer->loop->realtimers, &timer->node);
+        ++timer->loop->timer_stats.heap_removes;
     }
-    timer->loop->ntimers--;
+    hatomic_add_relaxed(&timer->loop->ntimers, -1);
     timer->destroy = 1;
 }
 
@@ -790,7 +1358,7 @@ static inline hio_t* __hio_get(hloop_t* loop, int fd) {
 hio_t* hio_get(hloop_t* loop, int fd) {
     hio_t* io = __hio_get(loop, fd);
     if (io == NULL) {
-        HV_ALLOC_SIZEOF(io);
+        io = hio_slab_alloc(loop->ioslab);
         hio_init(io);
         io->event_type = HEVENT_TYPE_IO;
         io->loop = loop;
@@ -822,11 +1390,153 @@ void hio_attach(hloop_t* loop, hio_t* io) {
     }
 
     io->loop = loop;
-    // NOTE: use new_loop readbuf
-    hio_use_loop_readbuf(io);
+    // NOTE: use new_loop readbuf, alloced readbuf is owned by io.
+    if (!hio_is_alloced_readbuf(io)) {
+        hio_use_loop_readbuf(io);
+    }
     loop->ios.ptr[fd] = io;
 }
 
+//-----------------migrate---------------------------------------------
+// in dst loop thread
+static void hio_migrate_in(hevent_t* ev) {
+    hio_migration_t* m = (hio_migration_t*)ev->userdata;
+    hloop_t* loop = ev->loop;
+    hio_t* io = m->io;
+    hrecursive_mutex_lock(&io->write_mutex);
+    io->migrating = 0;
+    hio_attach(loop, io);
+    if (io->closed) {
+        hrecursive_mutex_unlock(&io->write_mutex);
+        HV_FREE(m);
+        return;
+    }
+    // NOTE: io->events kept when detached, maybe changed by hio_add/hio_del since.
+    int events = io->events;
+    io->events = 0;
+    if (events) {
+        hio_add(io, (hio_cb)io->cb, events);
+    }
+    if (m->read_timeout) {
+        hio_set_read_timeout(io, m->read_timeout);
+    }
+    if (m->write_timeout) {
+        hio_set_write_timeout(io, m->write_timeout);
+    }
+    if (m->keepalive_timeout) {
+        hio_set_keepalive_timeout(io, m->keepalive_timeout);
+    }
+    if (m->heartbeat_interval) {
+        hio_set_heartbeat(io, m->heartbeat_interval, m->heartbeat_fn);
+    }
+    HLOOP_STATS_ADD(loop, migrated_in, 1);
+    hrecursive_mutex_unlock(&io->write_mutex);
+    if (m->cb) {
+        m->cb(io, m->userdata);
+    }
+    HV_FREE(m);
+}
+
+// in src loop thread, no callback running.
+// @return -1 if io still pending, retry in next loop
+static int hio_migrate_out(hio_migration_t* m) {
+    hloop_t* loop = m->src;
+    hio_t* io = m->io;
+    // NOTE: io maybe closed or reused by another connection after hio_migrate.
+    if (io->id != m->id || io->loop != loop || io->closed || io->close || io->destroy) {
+        return 0;
+    }
+    // NOTE: io still linked in pendings added by higher priority callbacks.
+    if (io->pending) return -1;
+
+    hrecursive_mutex_lock(&io->write_mutex);
+    hio_ext_t* ext = io->ext;
+    if (ext) {
+        if (ext->read_timer) m->read_timeout = ext->read_timeout;
+        if (ext->write_timer) m->write_timeout = ext->write_timeout;
+        if (ext->keepalive_timer) m->keepalive_timeout = ext->keepalive_timeout;
+        if (ext->heartbeat_timer) {
+            m->heartbeat_interval = ext->heartbeat_interval;
+            m->heartbeat_fn = ext->heartbeat_fn;
+        }
+        hio_del_read_timer(io);
+        hio_del_write_timer(io);
+        hio_del_keepalive_timer(io);
+        hio_del_heartbeat_timer(io);
+    }
+    // loop->readbuf is shared by ios of this loop, copy the unconsumed data
+    if (hio_is_loop_readbuf(io) && io->readbuf.tail > io->readbuf.head) {
+        char* data = io->readbuf.base + io->readbuf.head;
+        size_t len = io->readbuf.tail - io->readbuf.head;
+        hio_alloc_readbuf(io, io->readbuf.len);
+        memcpy(io->readbuf.base, data, len);
+        io->readbuf.head = 0;
+        io->readbuf.tail = len;
+    }
+    // NOTE: keep io->events, re-added by hio_migrate_in
+    if (io->active) {
+        if (io->events) {
+            iowatcher_del_event(loop, io->fd, io->events);
+        }
+        hatomic_add_relaxed(&loop->nios, -1);
+        EVENT_INACTIVE(io);
+    }
+    io->revents = io->ready_events = 0;
+    loop->ios.ptr[io->fd] = NULL;
+    // NOTE: hio_close and hio_write from other threads go to dst loop since now.
+    io->migrating = 1;
+    io->loop = m->dst;
+    HLOOP_STATS_ADD(loop, migrated_out, 1);
+    hrecursive_mutex_unlock(&io->write_mutex);
+
+    hio_migration_t* pm = NULL;
+    HV_ALLOC_SIZEOF(pm);
+    *pm = *m;
+    hevent_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.cb = hio_migrate_in;
+    ev.userdata = pm;
+    hloop_post_event(m->dst, &ev);
+    return 0;
+}
+
+static void hloop_process_migrations(hloop_t* loop) {
+    int nretry = 0;
+    for (int i = 0; i < loop->migrations.size; ++i) {
+        hio_migration_t* m = &loop->migrations.ptr[i];
+        if (hio_migrate_out(m) != 0) {
+            loop->migrations.ptr[nretry++] = *m;
+        }
+    }
+    loop->migrations.size = nretry;
+}
+
+int hio_migrate(hio_t* io, hloop_t* dst, hio_migrate_cb cb, void* userdata) {
+#if defined(EVENT_IO_URING) || defined(EVENT_IOCP)
+    // NOTE: operations in flight are bound to the loop.
+    return -1;
+#else
+    hloop_t* loop = io->loop;
+    if (dst == NULL || dst == loop) return -1;
+    if (!(io->io_type & HIO_TYPE_SOCK_STREAM)) return -1;
+    if (!io->ready || io->closed || io->close || io->connect || io->migrating) return -1;
+    if (hio_ext_field(io, upstream_io)) return -1;
+    for (int i = 0; i < loop->migrations.size; ++i) {
+        if (loop->migrations.ptr[i].io == io) return -1;
+    }
+    hio_migration_t m;
+    memset(&m, 0, sizeof(m));
+    m.io = io;
+    m.id = io->id;
+    m.src = loop;
+    m.dst = dst;
+    m.cb = cb;
+    m.userdata = userdata;
+    migration_array_push_back(&loop->migrations, &m);
+    return 0;
+#endif
+}
+
 bool hio_exists(hloop_t* loop, int fd) {
     if (fd >= loop->ios.maxsize) {
         return false;
@@ -840,10 +1550,16 @@ int hio_add(hio_t* io, hio_cb cb, int events) {
     // Windows iowatcher not work on stdio
     if (io->fd < 3) return -1;
 #endif
+    if (io->migrating) {
+        // NOTE: re-added by hio_migrate_in
+        if (cb) io->cb = (hevent_cb)cb;
+        io->events |= events;
+        return 0;
+    }
     hloop_t* loop = io->loop;
     if (!io->active) {
         EVENT_ADD(loop, io, cb);
-        loop->nios++;
+        hatomic_add_relaxed(&loop->nios, 1);
     }
 
     if (!io->ready) {
@@ -867,6 +1583,10 @@ int hio_del(hio_t* io, int events) {
     // Windows iowatcher not work on stdio
     if (io->fd < 3) return -1;
 #endif
+    if (io->migrating) {
+        io->events &= ~events;
+        return 0;
+    }
     if (!io->active) return -1;
 
     if (io->events & events) {
@@ -874,7 +1594,7 @@ int hio_del(hio_t* io, int events) {
         io->events &= ~events;
     }
     if (io->events == 0) {
-        io->loop->nios--;
+        hatomic_add_relaxed(&io->loop->nios, -1);
         // NOTE: not EVENT_DEL, avoid free
         EVENT_INACTIVE(io);
         EVENT_UNPENDING(io);
@@ -886,6 +1606,11 @@ static void hio_close_event_cb(hevent_t* ev) {
     hio_t* io = (hio_t*)ev->userdata;
     uint32_t id = (uintptr_t)ev->privdata;
     if (io->id != id) return;
+    // NOTE: io migrated to another loop after posted
+    if (io->loop != ev->loop) {
+        hio_close_async(io);
+        return;
+    }
     hio_close(io);
 }
 
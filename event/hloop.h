@@ -29,6 +29,17 @@ typedef void (*hconnect_cb) (hio_t* io);
 typedef void (*hread_cb)    (hio_t* io, void* buf, int readbytes);
 typedef void (*hwrite_cb)   (hio_t* io, const void* buf, int writebytes);
 typedef void (*hclose_cb)   (hio_t* io);
+typedef void (*hfree_cb)    (void* buf, void* userdata);
+// @see hio_set_write_water
+typedef void (*hwater_cb)   (hio_t* io, size_t write_bufsize);
+
+// batch datagram, @see hio_set_batch, hio_sendto_batch
+typedef struct hio_dgram_s {
+    void*               buf;
+    int                 len;
+    struct sockaddr*    addr;
+} hio_dgram_t;
+typedef void (*hread_batch_cb)(hio_t* io, hio_dgram_t* dgrams, int cnt);
 
 typedef enum {
     HLOOP_STATUS_STOP,
@@ -131,6 +142,15 @@ BEGIN_EXTERN_C
 #define HLOOP_FLAG_RUN_ONCE                     0x00000001
 #define HLOOP_FLAG_AUTO_FREE                    0x00000002
 #define HLOOP_FLAG_QUIT_WHEN_NO_ACTIVE_EVENTS   0x00000004
+// NOTE: epoll only, ignored by other iowatchers.
+// fd is registered with EPOLLIN|EPOLLOUT|EPOLLET once, no epoll_ctl when HV_WRITE toggles,
+// reads drain until EAGAIN with a budget per wakeup.
+#define HLOOP_FLAG_EDGE_TRIGGERED               0x00000008
+// NOTE: poll with zero timeout for a while after io activity before blocking,
+// trade cpu for wakeup latency, @see hloop_set_busy_poll
+#define HLOOP_FLAG_BUSY_POLL                    0x00000010
+// NOTE: collect latency histograms, @see hloop_stats
+#define HLOOP_FLAG_STATS                        0x00000020
 HV_EXPORT hloop_t* hloop_new(int flags DEFAULT(HLOOP_FLAG_AUTO_FREE));
 
 // WARN: Forbid to call hloop_free if HLOOP_FLAG_AUTO_FREE set.
@@ -171,6 +191,123 @@ HV_EXPORT uint32_t hloop_nidles(hloop_t* loop);
 // @return number of active events
 HV_EXPORT uint32_t hloop_nactives(hloop_t* loop);
 
+// NOTE: hio timers (connect/close/read/write/keepalive/heartbeat) use a timing wheel,
+// other timers use a min heap.
+typedef struct htimer_stats_s {
+    uint32_t    heap_timers;
+    uint32_t    wheel_timers;
+    uint64_t    heap_inserts;
+    uint64_t    heap_removes;
+    uint64_t    wheel_inserts;
+    uint64_t    wheel_removes;
+    uint64_t    wheel_expires;
+    uint64_t    wheel_ticks;    // slots processed
+} htimer_stats_t;
+HV_EXPORT void hloop_timer_stats(hloop_t* loop, htimer_stats_t* stats);
+
+// busy poll
+#define HLOOP_DEFAULT_BUSY_POLL_TIME    50  // us
+/*
+ * @param spin_us: keep polling with zero timeout for spin_us after last io event, 0 means disable.
+ * @param sock_busy_poll_us: SO_BUSY_POLL + SO_PREFER_BUSY_POLL for accepted sockets, 0 means not set.
+ *        Applied on accept by both nio and io_uring backends, not to sockets of hio_connect.
+ * NOTE: call before hloop_run, set HLOOP_FLAG_BUSY_POLL if spin_us > 0.
+ */
+HV_EXPORT void hloop_set_busy_poll(hloop_t* loop, uint32_t spin_us DEFAULT(HLOOP_DEFAULT_BUSY_POLL_TIME), int sock_busy_poll_us DEFAULT(0));
+typedef struct hloop_busy_poll_stats_s {
+    uint64_t    spins;      // zero timeout polls while spinning, not those due to timers
+    uint64_t    spin_hits;  // spins which got io events
+    uint64_t    sleeps;     // blocking polls
+    uint64_t    wakeups;    // blocking polls which got io events
+} hloop_busy_poll_stats_t;
+HV_EXPORT void hloop_busy_poll_stats(hloop_t* loop, hloop_busy_poll_stats_t* stats);
+
+// stats
+// log2 buckets of us: [0,1) [1,2) [2,4) ... [2^29,inf)
+#define HLOOP_HISTOGRAM_BUCKETS     31
+typedef struct hloop_histogram_s {
+    uint64_t    count;
+    uint64_t    sum;    // us
+    uint64_t    max;    // us
+    uint64_t    buckets[HLOOP_HISTOGRAM_BUCKETS];
+} hloop_histogram_t;
+HV_EXPORT void hloop_histogram_add(hloop_histogram_t* hist, uint64_t us);
+HV_EXPORT void hloop_histogram_merge(hloop_histogram_t* dst, const hloop_histogram_t* src);
+// @param percent: 0 ~ 100
+// @return upper bound of the bucket in us
+HV_EXPORT uint64_t hloop_histogram_percentile(const hloop_histogram_t* hist, double percent);
+
+typedef enum {
+    HLOOP_HIST_ITERATION = 0,   // hloop_process_events, excluding blocked in iowatcher
+    HLOOP_HIST_POLL,            // blocked in iowatcher
+    HLOOP_HIST_IO_READ,         // io callback with HV_READ revents
+    HLOOP_HIST_IO_WRITE,        // io callback with HV_WRITE revents only
+    HLOOP_HIST_TIMER,
+    HLOOP_HIST_IDLE,
+    HLOOP_HIST_SIGNAL,
+    HLOOP_HIST_CUSTOM,          // custom event callback
+    HLOOP_HIST_CUSTOM_LATENCY,  // hloop_post_event => callback
+    HLOOP_HIST_MAX
+} hloop_hist_e;
+HV_EXPORT const char* hloop_hist_str(hloop_hist_e hist);
+
+// callback which blocked the loop, @see hloop_watchdog_start
+typedef struct hloop_stall_s {
+    int         event_type; // HEVENT_TYPE_NONE if not in a callback
+    uint64_t    event_id;
+    int         fd;         // io fd, -1 if not io
+    void*       cb;         // user callback, for io is read_cb/write_cb/accept_cb/connect_cb
+    uint64_t    start_ms;   // gettimeofday_ms
+    uint64_t    duration;   // us
+} hloop_stall_t;
+#define HLOOP_MAX_STALLS    8
+
+typedef struct hloop_stats_s {
+    uint64_t    loop_cnt;
+    uint32_t    nactives;
+    uint32_t    nios;
+    uint32_t    ntimers;
+    uint32_t    nidles;
+    uint64_t    custom_events_posted;
+    uint64_t    custom_events_depth;        // posted but not popped yet
+    uint64_t    custom_events_max_depth;
+    uint64_t    migrated_in;                // @see hio_migrate
+    uint64_t    migrated_out;
+    uint64_t    ssl_handshakes;
+    uint64_t    ssl_resumed;                // abbreviated handshakes, @see hssl_reuse_session
+    uint64_t    ktls_tx;                    // handshakes with kernel TLS offload engaged, @see hio_get_ktls
+    uint64_t    ktls_rx;
+    hloop_histogram_t hists[HLOOP_HIST_MAX];
+    // written by watchdog thread
+    uint64_t    stalls;
+    uint32_t    nslowest;
+    hloop_stall_t slowest[HLOOP_MAX_STALLS]; // sorted by duration desc
+} hloop_stats_t;
+/*
+ * NOTE: histograms are collected only if HLOOP_FLAG_STATS set.
+ * Written by the loop thread under a seqlock, so hloop_stats could be called
+ * from any thread and returns a consistent snapshot, maybe a few events behind.
+ */
+HV_EXPORT void hloop_enable_stats(hloop_t* loop, int on DEFAULT(1));
+HV_EXPORT void hloop_stats(hloop_t* loop, hloop_stats_t* stats);
+// sum counters and histograms of src into dst, for multiple loops.
+HV_EXPORT void hloop_stats_merge(hloop_stats_t* dst, const hloop_stats_t* src);
+
+// watchdog
+/*
+ * One watchdog thread samples heartbeats of watched loops every threshold_ms/4,
+ * a loop is stalled if it stays in the same callback (or outside the iowatcher)
+ * longer than threshold_ms, the callback is logged and recorded in hloop_stats.
+ * HLOOP_WATCHDOG_BACKTRACE: signal the stalled thread to capture a backtrace (linux glibc),
+ * WARN: blocking calls like sleep/poll in the stalled callback may return EINTR.
+ */
+#define HLOOP_WATCHDOG_BACKTRACE    0x01
+HV_EXPORT int  hloop_watchdog_start(int threshold_ms DEFAULT(1000), int flags DEFAULT(0));
+HV_EXPORT void hloop_watchdog_stop();
+// NOTE: hloop_free will unwatch the loop.
+HV_EXPORT int  hloop_watch(hloop_t* loop);
+HV_EXPORT int  hloop_unwatch(hloop_t* loop);
+
 // userdata
 HV_EXPORT void  hloop_set_userdata(hloop_t* loop, void* userdata);
 HV_EXPORT void* hloop_userdata(hloop_t* loop);
@@ -270,6 +407,14 @@ HV_EXPORT void hio_detach(/*hloop_t* loop,*/ hio_t* io);
 HV_EXPORT void hio_attach(hloop_t* loop, hio_t* io);
 HV_EXPORT bool hio_exists(hloop_t* loop, int fd);
 
+// NOTE: move a live connection to another loop, with its events, timers and write_queue.
+// hio_migrate must be called in io->loop thread, io is detached at a safe point
+// after the current callbacks, and attached in dst loop thread, then cb(io, userdata) called there.
+// cb is not called if io closed before detached.
+// @return 0 if scheduled, -1 if io not migratable (not tcp, closing, upstream, io_uring)
+typedef void (*hio_migrate_cb)(hio_t* io, void* userdata);
+HV_EXPORT int hio_migrate(hio_t* io, hloop_t* dst, hio_migrate_cb cb DEFAULT(NULL), void* userdata DEFAULT(NULL));
+
 // hio_t fields
 // NOTE: fd cannot be used as unique identifier, so we provide an id.
 HV_EXPORT uint32_t hio_id (hio_t* io);
@@ -277,6 +422,8 @@ HV_EXPORT int hio_fd      (hio_t* io);
 HV_EXPORT int hio_error   (hio_t* io);
 HV_EXPORT int hio_events  (hio_t* io);
 HV_EXPORT int hio_revents (hio_t* io);
+// events handled since last call, for hio_migrate
+HV_EXPORT uint32_t hio_take_event_count(hio_t* io);
 HV_EXPORT hio_type_e       hio_type     (hio_t* io);
 HV_EXPORT struct sockaddr* hio_localaddr(hio_t* io);
 HV_EXPORT struct sockaddr* hio_peeraddr (hio_t* io);
@@ -289,16 +436,34 @@ HV_EXPORT bool hio_is_closed(hio_t* io);
 // iobuf
 // #include "hbuf.h"
 typedef struct fifo_buf_s hio_readbuf_t;
+struct hbuf_s;
 // NOTE: One loop per thread, one readbuf per loop.
 // But you can pass in your own readbuf instead of the default readbuf to avoid memcopy.
 HV_EXPORT void hio_set_readbuf(hio_t* io, void* buf, size_t len);
 HV_EXPORT hio_readbuf_t* hio_get_readbuf(hio_t* io);
 HV_EXPORT void hio_set_max_read_bufsize (hio_t* io, uint32_t size);
+// NOTE: readbuf of hio_read_until_*/hio_set_unpack is a mirrored ring buffer (@see hv_mirror_alloc),
+// so unconsumed partial data is never memmoved, good for streams of large packages.
+// @return 0: ok, -1: not supported by this platform or event backend (iocp, io_uring).
+HV_EXPORT int  hio_set_readbuf_mirror(hio_t* io, int on DEFAULT(1));
 HV_EXPORT void hio_set_max_write_bufsize(hio_t* io, uint32_t size);
 // NOTE: hio_write is non-blocking, so there is a write queue inside hio_t to cache unwritten data and wait for writable.
 // @return current buffer size of write queue.
 HV_EXPORT size_t   hio_write_bufsize(hio_t* io);
 #define hio_write_is_complete(io) (hio_write_bufsize(io) == 0)
+// NOTE: write backpressure: high_water_cb is called once write_bufsize rises above high_water,
+// then drained_cb once it falls to low_water, so producers can pause and resume.
+// high_water_cb is called in the thread of hio_write, drained_cb in the loop thread.
+// high_water 0 to disable, low_water 0 defaults to high_water / 2. max_write_bufsize is still the hard limit.
+HV_EXPORT void hio_set_write_water(hio_t* io, uint32_t high_water, uint32_t low_water DEFAULT(0));
+HV_EXPORT void hio_setcb_high_water(hio_t* io, hwater_cb high_water_cb);
+HV_EXPORT void hio_setcb_drained(hio_t* io, hwater_cb drained_cb);
+HV_EXPORT bool hio_is_over_high_water(hio_t* io);
+// NOTE: linux tcp only, send with MSG_ZEROCOPY if writing >= threshold bytes,
+// queued buffers are freed after kernel completion notification. 0 to disable.
+// Kernel may fallback to copy (e.g. loopback), then zerocopy is disabled automatically.
+#define HIO_DEFAULT_ZEROCOPY_THRESHOLD  32768 // 32K
+HV_EXPORT int hio_set_zerocopy(hio_t* io, uint32_t threshold DEFAULT(HIO_DEFAULT_ZEROCOPY_THRESHOLD));
 
 HV_EXPORT uint64_t hio_last_read_time(hio_t* io);   // ms
 HV_EXPORT uint64_t hio_last_write_time(hio_t* io);  // ms
@@ -309,6 +474,10 @@ HV_EXPORT void hio_setcb_connect  (hio_t* io, hconnect_cb connect_cb);
 HV_EXPORT void hio_setcb_read     (hio_t* io, hread_cb    read_cb);
 HV_EXPORT void hio_setcb_write    (hio_t* io, hwrite_cb   write_cb);
 HV_EXPORT void hio_setcb_close    (hio_t* io, hclose_cb   close_cb);
+// NOTE: udp: @see hio_set_batch
+// tcp with hio_set_unpack: all complete packages of one read are delivered by one read_batch_cb
+// instead of read_cb one by one, dgrams[i].addr is NULL.
+HV_EXPORT void hio_setcb_read_batch(hio_t* io, hread_batch_cb read_batch_cb);
 // get callbacks
 HV_EXPORT haccept_cb  hio_getcb_accept(hio_t* io);
 HV_EXPORT hconnect_cb hio_getcb_connect(hio_t* io);
@@ -325,6 +494,10 @@ HV_EXPORT int  hio_set_ssl_ctx(hio_t* io, hssl_ctx_t ssl_ctx);
 HV_EXPORT int  hio_new_ssl_ctx(hio_t* io, hssl_ctx_opt_t* opt);
 HV_EXPORT hssl_t     hio_get_ssl(hio_t* io);
 HV_EXPORT hssl_ctx_t hio_get_ssl_ctx(hio_t* io);
+// NOTE: opt-in by hssl_ctx_opt_t.ktls, detected after handshake.
+// If HSSL_KTLS_TX engaged, writes bypass hssl_write, so do hio_writev and hio_sendfile.
+// @return HSSL_KTLS_TX | HSSL_KTLS_RX
+HV_EXPORT int        hio_get_ktls(hio_t* io);
 // for hssl_set_sni_hostname
 HV_EXPORT int         hio_set_hostname(hio_t* io, const char* hostname);
 HV_EXPORT const char* hio_get_hostname(hio_t* io);
@@ -379,6 +552,35 @@ HV_EXPORT int hio_read_remain(hio_t* io);
 // hio_try_write => hio_add(io, HV_WRITE) => write => hwrite_cb
 HV_EXPORT int hio_write  (hio_t* io, const void* buf, size_t len);
 HV_EXPORT int hio_sendto (hio_t* io, const void* buf, size_t len, struct sockaddr* addr);
+// NOTE: gather write, e.g. header + body, without merging them first.
+// hbuf_t bufs[2] = {{header, hlen}, {body, blen}}; hio_writev(io, bufs, 2);
+// @see hbuf.h
+HV_EXPORT int hio_writev (hio_t* io, const struct hbuf_s* bufs, int nbufs);
+// NOTE: take ownership of buf, unwritten data is queued by reference instead of copied.
+// free_cb(buf, userdata) is called once all bytes written or io closed, even if return -1.
+// free_cb NULL means buf was allocated by HV_ALLOC, HV_FREE(buf).
+HV_EXPORT int hio_write_owned (hio_t* io, void* buf, size_t len, hfree_cb free_cb DEFAULT(NULL), void* userdata DEFAULT(NULL));
+// NOTE: linux tcp or kernel TLS only, send [offset, offset+len) of file fd by sendfile, zero-copy from page cache.
+// Queued after data written before, fd is dup'ed so caller may close it at once.
+// Unsent file bytes count in hio_write_bufsize and write water, but not against max_write_bufsize,
+// so len may be larger than it, up to INT_MAX, and queued file bytes up to UINT32_MAX in all.
+// hwrite_cb(io, NULL, writebytes) for bytes of file.
+// @return bytes sent now, -1 if error or not supported.
+HV_EXPORT int hio_sendfile (hio_t* io, int fd, uint64_t offset, size_t len);
+// @return false for ssl without kernel TLS, udp, io_uring, or platforms without sendfile.
+HV_EXPORT bool hio_sendfile_supported(hio_t* io);
+
+// NOTE: linux udp only, read up to batch datagrams per readable event by recvmmsg,
+// deliver them by hread_batch_cb if set, else by hread_cb one by one with hio_peeraddr updated.
+// HIO_UDP_GRO: kernel coalesces datagrams of one flow, split again before callback.
+// HIO_UDP_GSO: hio_sendto_batch send datagrams of same peer and size as one UDP_SEGMENT message.
+#define HIO_MAX_BATCH   64
+#define HIO_UDP_GRO     0x1
+#define HIO_UDP_GSO     0x2
+HV_EXPORT int hio_set_batch(hio_t* io, int batch DEFAULT(HIO_MAX_BATCH), int offload DEFAULT(0));
+// sendmmsg, unsent datagrams are enqueued like hio_sendto.
+// @return datagrams sent immediately, -1 if error.
+HV_EXPORT int hio_sendto_batch(hio_t* io, const hio_dgram_t* dgrams, int cnt);
 
 // NOTE: hio_close is thread-safe, hio_close_async will be called actually in other thread.
 // hio_del(io, HV_RDWR) => close => hclose_cb
@@ -457,19 +659,34 @@ HV_EXPORT int hio_create_pipe(hloop_t* loop, hio_t* pipeio[2]);
 HV_EXPORT void   hio_read_upstream(hio_t* io);
 // on_write(io) -> hio_write_is_complete(io) -> hio_read(io->upstream_io)
 HV_EXPORT void   hio_read_upstream_on_write_complete(hio_t* io, const void* buf, int writebytes);
+// on_drained(io) -> hio_read(io->upstream_io)
+HV_EXPORT void   hio_read_upstream_on_drained(hio_t* io, size_t write_bufsize);
 // hio_write(io->upstream_io, buf, bytes)
+// NOTE: hio_read_stop(io) while io->upstream_io is over high water, @see hio_set_write_water
 HV_EXPORT void   hio_write_upstream(hio_t* io, void* buf, int bytes);
 // hio_close(io->upstream_io)
 HV_EXPORT void   hio_close_upstream(hio_t* io);
 
 // io1->upstream_io = io2;
 // io2->upstream_io = io1;
+// hio_set_write_water(io1/io2, UPSTREAM_WRITE_HIGH_WATER, UPSTREAM_WRITE_LOW_WATER) if not set;
+// on drained, hio_read(upstream_io) before the drained_cb of hio_setcb_drained, which is kept;
 // @see examples/socks5_proxy_server.c
 HV_EXPORT void   hio_setup_upstream(hio_t* io1, hio_t* io2);
 
 // @return io->upstream_io
 HV_EXPORT hio_t* hio_get_upstream(hio_t* io);
 
+// splice relay: io => pipe => io->upstream_io in kernel, bytes never copied to userspace.
+// Opt-in, call after hio_setup_upstream/hio_setup_tcp_upstream, both directions are relayed.
+// Only while read_cb is hio_write_upstream and no unpack is set, otherwise read_cb is called as usual.
+// Each io holds a pipe (2 fds) while on.
+// Half-close: shutdown(SHUT_WR) io->upstream_io when io read EOF, close both when both EOF.
+// NOTE: linux tcp only, @return -1 if not supported (ssl, io_uring, unpack), relay with hio_write_upstream then.
+HV_EXPORT int hio_set_splice_upstream(hio_t* io, int on DEFAULT(1));
+// @return bytes spliced from io to io->upstream_io
+HV_EXPORT uint64_t hio_splice_bytes(hio_t* io);
+
 // @tcp_upstream: hio_create_socket -> hio_setup_upstream -> hio_connect -> on_connect -> hio_read_upstream
 // @return upstream_io
 // @see examples/tcp_proxy_server.c
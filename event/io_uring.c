@@ -4,18 +4,74 @@
 #include "hplatform.h"
 #include "hdef.h"
 #include "hevent.h"
+#include "hthread.h"
+#include "hlog.h"
+#include "uringio.h"
 
 #include <liburing.h>
 #include <poll.h>
 
 #define IO_URING_ENTRIES    1024
 #define IO_URING_CANCEL_TAG ((void*)(uintptr_t)-1)
+#define IO_URING_PBUF_BGID  0
+
+// user_data: poll => fd << 1, op => huring_op_t* | 1
+#define IO_URING_POLL_DATA(fd)      ((void*)((uintptr_t)(fd) << 1))
+#define IO_URING_POLL_FD(data)      ((int)((uintptr_t)(data) >> 1))
+#define IO_URING_OP_DATA(op)        ((void*)((uintptr_t)(op) | 1))
+#define IO_URING_IS_OP_DATA(data)   ((uintptr_t)(data) & 1)
+#define IO_URING_OP_PTR(data)       ((huring_op_t*)((uintptr_t)(data) & ~(uintptr_t)1))
+
+typedef struct uring_arm_s {
+    int         fd;
+    uint32_t    id;
+} uring_arm_t;
+
+#include "array.h"
+#define ARMS_INIT_SIZE      64
+ARRAY_DECL(uring_arm_t, uring_arms);
 
 typedef struct io_uring_ctx_s {
-    struct io_uring ring;
-    int             nfds;
+    struct io_uring     ring;
+    int                 nfds;
+    // ops in flight
+    struct list_head    ops;
+    // ios waiting to arm ops
+    struct uring_arms   arms;
+    hmutex_t            arms_mutex;
+    // provided buffer ring shared by all recv ops
+    struct io_uring_buf_ring* pbuf_ring;
+    char*               pbufs;
+    unsigned            no_multishot_accept :1;
+    unsigned            no_multishot_recv   :1;
 } io_uring_ctx_t;
 
+static void uring_pbuf_add(io_uring_ctx_t* ctx, unsigned short bid) {
+    io_uring_buf_ring_add(ctx->pbuf_ring, ctx->pbufs + (size_t)bid * HURING_PBUF_SIZE, HURING_PBUF_SIZE,
+            bid, io_uring_buf_ring_mask(HURING_PBUF_COUNT), 0);
+    io_uring_buf_ring_advance(ctx->pbuf_ring, 1);
+}
+
+static void uring_pbuf_init(io_uring_ctx_t* ctx) {
+    int ret = 0;
+    ctx->pbuf_ring = io_uring_setup_buf_ring(&ctx->ring, HURING_PBUF_COUNT, IO_URING_PBUF_BGID, 0, &ret);
+    if (ctx->pbuf_ring == NULL) {
+        // NOTE: kernel < 5.19, fallback to recv into per io readbuf.
+        hlogw("io_uring_setup_buf_ring failed: %d", ret);
+        return;
+    }
+    HV_ALLOC(ctx->pbufs, (size_t)HURING_PBUF_COUNT * HURING_PBUF_SIZE);
+    for (int i = 0; i < HURING_PBUF_COUNT; ++i) {
+        uring_pbuf_add(ctx, i);
+    }
+}
+
+static void uring_pbuf_cleanup(io_uring_ctx_t* ctx) {
+    if (ctx->pbuf_ring == NULL) return;
+    io_uring_free_buf_ring(&ctx->ring, ctx->pbuf_ring, HURING_PBUF_COUNT, IO_URING_PBUF_BGID);
+    ctx->pbuf_ring = NULL;
+}
+
 int iowatcher_init(hloop_t* loop) {
     if (loop->iowatcher) return 0;
     io_uring_ctx_t* ctx;
@@ -26,6 +82,10 @@ int iowatcher_init(hloop_t* loop) {
         return ret;
     }
     ctx->nfds = 0;
+    list_init(&ctx->ops);
+    uring_arms_init(&ctx->arms, ARMS_INIT_SIZE);
+    hmutex_init(&ctx->arms_mutex);
+    uring_pbuf_init(ctx);
     loop->iowatcher = ctx;
     return 0;
 }
@@ -33,7 +93,18 @@ int iowatcher_init(hloop_t* loop) {
 int iowatcher_cleanup(hloop_t* loop) {
     if (loop->iowatcher == NULL) return 0;
     io_uring_ctx_t* ctx = (io_uring_ctx_t*)loop->iowatcher;
+    uring_pbuf_cleanup(ctx);
     io_uring_queue_exit(&ctx->ring);
+    // NOTE: ring exited, the kernel will not touch op buffers any more.
+    struct list_node* node = ctx->ops.next;
+    while (node != &ctx->ops) {
+        huring_op_t* op = list_entry(node, huring_op_t, node);
+        node = node->next;
+        uring_free_op(op);
+    }
+    uring_arms_cleanup(&ctx->arms);
+    hmutex_destroy(&ctx->arms_mutex);
+    HV_FREE(ctx->pbufs);
     HV_FREE(loop->iowatcher);
     return 0;
 }
@@ -48,6 +119,264 @@ static struct io_uring_sqe* io_uring_get_sqe_safe(struct io_uring* ring) {
     return sqe;
 }
 
+//-----------------proactor---------------------------------------------
+static huring_op_t* uring_new_op(io_uring_ctx_t* ctx, hio_t* io, huring_op_e type) {
+    huring_op_t* op;
+    HV_ALLOC_SIZEOF(op);
+    op->op = type;
+    op->io = io;
+    list_add(&op->node, &ctx->ops);
+    return op;
+}
+
+void uring_free_op(huring_op_t* op) {
+    list_del(&op->node);
+    if (op->orphan && op->orphan_free_cb) {
+        op->orphan_free_cb(op->orphan, op->orphan_userdata);
+    } else {
+        HV_FREE(op->orphan);
+    }
+    HV_FREE(op);
+}
+
+char* uring_pbuf(hio_t* io, huring_op_t* op) {
+    io_uring_ctx_t* ctx = (io_uring_ctx_t*)io->loop->iowatcher;
+    if (ctx->pbufs == NULL || !(op->flags & IORING_CQE_F_BUFFER)) return NULL;
+    unsigned short bid = op->flags >> IORING_CQE_BUFFER_SHIFT;
+    return ctx->pbufs + (size_t)bid * HURING_PBUF_SIZE;
+}
+
+void uring_pbuf_recycle(hio_t* io, huring_op_t* op) {
+    io_uring_ctx_t* ctx = (io_uring_ctx_t*)io->loop->iowatcher;
+    if (ctx->pbufs == NULL || !(op->flags & IORING_CQE_F_BUFFER)) return;
+    uring_pbuf_add(ctx, op->flags >> IORING_CQE_BUFFER_SHIFT);
+    op->flags &= ~IORING_CQE_F_BUFFER;
+}
+
+void uring_arm_ops(hio_t* io) {
+    hloop_t* loop = io->loop;
+    io_uring_ctx_t* ctx = (io_uring_ctx_t*)loop->iowatcher;
+    if (ctx == NULL) return;
+    uring_arm_t arm;
+    arm.fd = io->fd;
+    arm.id = io->id;
+    hmutex_lock(&ctx->arms_mutex);
+    uring_arms_push_back(&ctx->arms, &arm);
+    hmutex_unlock(&ctx->arms_mutex);
+    // NOTE: wakeup loop blocking in io_uring_wait if armed by other thread, e.g. hio_write.
+    if (hv_gettid() != loop->tid && loop->status == HLOOP_STATUS_RUNNING) {
+        hloop_wakeup(loop);
+    }
+}
+
+static void uring_post_accept(io_uring_ctx_t* ctx, hio_t* io) {
+    struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
+    if (sqe == NULL) return;
+    huring_op_t* op = uring_new_op(ctx, io, HURING_OP_ACCEPT);
+    if (ctx->no_multishot_accept) {
+        op->addrlen = sizeof(sockaddr_u);
+        io_uring_prep_accept(sqe, io->fd, &op->addr.sa, &op->addrlen, 0);
+    } else {
+        // NOTE: one sqe serves the listener until cancelled.
+        io_uring_prep_multishot_accept(sqe, io->fd, NULL, NULL, 0);
+        op->multishot = 1;
+    }
+    io_uring_sqe_set_data(sqe, IO_URING_OP_DATA(op));
+    io->uring_rop = op;
+}
+
+static void uring_post_connect(io_uring_ctx_t* ctx, hio_t* io) {
+    struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
+    if (sqe == NULL) return;
+    huring_op_t* op = uring_new_op(ctx, io, HURING_OP_CONNECT);
+    io_uring_prep_connect(sqe, io->fd, io->peeraddr, SOCKADDR_LEN(io->peeraddr));
+    io_uring_sqe_set_data(sqe, IO_URING_OP_DATA(op));
+    io->uring_wop = op;
+}
+
+static void uring_post_recv_pbuf(io_uring_ctx_t* ctx, hio_t* io) {
+    struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
+    if (sqe == NULL) return;
+    huring_op_t* op = uring_new_op(ctx, io, HURING_OP_RECV);
+    if (io->read_flags == 0 && !ctx->no_multishot_recv) {
+        io_uring_prep_recv_multishot(sqe, io->fd, NULL, 0, 0);
+        op->multishot = 1;
+    } else {
+        io_uring_prep_recv(sqe, io->fd, NULL, HURING_PBUF_SIZE, 0);
+    }
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IO_URING_PBUF_BGID;
+    op->bufsel = 1;
+    io_uring_sqe_set_data(sqe, IO_URING_OP_DATA(op));
+    io->uring_rop = op;
+}
+
+static void uring_post_recv(io_uring_ctx_t* ctx, hio_t* io) {
+    // NOTE: idle io borrows a provided buffer only when data arrives.
+    if (ctx->pbuf_ring &&
+        hio_is_loop_readbuf(io) &&
+        io->readbuf.head == io->readbuf.tail &&
+        hio_ext_field(io, unpack_setting) == NULL &&
+        (io->read_flags & (HIO_READ_UNTIL_LENGTH | HIO_READ_UNTIL_DELIM)) == 0) {
+        uring_post_recv_pbuf(ctx, io);
+        return;
+    }
+    // NOTE: loop readbuf is shared by all ios, recv in flight must have own readbuf.
+    if (hio_is_loop_readbuf(io)) {
+        hio_alloc_readbuf(io, HLOOP_READ_BUFSIZE);
+    }
+    size_t len = 0;
+    if (io->read_flags & HIO_READ_UNTIL_LENGTH) {
+        len = io->read_until_length - (io->readbuf.tail - io->readbuf.head);
+    } else {
+        len = io->readbuf.len - io->readbuf.tail;
+    }
+    if (len == 0) return;
+    struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
+    if (sqe == NULL) return;
+    huring_op_t* op = uring_new_op(ctx, io, HURING_OP_RECV);
+    op->buf = io->readbuf.base + io->readbuf.tail;
+    op->len = len;
+    io_uring_prep_recv(sqe, io->fd, op->buf, op->len, 0);
+    io_uring_sqe_set_data(sqe, IO_URING_OP_DATA(op));
+    io->uring_rop = op;
+}
+
+static void uring_post_send(io_uring_ctx_t* ctx, hio_t* io) {
+    hrecursive_mutex_lock(&io->write_mutex);
+    hio_wbuf_t* pbuf = write_queue_front(&io->write_queue);
+    if (pbuf == NULL) goto unlock;
+    struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
+    if (sqe == NULL) goto unlock;
+    huring_op_t* op = uring_new_op(ctx, io, HURING_OP_SEND);
+    op->buf = pbuf->base + pbuf->offset;
+    op->len = pbuf->len - pbuf->offset;
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+    io_uring_prep_send(sqe, io->fd, op->buf, op->len, flags);
+    io_uring_sqe_set_data(sqe, IO_URING_OP_DATA(op));
+    io->uring_wop = op;
+unlock:
+    hrecursive_mutex_unlock(&io->write_mutex);
+}
+
+static int uring_post_ops(io_uring_ctx_t* ctx, hio_t* io) {
+    // NOTE: completed ops may be unpended by hio_del, pend them again.
+    int revents = 0;
+    if (io->uring_rop && ((huring_op_t*)io->uring_rop)->done) {
+        revents |= HV_READ;
+    }
+    if (io->uring_wop && ((huring_op_t*)io->uring_wop)->done) {
+        revents |= HV_WRITE;
+    }
+    if (revents) {
+        io->revents |= revents;
+        EVENT_PENDING(io);
+        return 1;
+    }
+    if ((io->events & HV_READ) && io->uring_rop == NULL) {
+        if (io->accept) {
+            uring_post_accept(ctx, io);
+        } else {
+            uring_post_recv(ctx, io);
+        }
+    }
+    if ((io->events & HV_WRITE) && io->uring_wop == NULL) {
+        if (io->connect) {
+            uring_post_connect(ctx, io);
+        } else {
+            uring_post_send(ctx, io);
+        }
+    }
+    return 0;
+}
+
+static int uring_flush_arms(hloop_t* loop, io_uring_ctx_t* ctx) {
+    int nevents = 0;
+    hmutex_lock(&ctx->arms_mutex);
+    for (size_t i = 0; i < ctx->arms.size; ++i) {
+        uring_arm_t* arm = ctx->arms.ptr + i;
+        if (arm->fd < 0 || arm->fd >= loop->ios.maxsize) continue;
+        hio_t* io = loop->ios.ptr[arm->fd];
+        if (io == NULL || io->id != arm->id || io->closed || !hio_is_uring(io)) continue;
+        nevents += uring_post_ops(ctx, io);
+    }
+    ctx->arms.size = 0;
+    hmutex_unlock(&ctx->arms_mutex);
+    return nevents;
+}
+
+// hio_done: the buffer in flight is handed over to op, and freed when cqe returned.
+static void uring_orphan_op(hio_t* io, huring_op_t* op) {
+    op->io = NULL;
+    if (op->op == HURING_OP_RECV) {
+        if (hio_is_alloced_readbuf(io) &&
+            op->buf >= io->readbuf.base &&
+            op->buf <  io->readbuf.base + io->readbuf.len) {
+            op->orphan = io->readbuf.base;
+            io->alloced_readbuf = 0;
+            io->readbuf.base = io->loop->readbuf.base;
+            io->readbuf.len  = io->loop->readbuf.len;
+        }
+    }
+    else if (op->op == HURING_OP_SEND) {
+        hrecursive_mutex_lock(&io->write_mutex);
+        hio_wbuf_t* pbuf = write_queue_front(&io->write_queue);
+        if (pbuf && pbuf->base + pbuf->offset == op->buf) {
+            op->orphan = pbuf->base;
+            op->orphan_free_cb = pbuf->free_cb;
+            op->orphan_userdata = pbuf->userdata;
+            io->write_bufsize -= pbuf->len - pbuf->offset;
+            write_queue_pop_front(&io->write_queue);
+        }
+        hrecursive_mutex_unlock(&io->write_mutex);
+    }
+}
+
+static void uring_cancel_op(io_uring_ctx_t* ctx, huring_op_t* op) {
+    if (op->done) return;
+    struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
+    if (sqe == NULL) return;
+    io_uring_prep_cancel(sqe, IO_URING_OP_DATA(op), 0);
+    io_uring_sqe_set_data(sqe, IO_URING_CANCEL_TAG);
+}
+
+static void uring_done_op(io_uring_ctx_t* ctx, hio_t* io, void** pop) {
+    huring_op_t* op = (huring_op_t*)*pop;
+    if (op == NULL) return;
+    *pop = NULL;
+    if (op->done) {
+        // cqe already reaped
+        uring_pbuf_recycle(io, op);
+        if (op->op == HURING_OP_ACCEPT && op->res >= 0) {
+            closesocket(op->res);
+        }
+        if (!(op->flags & IORING_CQE_F_MORE)) {
+            uring_free_op(op);
+            return;
+        }
+        op->done = 0;
+    }
+    uring_orphan_op(io, op);
+    uring_cancel_op(ctx, op);
+}
+
+void uring_cancel(hio_t* io, huring_op_t* op) {
+    io_uring_ctx_t* ctx = (io_uring_ctx_t*)io->loop->iowatcher;
+    if (ctx == NULL) return;
+    uring_cancel_op(ctx, op);
+}
+
+void uring_done_ops(hio_t* io) {
+    io_uring_ctx_t* ctx = (io_uring_ctx_t*)io->loop->iowatcher;
+    if (ctx == NULL) return;
+    uring_done_op(ctx, io, &io->uring_rop);
+    uring_done_op(ctx, io, &io->uring_wop);
+}
+
+//-----------------iowatcher---------------------------------------------
 int iowatcher_add_event(hloop_t* loop, int fd, int events) {
     if (loop->iowatcher == NULL) {
         int ret = iowatcher_init(loop);
@@ -58,6 +387,15 @@ int iowatcher_add_event(hloop_t* loop, int fd, int events) {
     io_uring_ctx_t* ctx = (io_uring_ctx_t*)loop->iowatcher;
     hio_t* io = loop->ios.ptr[fd];
 
+    if (hio_is_uring(io)) {
+        if (io->events == 0) {
+            ctx->nfds++;
+        }
+        // NOTE: accept/connect/recv/send will be submitted at next iowatcher_poll_events
+        uring_arm_ops(io);
+        return 0;
+    }
+
     unsigned poll_mask = 0;
     // pre events
     if (io->events & HV_READ) {
@@ -79,7 +417,7 @@ int iowatcher_add_event(hloop_t* loop, int fd, int events) {
         // Cancel the existing poll request first
         sqe = io_uring_get_sqe_safe(&ctx->ring);
         if (sqe == NULL) return -1;
-        io_uring_prep_poll_remove(sqe, (uint64_t)fd);
+        io_uring_prep_poll_remove(sqe, (uint64_t)(uintptr_t)IO_URING_POLL_DATA(fd));
         io_uring_sqe_set_data(sqe, IO_URING_CANCEL_TAG);
     } else {
         ctx->nfds++;
@@ -89,7 +427,7 @@ int iowatcher_add_event(hloop_t* loop, int fd, int events) {
     sqe = io_uring_get_sqe_safe(&ctx->ring);
     if (sqe == NULL) return -1;
     io_uring_prep_poll_add(sqe, fd, poll_mask);
-    io_uring_sqe_set_data(sqe, (void*)(uintptr_t)fd);
+    io_uring_sqe_set_data(sqe, IO_URING_POLL_DATA(fd));
 
     io_uring_submit(&ctx->ring);
     return 0;
@@ -100,6 +438,20 @@ int iowatcher_del_event(hloop_t* loop, int fd, int events) {
     if (ctx == NULL) return 0;
     hio_t* io = loop->ios.ptr[fd];
 
+    if (hio_is_uring(io)) {
+        if ((io->events & ~events) == 0) {
+            ctx->nfds--;
+        }
+        // NOTE: hio_done will call uring_done_ops.
+        if (!io->ready) return 0;
+        // NOTE: cancelled recv may still return data, which is kept in readbuf.
+        // Send in flight is not cancelled, let it finish.
+        if ((events & HV_READ) && io->uring_rop) {
+            uring_cancel_op(ctx, (huring_op_t*)io->uring_rop);
+        }
+        return 0;
+    }
+
     // Calculate remaining events
     unsigned poll_mask = 0;
     // pre events
@@ -120,7 +472,7 @@ int iowatcher_del_event(hloop_t* loop, int fd, int events) {
     // Cancel existing poll
     struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
     if (sqe == NULL) return -1;
-    io_uring_prep_poll_remove(sqe, (uint64_t)fd);
+    io_uring_prep_poll_remove(sqe, (uint64_t)(uintptr_t)IO_URING_POLL_DATA(fd));
     io_uring_sqe_set_data(sqe, IO_URING_CANCEL_TAG);
 
     if (poll_mask == 0) {
@@ -130,7 +482,7 @@ int iowatcher_del_event(hloop_t* loop, int fd, int events) {
         sqe = io_uring_get_sqe_safe(&ctx->ring);
         if (sqe == NULL) return -1;
         io_uring_prep_poll_add(sqe, fd, poll_mask);
-        io_uring_sqe_set_data(sqe, (void*)(uintptr_t)fd);
+        io_uring_sqe_set_data(sqe, IO_URING_POLL_DATA(fd));
     }
 
     io_uring_submit(&ctx->ring);
@@ -140,7 +492,18 @@ int iowatcher_del_event(hloop_t* loop, int fd, int events) {
 int iowatcher_poll_events(hloop_t* loop, int timeout) {
     io_uring_ctx_t* ctx = (io_uring_ctx_t*)loop->iowatcher;
     if (ctx == NULL) return 0;
-    if (ctx->nfds == 0) return 0;
+    int nevents = uring_flush_arms(loop, ctx);
+    if (ctx->nfds == 0) {
+        // submit pending cancellations
+        if (io_uring_sq_ready(&ctx->ring)) {
+            io_uring_submit(&ctx->ring);
+        }
+        return nevents;
+    }
+    if (nevents) {
+        // do not block, there are already pending events
+        timeout = 0;
+    }
 
     struct __kernel_timespec ts;
     struct __kernel_timespec* tp = NULL;
@@ -150,22 +513,17 @@ int iowatcher_poll_events(hloop_t* loop, int timeout) {
         tp = &ts;
     }
 
+    // NOTE: one syscall to submit all armed ops and wait for completions.
     struct io_uring_cqe* cqe;
-    int ret;
-    if (tp) {
-        ret = io_uring_wait_cqe_timeout(&ctx->ring, &cqe, tp);
-    } else {
-        ret = io_uring_wait_cqe(&ctx->ring, &cqe);
-    }
+    int ret = io_uring_submit_and_wait_timeout(&ctx->ring, &cqe, 1, tp, NULL);
     if (ret < 0) {
         if (ret == -ETIME || ret == -EINTR) {
-            return 0;
+            return nevents;
         }
         perror("io_uring_wait_cqe");
         return ret;
     }
 
-    int nevents = 0;
     int sqe_queued = 0;
     unsigned nready = io_uring_cq_ready(&ctx->ring);
     unsigned i;
@@ -177,7 +535,56 @@ int iowatcher_poll_events(hloop_t* loop, int timeout) {
             continue;
         }
 
-        int fd = (int)(uintptr_t)data;
+        if (IO_URING_IS_OP_DATA(data)) {
+            huring_op_t* op = IO_URING_OP_PTR(data);
+            hio_t* io = op->io;
+            if (io == NULL) {
+                // orphaned by hio_close
+                if (ctx->pbuf_ring && (cqe->flags & IORING_CQE_F_BUFFER)) {
+                    uring_pbuf_add(ctx, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+                }
+                if (op->op == HURING_OP_ACCEPT && cqe->res >= 0) {
+                    closesocket(cqe->res);
+                }
+                unsigned more = cqe->flags & IORING_CQE_F_MORE;
+                io_uring_cqe_seen(&ctx->ring, cqe);
+                if (!more) {
+                    uring_free_op(op);
+                }
+                continue;
+            }
+            if (op->done) {
+                // NOTE: multishot op, previous cqe not handled yet, leave it to next poll.
+                break;
+            }
+            op->res = cqe->res;
+            op->flags = cqe->flags;
+            op->done = 1;
+            if (op->multishot && op->res == -EINVAL) {
+                // kernel < 6.0, fallback to oneshot
+                if (op->op == HURING_OP_ACCEPT) {
+                    ctx->no_multishot_accept = 1;
+                } else {
+                    ctx->no_multishot_recv = 1;
+                }
+                op->res = -EAGAIN;
+            }
+            else if (op->bufsel && op->res == -ENOBUFS) {
+                // all provided buffers in use, recv again after recycled.
+                op->res = -EAGAIN;
+            }
+            if (op->op == HURING_OP_ACCEPT || op->op == HURING_OP_RECV) {
+                io->revents |= HV_READ;
+            } else {
+                io->revents |= HV_WRITE;
+            }
+            EVENT_PENDING(io);
+            ++nevents;
+            io_uring_cqe_seen(&ctx->ring, cqe);
+            continue;
+        }
+
+        int fd = IO_URING_POLL_FD(data);
         if (fd < 0 || fd >= loop->ios.maxsize) {
             io_uring_cqe_seen(&ctx->ring, cqe);
             continue;
@@ -217,7 +624,7 @@ int iowatcher_poll_events(hloop_t* loop, int timeout) {
             struct io_uring_sqe* sqe = io_uring_get_sqe_safe(&ctx->ring);
             if (sqe) {
                 io_uring_prep_poll_add(sqe, fd, remask);
-                io_uring_sqe_set_data(sqe, (void*)(uintptr_t)fd);
+                io_uring_sqe_set_data(sqe, IO_URING_POLL_DATA(fd));
                 sqe_queued = 1;
             }
         }
@@ -41,4 +41,14 @@ int iowatcher_add_event(hloop_t* loop, int fd, int events);
 int iowatcher_del_event(hloop_t* loop, int fd, int events);
 int iowatcher_poll_events(hloop_t* loop, int timeout);
 
+#if defined(EVENT_EPOLL) && defined(OS_LINUX)
+// @see HLOOP_FLAG_EDGE_TRIGGERED
+#define iowatcher_edge_triggered(loop)  ((loop)->flags & HLOOP_FLAG_EDGE_TRIGGERED)
+// NOTE: No more edge if events not drained, handle them in next poll without waiting.
+int iowatcher_set_ready(hloop_t* loop, int fd, int events);
+#else
+#define iowatcher_edge_triggered(loop)  0
+#define iowatcher_set_ready(loop, fd, events) 0
+#endif
+
 #endif
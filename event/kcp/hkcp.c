@@ -38,7 +38,7 @@ void kcp_release(kcp_t* kcp) {
 
 int hio_set_kcp(hio_t* io, kcp_setting_t* setting) {
     io->io_type = HIO_TYPE_KCP;
-    io->kcp_setting = setting;
+    hio_ext(io)->kcp_setting = setting;
     return 0;
 }
 
@@ -49,10 +49,10 @@ kcp_t* hio_get_kcp(hio_t* io, uint32_t conv, struct sockaddr* addr) {
     // return exist one
     if (kcp->ikcp != NULL) return kcp;
     // create new one
-    if (io->kcp_setting == NULL) {
-        io->kcp_setting = &s_kcp_setting;
+    if (io->ext->kcp_setting == NULL) {
+        io->ext->kcp_setting = &s_kcp_setting;
     }
-    kcp_setting_t* setting = io->kcp_setting;
+    kcp_setting_t* setting = io->ext->kcp_setting;
     kcp->ikcp = ikcp_create(conv, rudp);
     // printf("ikcp_create conv=%u ikcp=%p\n", conv, kcp->ikcp);
     kcp->ikcp->output = __kcp_output;
@@ -112,7 +112,7 @@ int hio_write_kcp(hio_t* io, const void* buf, size_t len, struct sockaddr* addr)
     if (hv_gettid() != io->loop->tid) {
         return hio_write_kcp_async(io, buf, len, addr);
     }
-    IUINT32 conv = io->kcp_setting ? io->kcp_setting->conv : 0;
+    IUINT32 conv = hio_ext_field(io, kcp_setting) ? io->ext->kcp_setting->conv : 0;
     kcp_t* kcp = hio_get_kcp(io, conv, addr);
     // printf("hio_write_kcp conv=%u=%u\n", conv, kcp->conv);
     int nsend = ikcp_send(kcp->ikcp, (const char*)buf, len);
@@ -6,6 +6,78 @@
 #include "hlog.h"
 #include "herr.h"
 #include "hthread.h"
+#include "uringio.h"
+
+#ifdef OS_WIN
+typedef WSABUF nio_iovec_t;
+#define NIO_IOV_SET(iov, b, l)  ((iov).buf = (char*)(b), (iov).len = (ULONG)(l))
+#else
+#include <sys/uio.h>
+typedef struct iovec nio_iovec_t;
+#define NIO_IOV_SET(iov, b, l)  ((iov).iov_base = (void*)(b), (iov).iov_len = (l))
+#endif
+
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define NIO_IOV_MAX     IOV_MAX
+#else
+#define NIO_IOV_MAX     1024
+#endif
+
+// NOTE: gather write_queue into one writev/sendmsg, kernel TLS encrypts plaintext too.
+#define nio_is_writev(io)   ((io)->io_type == HIO_TYPE_TCP || (io)->ktls_tx)
+
+// HLOOP_FLAG_EDGE_TRIGGERED: max reads/accepts per wakeup for fairness,
+// the rest is handled in next poll, @see iowatcher_set_ready
+#define NIO_READ_BUDGET     16
+#define nio_is_et(io)       iowatcher_edge_triggered((io)->loop)
+
+#if defined(OS_LINUX) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#define NIO_ZEROCOPY    1
+#define nio_is_zerocopy(io, len) ((io)->zerocopy_threshold && (len) >= (io)->zerocopy_threshold)
+#else
+#define nio_is_zerocopy(io, len) 0
+#endif
+
+#ifdef OS_LINUX
+#include <sys/sendfile.h>
+// page cache => socket in kernel, @see hio_sendfile
+#define NIO_SENDFILE    1
+#endif
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#ifdef SPLICE_F_MOVE
+// socket => pipe => socket in kernel, @see hio_set_splice_upstream
+#define NIO_SPLICE      1
+// F_SETPIPE_SZ, keep default 64K if over /proc/sys/fs/pipe-max-size
+#define NIO_SPLICE_PIPE_SIZE    (1 << 18)
+#define NIO_SPLICE_FLAGS        (SPLICE_F_MOVE | SPLICE_F_NONBLOCK)
+#endif
+#endif
+
+#ifdef OS_LINUX
+#include <netinet/udp.h>
+// recvmmsg/sendmmsg for batch datagram, @see hio_set_batch
+#define NIO_MMSG        1
+#define NIO_GRO_BUFSIZE 65536
+// UDP_MAX_SEGMENTS, payload must fit in one ipv6 udp packet
+#define NIO_GSO_MAXSEGS 64
+#define NIO_GSO_MAXSIZE (65535 - 8 - 40)
+
+#define nio_dgram_addr(io, dgram)   ((dgram)->addr ? (dgram)->addr : (io)->peeraddr)
+#define nio_sockaddr_equal(a, b) \
+    ((a) == (b) || (SOCKADDR_LEN(a) == SOCKADDR_LEN(b) && memcmp(a, b, SOCKADDR_LEN(a)) == 0))
+
+// loop->mmsgbuf: nio_mmsg_t + batch * slot data
+typedef struct nio_mmsg_s {
+    struct mmsghdr  msgs[HIO_MAX_BATCH];
+    struct iovec    iovs[HIO_MAX_BATCH];
+    sockaddr_u      addrs[HIO_MAX_BATCH];
+    char            control[HIO_MAX_BATCH][CMSG_SPACE(sizeof(int))];
+    hio_dgram_t     dgrams[HIO_MAX_BATCH];
+} nio_mmsg_t;
+#endif
 
 static void __connect_timeout_cb(htimer_t* timer) {
     hio_t* io = (hio_t*)timer->privdata;
@@ -52,6 +124,9 @@ static void __write_cb(hio_t* io, const void* buf, int writebytes) {
     // printd("< %.*s\n", writebytes, buf);
     io->last_write_hrtime = io->loop->cur_hrtime;
     hio_write_cb(io, buf, writebytes);
+    if (io->over_high_water) {
+        hio_write_water_cb(io);
+    }
 }
 
 static void __close_cb(hio_t* io) {
@@ -65,13 +140,27 @@ static void __close_cb(hio_t* io) {
     hio_close_cb(io);
 }
 
+static void ssl_handshake_finished(hio_t* io) {
+    printd("ssl handshake finished.\n");
+    int ktls = hssl_get_ktls(io->ext->ssl);
+    io->ktls_tx = (ktls & HSSL_KTLS_TX) ? 1 : 0;
+    io->ktls_rx = (ktls & HSSL_KTLS_RX) ? 1 : 0;
+    hloop_t* loop = io->loop;
+    HLOOP_STATS_WRITE_BEGIN(loop);
+    hatomic_add_relaxed(&loop->stats.ssl_handshakes, 1);
+    if (hssl_session_reused(io->ext->ssl)) hatomic_add_relaxed(&loop->stats.ssl_resumed, 1);
+    if (io->ktls_tx) hatomic_add_relaxed(&loop->stats.ktls_tx, 1);
+    if (io->ktls_rx) hatomic_add_relaxed(&loop->stats.ktls_rx, 1);
+    HLOOP_STATS_WRITE_END(loop);
+}
+
 static void ssl_server_handshake(hio_t* io) {
     printd("ssl server handshake...\n");
-    int ret = hssl_accept(io->ssl);
+    int ret = hssl_accept(io->ext->ssl);
     if (ret == 0) {
         // handshake finish
         hio_del(io, HV_READ);
-        printd("ssl handshake finished.\n");
+        ssl_handshake_finished(io);
         __accept_cb(io);
     }
     else if (ret == HSSL_WANT_READ) {
@@ -88,11 +177,11 @@ static void ssl_server_handshake(hio_t* io) {
 
 static void ssl_client_handshake(hio_t* io) {
     printd("ssl client handshake...\n");
-    int ret = hssl_connect(io->ssl);
+    int ret = hssl_connect(io->ext->ssl);
     if (ret == 0) {
         // handshake finish
         hio_del(io, HV_READ);
-        printd("ssl handshake finished.\n");
+        ssl_handshake_finished(io);
         __connect_cb(io);
     }
     else if (ret == HSSL_WANT_READ) {
@@ -107,12 +196,60 @@ static void ssl_client_handshake(hio_t* io) {
     }
 }
 
+static int nio_accept_conn(hio_t* io, int connfd) {
+    socklen_t addrlen = sizeof(sockaddr_u);
+    getsockname(connfd, io->localaddr, &addrlen);
+    hio_t* connio = hio_get(io->loop, connfd);
+    // NOTE: shared by nio_accept and nio_uring_accept
+    if (io->loop->sock_busy_poll_us > 0) {
+        so_busy_poll(connfd, io->loop->sock_busy_poll_us, 1);
+    }
+    // NOTE: inherit from listenio
+    connio->accept_cb = io->accept_cb;
+    connio->userdata = io->userdata;
+    if (hio_ext_field(io, unpack_setting)) {
+        hio_set_unpack(connio, io->ext->unpack_setting);
+    }
+
+    if (io->io_type == HIO_TYPE_SSL) {
+        if (hio_ext_field(connio, ssl) == NULL) {
+            // io->ssl_ctx > g_ssl_ctx > hssl_ctx_new
+            hssl_ctx_t ssl_ctx = NULL;
+            if (hio_ext_field(io, ssl_ctx)) {
+                ssl_ctx = io->ext->ssl_ctx;
+            } else if (g_ssl_ctx) {
+                ssl_ctx = g_ssl_ctx;
+            } else {
+                hio_ext(io)->ssl_ctx = ssl_ctx = hssl_ctx_new(NULL);
+                io->alloced_ssl_ctx = 1;
+            }
+            if (ssl_ctx == NULL) {
+                io->error = ERR_NEW_SSL_CTX;
+                return io->error;
+            }
+            hssl_t ssl = hssl_new(ssl_ctx, connfd);
+            if (ssl == NULL) {
+                io->error = ERR_NEW_SSL;
+                return io->error;
+            }
+            hio_ext(connio)->ssl = ssl;
+        }
+        hio_enable_ssl(connio);
+        ssl_server_handshake(connio);
+    }
+    else {
+        // NOTE: SSL call accept_cb after handshake finished
+        __accept_cb(connio);
+    }
+    return 0;
+}
+
 static void nio_accept(hio_t* io) {
     // printd("nio_accept listenfd=%d\n", io->fd);
     int connfd = 0, err = 0, accept_cnt = 0;
+    int max_accept_cnt = nio_is_et(io) ? NIO_READ_BUDGET : 3;
     socklen_t addrlen;
-    hio_t* connio = NULL;
-    while (accept_cnt++ < 3) {
+    while (accept_cnt++ < max_accept_cnt) {
         addrlen = sizeof(sockaddr_u);
         connfd = accept(io->fd, io->peeraddr, &addrlen);
         if (connfd < 0) {
@@ -125,47 +262,14 @@ static void nio_accept(hio_t* io) {
                 goto accept_error;
             }
         }
-        addrlen = sizeof(sockaddr_u);
-        getsockname(connfd, io->localaddr, &addrlen);
-        connio = hio_get(io->loop, connfd);
-        // NOTE: inherit from listenio
-        connio->accept_cb = io->accept_cb;
-        connio->userdata = io->userdata;
-        if (io->unpack_setting) {
-            hio_set_unpack(connio, io->unpack_setting);
-        }
-
-        if (io->io_type == HIO_TYPE_SSL) {
-            if (connio->ssl == NULL) {
-                // io->ssl_ctx > g_ssl_ctx > hssl_ctx_new
-                hssl_ctx_t ssl_ctx = NULL;
-                if (io->ssl_ctx) {
-                    ssl_ctx = io->ssl_ctx;
-                } else if (g_ssl_ctx) {
-                    ssl_ctx = g_ssl_ctx;
-                } else {
-                    io->ssl_ctx = ssl_ctx = hssl_ctx_new(NULL);
-                    io->alloced_ssl_ctx = 1;
-                }
-                if (ssl_ctx == NULL) {
-                    io->error = ERR_NEW_SSL_CTX;
-                    goto accept_error;
-                }
-                hssl_t ssl = hssl_new(ssl_ctx, connfd);
-                if (ssl == NULL) {
-                    io->error = ERR_NEW_SSL;
-                    goto accept_error;
-                }
-                connio->ssl = ssl;
-            }
-            hio_enable_ssl(connio);
-            ssl_server_handshake(connio);
-        }
-        else {
-            // NOTE: SSL call accept_cb after handshake finished
-            __accept_cb(connio);
+        if (nio_accept_conn(io, connfd) != 0) {
+            goto accept_error;
         }
     }
+    if (nio_is_et(io) && (io->events & HV_READ)) {
+        // NOTE: not drained
+        iowatcher_set_ready(io->loop, io->fd, HV_READ);
+    }
     return;
 
 accept_error:
@@ -187,15 +291,15 @@ static void nio_connect(hio_t* io) {
         getsockname(io->fd, io->localaddr, &addrlen);
 
         if (io->io_type == HIO_TYPE_SSL) {
-            if (io->ssl == NULL) {
+            if (hio_ext_field(io, ssl) == NULL) {
                 // io->ssl_ctx > g_ssl_ctx > hssl_ctx_new
                 hssl_ctx_t ssl_ctx = NULL;
-                if (io->ssl_ctx) {
-                    ssl_ctx = io->ssl_ctx;
+                if (hio_ext_field(io, ssl_ctx)) {
+                    ssl_ctx = io->ext->ssl_ctx;
                 } else if (g_ssl_ctx) {
                     ssl_ctx = g_ssl_ctx;
                 } else {
-                    io->ssl_ctx = ssl_ctx = hssl_ctx_new(NULL);
+                    hio_ext(io)->ssl_ctx = ssl_ctx = hssl_ctx_new(NULL);
                     io->alloced_ssl_ctx = 1;
                 }
                 if (ssl_ctx == NULL) {
@@ -207,11 +311,19 @@ static void nio_connect(hio_t* io) {
                     io->error = ERR_NEW_SSL;
                     goto connect_error;
                 }
-                io->ssl = ssl;
+                hio_ext(io)->ssl = ssl;
             }
-            if (io->hostname) {
-                hssl_set_sni_hostname(io->ssl, io->hostname);
+            if (hio_ext_field(io, hostname)) {
+                hssl_set_sni_hostname(io->ext->ssl, io->ext->hostname);
             }
+            // resume session of the same host:port
+            char peer[SOCKADDR_STRLEN + 256] = {0};
+            if (hio_ext_field(io, hostname)) {
+                snprintf(peer, sizeof(peer), "%s:%d", io->ext->hostname, sockaddr_port((sockaddr_u*)io->peeraddr));
+            } else {
+                SOCKADDR_STR(io->peeraddr, peer);
+            }
+            hssl_reuse_session(io->ext->ssl, peer);
             ssl_client_handshake(io);
         }
         else {
@@ -248,7 +360,7 @@ static int __nio_read(hio_t* io, void* buf, int len) {
     int nread = 0;
     switch (io->io_type) {
     case HIO_TYPE_SSL:
-        nread = hssl_read(io->ssl, buf, len);
+        nread = hssl_read(io->ext->ssl, buf, len);
         break;
     case HIO_TYPE_TCP:
         nread = recv(io->fd, buf, len, 0);
@@ -273,16 +385,17 @@ static int __nio_write(hio_t* io, const void* buf, int len, struct sockaddr* add
     int nwrite = 0;
     switch (io->io_type) {
     case HIO_TYPE_SSL:
-        nwrite = hssl_write(io->ssl, buf, len);
-        break;
     case HIO_TYPE_TCP:
-    {
-        int flag = 0;
+        if (io->io_type == HIO_TYPE_SSL && !io->ktls_tx) {
+            nwrite = hssl_write(io->ext->ssl, buf, len);
+        } else {
+            // NOTE: kernel TLS encrypts plaintext
+            int flag = 0;
 #ifdef MSG_NOSIGNAL
-        flag |= MSG_NOSIGNAL;
+            flag |= MSG_NOSIGNAL;
 #endif
-        nwrite = send(io->fd, buf, len, flag);
-    }
+            nwrite = send(io->fd, buf, len, flag);
+        }
         break;
     case HIO_TYPE_UDP:
     case HIO_TYPE_KCP:
@@ -304,16 +417,412 @@ static int __nio_write(hio_t* io, const void* buf, int len, struct sockaddr* add
     return nwrite;
 }
 
+static int __nio_writev(hio_t* io, nio_iovec_t* iov, int iovcnt) {
+    int nwrite = 0;
+#ifdef OS_WIN
+    DWORD bytes = 0;
+    nwrite = WSASend(io->fd, iov, iovcnt, &bytes, 0, NULL, NULL);
+    if (nwrite == 0) nwrite = bytes;
+#else
+    if (io->io_type == HIO_TYPE_TCP || io->ktls_tx) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        int flag = 0;
+#ifdef MSG_NOSIGNAL
+        flag |= MSG_NOSIGNAL;
+#endif
+        nwrite = sendmsg(io->fd, &msg, flag);
+    } else {
+        nwrite = writev(io->fd, iov, iovcnt);
+    }
+#endif
+    // hlogd("writev retval=%d", nwrite);
+    return nwrite;
+}
+
+#ifdef NIO_ZEROCOPY
+// @return nwrite, *zerocopy = 1 if sent with MSG_ZEROCOPY and nwrite > 0
+static int nio_send_zerocopy(hio_t* io, nio_iovec_t* iov, int iovcnt, int* zerocopy) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    int nwrite = sendmsg(io->fd, &msg, MSG_ZEROCOPY | MSG_NOSIGNAL);
+    if (nwrite > 0) {
+        *zerocopy = 1;
+        return nwrite;
+    }
+    *zerocopy = 0;
+    if (nwrite < 0 && socket_errno() == ENOBUFS) {
+        // NOTE: over optmem_max, too many notifications in flight.
+        return __nio_writev(io, iov, iovcnt);
+    }
+    return nwrite;
+}
+
+// read notifications from socket error queue, free buffers completed.
+static void nio_zerocopy_complete(hio_t* io) {
+    char control[128];
+    struct msghdr msg;
+    struct cmsghdr* cm;
+    struct sock_extended_err* serr;
+    hio_wbuf_t wbuf;
+    hrecursive_mutex_lock(&io->write_mutex);
+    while (io->zerocopy_done != io->zerocopy_seq) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(io->fd, &msg, MSG_ERRQUEUE) < 0) break;
+        for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(cm->cmsg_level == SOL_IP   && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+            serr = (struct sock_extended_err*)CMSG_DATA(cm);
+            if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) continue;
+            // [ee_info, ee_data] completed
+            if ((int32_t)(serr->ee_data + 1 - io->zerocopy_done) > 0) {
+                io->zerocopy_done = serr->ee_data + 1;
+            }
+            if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && io->zerocopy_threshold) {
+                hlogi("zerocopy fd=%d deferred copy by kernel, disable it.", io->fd);
+                io->zerocopy_threshold = 0;
+            }
+        }
+    }
+    while (!zerocopy_queue_empty(&io->zerocopy_queue)) {
+        wbuf = *zerocopy_queue_front(&io->zerocopy_queue);
+        if ((int32_t)(wbuf.zerocopy_seq - io->zerocopy_done) >= 0) break;
+        zerocopy_queue_pop_front(&io->zerocopy_queue);
+        io->zerocopy_bufsize -= wbuf.len;
+        hio_free_wbuf(&wbuf);
+    }
+    hrecursive_mutex_unlock(&io->write_mutex);
+}
+
+int hio_set_zerocopy(hio_t* io, uint32_t threshold) {
+#ifdef EVENT_IO_URING
+    if (hio_is_uring(io)) return -1;
+#endif
+    if (io->io_type != HIO_TYPE_TCP) return -1;
+    int on = threshold ? 1 : 0;
+    if (setsockopt(io->fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(int)) != 0) {
+        hlogw("setsockopt SO_ZEROCOPY fd=%d error=%d", io->fd, socket_errno());
+        return -1;
+    }
+    io->zerocopy_threshold = threshold;
+    return 0;
+}
+#else
+int hio_set_zerocopy(hio_t* io, uint32_t threshold) {
+    return threshold ? -1 : 0;
+}
+#endif
+
+#ifdef NIO_SPLICE
+static void hio_handle_events(hio_t* io);
+
+static int nio_is_spliceable(hio_t* io) {
+#ifdef EVENT_IO_URING
+    if (hio_is_uring(io)) return 0;
+#endif
+    // NOTE: ssl must encrypt/decrypt in userspace
+    return io->io_type == HIO_TYPE_TCP && !io->closed &&
+           hio_ext_field(io, unpack_setting) == NULL;
+}
+
+// NOTE: read_cb or unpack set after hio_set_splice_upstream takes the copy path,
+// bytes left in splice_pipe are flushed first to keep order.
+static int nio_is_splice_relay(hio_t* io) {
+    return io->splice && (io->ext->splice_pipe_bytes ||
+           (io->read_cb == hio_write_upstream && io->ext->unpack_setting == NULL));
+}
+
+static int nio_splice_init(hio_t* io) {
+    if (io->splice) return 0;
+    hio_ext_t* ext = hio_ext(io);
+    if (pipe2(ext->splice_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        hlogw("splice pipe2 error=%d", errno);
+        return -1;
+    }
+    int size = fcntl(ext->splice_pipe[1], F_SETPIPE_SZ, NIO_SPLICE_PIPE_SIZE);
+    if (size < 0) size = fcntl(ext->splice_pipe[1], F_GETPIPE_SZ);
+    ext->splice_pipe_size = size > 0 ? size : 65536;
+    ext->splice_pipe_bytes = 0;
+    io->splice = 1;
+    io->splice_eof = 0;
+    return 0;
+}
+
+static void nio_splice_cleanup(hio_t* io) {
+    if (!io->splice) return;
+    io->splice = 0;
+    close(io->ext->splice_pipe[0]);
+    close(io->ext->splice_pipe[1]);
+    io->ext->splice_pipe_bytes = 0;
+}
+
+// splice_pipe => upstream_io
+// @return 0 if drained, 1 if upstream_io not writable, -1 if closed
+static int nio_splice_flush(hio_t* io) {
+    hio_ext_t* ext = io->ext;
+    hio_t* upstream_io = ext->upstream_io;
+    ssize_t nsplice;
+    int err, queued;
+    while (ext->splice_pipe_bytes) {
+        // NOTE: keep order with hio_write(upstream_io), e.g. reply of socks5
+        hrecursive_mutex_lock(&upstream_io->write_mutex);
+        queued = !write_queue_empty(&upstream_io->write_queue);
+        hrecursive_mutex_unlock(&upstream_io->write_mutex);
+        if (queued) goto blocked;
+        nsplice = splice(ext->splice_pipe[0], NULL, upstream_io->fd, NULL, ext->splice_pipe_bytes, NIO_SPLICE_FLAGS);
+        if (nsplice < 0) {
+            err = errno;
+            if (err == EINTR) continue;
+            if (err == EAGAIN) goto blocked;
+            upstream_io->error = err;
+            hio_close(upstream_io);
+            hio_close(io);
+            return -1;
+        }
+        ext->splice_pipe_bytes -= nsplice;
+        ext->splice_bytes += nsplice;
+        upstream_io->last_write_hrtime = io->loop->cur_hrtime;
+    }
+    return 0;
+blocked:
+    // stop reading io until upstream_io writable, @see nio_splice_resume
+    hio_del(io, HV_READ);
+    hio_add(upstream_io, hio_handle_events, HV_WRITE);
+    return 1;
+}
+
+// io writable => flush splice_pipe of io->upstream_io => resume reading io->upstream_io
+static void nio_splice_resume(hio_t* io) {
+    hio_t* src = hio_ext_field(io, upstream_io);
+    if (src == NULL || !src->splice || src->closed || src->ext->splice_pipe_bytes == 0) return;
+    if (nio_splice_flush(src) != 0) return;
+    hio_add(src, hio_handle_events, HV_READ);
+}
+
+static void nio_splice_eof(hio_t* io) {
+    hio_t* upstream_io = io->ext->upstream_io;
+    io->splice_eof = 1;
+    hio_del(io, HV_READ);
+    int queued;
+    hrecursive_mutex_lock(&upstream_io->write_mutex);
+    queued = !write_queue_empty(&upstream_io->write_queue);
+    hrecursive_mutex_unlock(&upstream_io->write_mutex);
+    // both EOF, or close upstream_io after write_queue written like hio_write_upstream
+    if (upstream_io->splice_eof || queued) {
+        hio_close(io);
+        return;
+    }
+    // half-close
+    shutdown(upstream_io->fd, SHUT_WR);
+}
+
+static void nio_splice(hio_t* io) {
+    hio_ext_t* ext = io->ext;
+    hio_t* upstream_io = ext->upstream_io;
+    ssize_t nsplice;
+    int err, nreads = 0;
+    if (upstream_io == NULL || upstream_io->closed) {
+        hio_close(io);
+        return;
+    }
+    // NOTE: io->connected only set by connect, not accept
+    if (upstream_io->connect || ext->splice_pipe_bytes) {
+        // wait on_connect => hio_read_upstream, or nio_splice_resume
+        hio_del(io, HV_READ);
+        return;
+    }
+splice:
+    nsplice = splice(io->fd, NULL, ext->splice_pipe[1], NULL, ext->splice_pipe_size, NIO_SPLICE_FLAGS);
+    if (nsplice < 0) {
+        err = errno;
+        if (err == EAGAIN || err == EINTR) return;
+        io->error = err;
+        hio_close(io);
+        return;
+    }
+    if (nsplice == 0) {
+        nio_splice_eof(io);
+        return;
+    }
+    io->last_read_hrtime = io->loop->cur_hrtime;
+    ext->splice_pipe_bytes = nsplice;
+    if (nio_splice_flush(io) != 0) return;
+    if (!io->closed && (io->events & HV_READ)) {
+        // NOTE: splice may be short of pipe slots, drain until EAGAIN for edge-triggered.
+        if (nio_is_et(io) || (uint32_t)nsplice == ext->splice_pipe_size) {
+            if (++nreads < NIO_READ_BUDGET) goto splice;
+            if (nio_is_et(io)) iowatcher_set_ready(io->loop, io->fd, HV_READ);
+        }
+    }
+}
+
+int hio_set_splice_upstream(hio_t* io, int on) {
+    hio_t* upstream_io = hio_ext_field(io, upstream_io);
+    if (upstream_io == NULL) return -1;
+    if (!on) {
+        if (io->splice && io->ext->splice_pipe_bytes) return -1;
+        if (upstream_io->splice && upstream_io->ext->splice_pipe_bytes) return -1;
+        nio_splice_cleanup(io);
+        nio_splice_cleanup(upstream_io);
+        return 0;
+    }
+    if (!nio_is_spliceable(io) || !nio_is_spliceable(upstream_io)) return -1;
+    if (nio_splice_init(io) != 0) return -1;
+    if (nio_splice_init(upstream_io) != 0) {
+        nio_splice_cleanup(io);
+        return -1;
+    }
+    return 0;
+}
+#else
+int hio_set_splice_upstream(hio_t* io, int on) {
+    return on ? -1 : 0;
+}
+#endif
+
+// release written buffer, hold it until notification if sent with MSG_ZEROCOPY
+static void nio_release_wbuf(hio_t* io, hio_wbuf_t* wbuf) {
+    if (wbuf->zerocopy) {
+        if (io->zerocopy_queue.maxsize == 0) {
+            zerocopy_queue_init(&io->zerocopy_queue, 4);
+        }
+        zerocopy_queue_push_back(&io->zerocopy_queue, wbuf);
+        io->zerocopy_bufsize += wbuf->len;
+        return;
+    }
+    hio_free_wbuf(wbuf);
+}
+
+#ifdef NIO_MMSG
+static nio_mmsg_t* nio_mmsg_get(hloop_t* loop, size_t datalen) {
+    size_t len = sizeof(nio_mmsg_t) + datalen;
+    if (loop->mmsgbuf.len < len) {
+        HV_FREE(loop->mmsgbuf.base);
+        HV_ALLOC(loop->mmsgbuf.base, len);
+        loop->mmsgbuf.len = len;
+    }
+    return (nio_mmsg_t*)loop->mmsgbuf.base;
+}
+
+static void nio_read_batch_cb(hio_t* io, hio_dgram_t* dgrams, int cnt) {
+    if (io->read_batch_cb) {
+        io->read_batch_cb(io, dgrams, cnt);
+        return;
+    }
+    for (int i = 0; i < cnt && !io->closed; ++i) {
+        memcpy(io->peeraddr, dgrams[i].addr, SOCKADDR_LEN(dgrams[i].addr));
+        // NOTE: buf is not in readbuf, kcp only needs buf.
+        if (io->io_type == HIO_TYPE_KCP) {
+            hio_handle_read(io, dgrams[i].buf, dgrams[i].len);
+        } else {
+            hio_read_cb(io, dgrams[i].buf, dgrams[i].len);
+        }
+    }
+}
+
+static void nio_read_batch(hio_t* io) {
+    // printd("nio_read_batch fd=%d\n", io->fd);
+    int batch = io->read_batch;
+    size_t slot = io->udp_gro ? NIO_GRO_BUFSIZE : io->readbuf.len;
+    nio_mmsg_t* mm = nio_mmsg_get(io->loop, batch * slot);
+    char* data = (char*)(mm + 1);
+    int nreads = 0;
+read:
+    for (int i = 0; i < batch; ++i) {
+        struct msghdr* msg = &mm->msgs[i].msg_hdr;
+        mm->iovs[i].iov_base = data + i * slot;
+        mm->iovs[i].iov_len = slot;
+        msg->msg_name = &mm->addrs[i];
+        msg->msg_namelen = sizeof(sockaddr_u);
+        msg->msg_iov = &mm->iovs[i];
+        msg->msg_iovlen = 1;
+        msg->msg_control = io->udp_gro ? mm->control[i] : NULL;
+        msg->msg_controllen = io->udp_gro ? sizeof(mm->control[i]) : 0;
+        msg->msg_flags = 0;
+    }
+    int nmsgs = recvmmsg(io->fd, mm->msgs, batch, 0, NULL);
+    // printd("recvmmsg retval=%d\n", nmsgs);
+    if (nmsgs < 0) {
+        int err = socket_errno();
+        if (err != EAGAIN && err != EINTR) {
+            io->error = err;
+        }
+        return;
+    }
+    io->last_read_hrtime = io->loop->cur_hrtime;
+    int cnt = 0;
+    for (int i = 0; i < nmsgs && !io->closed; ++i) {
+        char* buf = (char*)mm->iovs[i].iov_base;
+        int len = mm->msgs[i].msg_len;
+        int segsize = 0;
+#ifdef UDP_GRO
+        if (io->udp_gro) {
+            struct msghdr* msg = &mm->msgs[i].msg_hdr;
+            struct cmsghdr* cm;
+            for (cm = CMSG_FIRSTHDR(msg); cm; cm = CMSG_NXTHDR(msg, cm)) {
+                if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+                    segsize = *(int*)CMSG_DATA(cm);
+                }
+            }
+        }
+#endif
+        if (segsize <= 0) segsize = len;
+        // NOTE: split coalesced datagrams by segsize, the last one may be shorter.
+        do {
+            int seglen = MIN(segsize, len);
+            mm->dgrams[cnt].buf = buf;
+            mm->dgrams[cnt].len = seglen;
+            mm->dgrams[cnt].addr = &mm->addrs[i].sa;
+            if (++cnt == HIO_MAX_BATCH) {
+                nio_read_batch_cb(io, mm->dgrams, cnt);
+                cnt = 0;
+                if (io->closed) return;
+            }
+            buf += seglen;
+            len -= seglen;
+        } while (len > 0);
+    }
+    if (cnt > 0 && !io->closed) {
+        nio_read_batch_cb(io, mm->dgrams, cnt);
+    }
+    if (nio_is_et(io) && !io->closed && (io->events & HV_READ) && nmsgs == batch) {
+        // NOTE: drain until EAGAIN
+        if (++nreads < NIO_READ_BUDGET) goto read;
+        iowatcher_set_ready(io->loop, io->fd, HV_READ);
+    }
+}
+#endif
+
 static void nio_read(hio_t* io) {
     // printd("nio_read fd=%d\n", io->fd);
     void* buf;
-    int len = 0, nread = 0, err = 0;
+    int len = 0, nread = 0, err = 0, nreads = 0;
+#ifdef NIO_MMSG
+    if (io->read_batch) {
+        nio_read_batch(io);
+        return;
+    }
+#endif
+#ifdef NIO_SPLICE
+    if (nio_is_splice_relay(io)) {
+        nio_splice(io);
+        return;
+    }
+#endif
 read:
     buf = io->readbuf.base + io->readbuf.tail;
     if (io->read_flags & HIO_READ_UNTIL_LENGTH) {
         len = io->read_until_length - (io->readbuf.tail - io->readbuf.head);
     } else {
-        len = io->readbuf.len - io->readbuf.tail;
+        len = hio_readbuf_end(io) - io->readbuf.tail;
     }
     assert(len > 0);
     nread = __nio_read(io, buf, len);
@@ -347,6 +856,14 @@ read:
             goto read;
         }
     }
+    if (nio_is_et(io) && !io->closed && (io->events & HV_READ)) {
+        // NOTE: drain until EAGAIN, short read of stream means drained, except EOF pending.
+        // ssl returns one record at a time, so a short read of ssl means nothing.
+        if (nread == len || io->rdhup || io->io_type == HIO_TYPE_SSL || !(io->io_type & HIO_TYPE_SOCK_STREAM)) {
+            if (++nreads < NIO_READ_BUDGET) goto read;
+            iowatcher_set_ready(io->loop, io->fd, HV_READ);
+        }
+    }
     return;
 read_error:
 disconnect:
@@ -355,9 +872,12 @@ disconnect:
     }
 }
 
-static void nio_write(hio_t* io) {
-    // printd("nio_write fd=%d\n", io->fd);
-    int nwrite = 0, err = 0;
+static void nio_writev(hio_t* io) {
+    // printd("nio_writev fd=%d\n", io->fd);
+    nio_iovec_t iov[NIO_IOV_MAX];
+    int iovcnt = 0, nwrite = 0, err = 0, zerocopy = 0;
+    uint32_t zerocopy_seq = 0;
+    size_t total = 0;
     hrecursive_mutex_lock(&io->write_mutex);
 write:
     if (write_queue_empty(&io->write_queue)) {
@@ -368,57 +888,427 @@ write:
         }
         return;
     }
-    offset_buf_t* pbuf = write_queue_front(&io->write_queue);
-    char* base = pbuf->base;
-    char* buf = base + pbuf->offset;
-    int len = pbuf->len - pbuf->offset;
-    struct sockaddr* addr = NULL;
-    if (io->io_type & (HIO_TYPE_SOCK_DGRAM | HIO_TYPE_SOCK_RAW)) {
-        addr = (struct sockaddr*)base;
+#ifdef NIO_SENDFILE
+    if (write_queue_front(&io->write_queue)->sendfile) {
+        hio_wbuf_t* pbuf = write_queue_front(&io->write_queue);
+        hio_wbuf_t wbuf = *pbuf;
+        off_t offset = pbuf->offset;
+        nwrite = sendfile(io->fd, pbuf->fd, &offset, pbuf->len - pbuf->offset);
+        if (nwrite < 0) {
+            err = socket_errno();
+            if (err == EAGAIN || err == EINTR) {
+                hrecursive_mutex_unlock(&io->write_mutex);
+                return;
+            }
+            io->error = err;
+            goto write_error;
+        }
+        if (nwrite == 0) {
+            // file truncated
+            io->error = ERR_READ_FILE;
+            goto write_error;
+        }
+        pbuf->offset += nwrite;
+        io->write_bufsize -= nwrite;
+        io->sendfile_bufsize -= nwrite;
+        total = wbuf.len - wbuf.offset - nwrite;
+        __write_cb(io, NULL, nwrite);
+        if (io->closed) {
+            hrecursive_mutex_unlock(&io->write_mutex);
+            return;
+        }
+        if (total == 0) {
+            // NOTE: after write_cb, pbuf maybe invalid.
+            write_queue_pop_front(&io->write_queue);
+            hio_free_wbuf(&wbuf);
+        }
+        if (total == 0 || nio_is_et(io)) goto write;
+        hrecursive_mutex_unlock(&io->write_mutex);
+        return;
     }
-    nwrite = __nio_write(io, buf, len, addr);
-    // printd("write retval=%d\n", nwrite);
+#endif
+    iovcnt = 0;
+    total = 0;
+    for (int i = 0; i < write_queue_size(&io->write_queue) && iovcnt < NIO_IOV_MAX; ++i) {
+        hio_wbuf_t* pbuf = write_queue_data(&io->write_queue) + i;
+        // NOTE: gather until file, @see hio_sendfile
+        if (pbuf->sendfile) break;
+        NIO_IOV_SET(iov[iovcnt], pbuf->base + pbuf->offset, pbuf->len - pbuf->offset);
+        total += pbuf->len - pbuf->offset;
+        ++iovcnt;
+    }
+    zerocopy = 0;
+#ifdef NIO_ZEROCOPY
+    if (nio_is_zerocopy(io, total)) {
+        nwrite = nio_send_zerocopy(io, iov, iovcnt, &zerocopy);
+    } else
+#endif
+    nwrite = __nio_writev(io, iov, iovcnt);
+    // printd("writev retval=%d\n", nwrite);
     if (nwrite < 0) {
         err = socket_errno();
         if (err == EAGAIN || err == EINTR) {
             hrecursive_mutex_unlock(&io->write_mutex);
             return;
         } else {
-            // perror("write");
+            // perror("writev");
             io->error = err;
             goto write_error;
         }
     }
-    if (nwrite == 0 && (io->io_type & HIO_TYPE_SOCK_STREAM)) {
+    if (nwrite == 0) {
         goto disconnect;
     }
-    pbuf->offset += nwrite;
-    io->write_bufsize -= nwrite;
-    __write_cb(io, buf, nwrite);
-    if (nwrite == len) {
-        // NOTE: after write_cb, pbuf maybe invalid.
-        // HV_FREE(pbuf->base);
-        HV_FREE(base);
-        write_queue_pop_front(&io->write_queue);
-        if (!io->closed) {
-            // write continue
-            goto write;
+    if (zerocopy) {
+        zerocopy_seq = io->zerocopy_seq++;
+    }
+    if (nwrite == total) {
+        total = 0;
+    }
+    // NOTE: nwrite may end in the middle of any iovec.
+    while (nwrite > 0) {
+        hio_wbuf_t* pbuf = write_queue_front(&io->write_queue);
+        if (zerocopy) {
+            pbuf->zerocopy = 1;
+            pbuf->zerocopy_seq = zerocopy_seq;
+        }
+        hio_wbuf_t wbuf = *pbuf;
+        char* buf = pbuf->base + pbuf->offset;
+        int len = pbuf->len - pbuf->offset;
+        int n = MIN(nwrite, len);
+        pbuf->offset += n;
+        io->write_bufsize -= n;
+        nwrite -= n;
+        __write_cb(io, buf, n);
+        if (io->closed) {
+            hrecursive_mutex_unlock(&io->write_mutex);
+            return;
         }
+        if (n == len) {
+            // NOTE: after write_cb, pbuf maybe invalid.
+            write_queue_pop_front(&io->write_queue);
+            nio_release_wbuf(io, &wbuf);
+        }
+    }
+    if (total == 0 || nio_is_et(io)) {
+        // all written, write continue
+        // NOTE: edge-triggered write until EAGAIN
+        goto write;
     }
     hrecursive_mutex_unlock(&io->write_mutex);
     return;
 write_error:
 disconnect:
     hrecursive_mutex_unlock(&io->write_mutex);
-    if (io->io_type & HIO_TYPE_SOCK_STREAM) {
-        hio_close(io);
-    }
+    hio_close(io);
 }
 
-static void hio_handle_events(hio_t* io) {
-    if ((io->events & HV_READ) && (io->revents & HV_READ)) {
-        if (io->accept) {
-            nio_accept(io);
+static void nio_write(hio_t* io) {
+    // printd("nio_write fd=%d\n", io->fd);
+    if (nio_is_writev(io)) {
+        nio_writev(io);
+        return;
+    }
+    int nwrite = 0, err = 0;
+    hrecursive_mutex_lock(&io->write_mutex);
+write:
+    if (write_queue_empty(&io->write_queue)) {
+        hrecursive_mutex_unlock(&io->write_mutex);
+        if (io->close) {
+            io->close = 0;
+            hio_close(io);
+        }
+        return;
+    }
+    hio_wbuf_t* pbuf = write_queue_front(&io->write_queue);
+    hio_wbuf_t wbuf = *pbuf;
+    char* base = pbuf->base;
+    char* buf = base + pbuf->offset;
+    int len = pbuf->len - pbuf->offset;
+    struct sockaddr* addr = NULL;
+    if (io->io_type & (HIO_TYPE_SOCK_DGRAM | HIO_TYPE_SOCK_RAW)) {
+        addr = (struct sockaddr*)base;
+    }
+    nwrite = __nio_write(io, buf, len, addr);
+    // printd("write retval=%d\n", nwrite);
+    if (nwrite < 0) {
+        err = socket_errno();
+        if (err == EAGAIN || err == EINTR) {
+            hrecursive_mutex_unlock(&io->write_mutex);
+            return;
+        } else {
+            // perror("write");
+            io->error = err;
+            goto write_error;
+        }
+    }
+    if (nwrite == 0 && (io->io_type & HIO_TYPE_SOCK_STREAM)) {
+        goto disconnect;
+    }
+    pbuf->offset += nwrite;
+    io->write_bufsize -= nwrite;
+    __write_cb(io, buf, nwrite);
+    if (nwrite == len) {
+        // NOTE: after write_cb, pbuf maybe invalid.
+        write_queue_pop_front(&io->write_queue);
+        hio_free_wbuf(&wbuf);
+        if (!io->closed) {
+            // write continue
+            goto write;
+        }
+    }
+    else if (nio_is_et(io) && !io->closed) {
+        // NOTE: edge-triggered write until EAGAIN
+        goto write;
+    }
+    hrecursive_mutex_unlock(&io->write_mutex);
+    return;
+write_error:
+disconnect:
+    hrecursive_mutex_unlock(&io->write_mutex);
+    if (io->io_type & HIO_TYPE_SOCK_STREAM) {
+        hio_close(io);
+    }
+}
+
+#ifdef EVENT_IO_URING
+static void nio_uring_accept(hio_t* io, huring_op_t* op) {
+    if (op->res < 0) {
+        int err = -op->res;
+        if (err == EAGAIN || err == EINTR || err == ECANCELED) return;
+        io->error = err;
+        hloge("listenfd=%d accept error: %s:%d", io->fd, socket_strerror(io->error), io->error);
+        return;
+    }
+    int connfd = op->res;
+    if (op->multishot) {
+        socklen_t addrlen = sizeof(sockaddr_u);
+        getpeername(connfd, io->peeraddr, &addrlen);
+    } else {
+        memcpy(io->peeraddr, &op->addr, sizeof(sockaddr_u));
+    }
+    if (nio_accept_conn(io, connfd) != 0) {
+        hloge("listenfd=%d accept error: %s:%d", io->fd, socket_strerror(io->error), io->error);
+    }
+}
+
+static void nio_uring_connect(hio_t* io, huring_op_t* op) {
+    // NOTE: connect just do once
+    io->connect = 0;
+    if (op->res < 0) {
+        io->error = -op->res;
+        hlogw("connfd=%d connect error: %s:%d", io->fd, socket_strerror(io->error), io->error);
+        hio_close(io);
+        return;
+    }
+    hrecursive_mutex_lock(&io->write_mutex);
+    if (write_queue_empty(&io->write_queue)) {
+        hio_del(io, HV_WRITE);
+    }
+    hrecursive_mutex_unlock(&io->write_mutex);
+    nio_connect(io);
+}
+
+static int nio_readbuf_reserve(hio_t* io, size_t len) {
+    fifo_buf_t* rb = &io->readbuf;
+    if (rb->len - rb->tail >= len) return 0;
+    hio_memmove_readbuf(io);
+    if (rb->len - rb->tail >= len) return 0;
+    size_t newsize = rb->len;
+    while (newsize < rb->tail + len) newsize *= 2;
+    char* old = rb->base;
+    bool alloced = hio_is_alloced_readbuf(io);
+    hio_alloc_readbuf(io, newsize);
+    if (rb->base != old && !alloced) {
+        memcpy(rb->base, old, rb->tail);
+    }
+    return rb->len - rb->tail >= len ? 0 : -1;
+}
+
+static void nio_uring_recv_pbuf(hio_t* io, char* pbuf, int nread) {
+    if (hio_is_loop_readbuf(io) && io->readbuf.head == io->readbuf.tail) {
+        // NOTE: zero copy, lend the provided buffer as readbuf during read_cb.
+        io->readbuf.base = pbuf;
+        io->readbuf.len = HURING_PBUF_SIZE;
+        io->readbuf.head = 0;
+        io->readbuf.tail = nread;
+        if (io->events & HV_READ) {
+            __read_cb(io, pbuf, nread);
+        }
+        if (io->readbuf.base != pbuf) return;
+        // NOTE: provided buffer will be recycled, move remaining data to own readbuf.
+        size_t head = io->readbuf.head;
+        size_t tail = io->readbuf.tail;
+        hio_use_loop_readbuf(io);
+        io->readbuf.head = io->readbuf.tail = 0;
+        if (tail > head ||
+            hio_ext_field(io, unpack_setting) ||
+            (io->read_flags & (HIO_READ_UNTIL_LENGTH | HIO_READ_UNTIL_DELIM))) {
+            hio_alloc_readbuf(io, HURING_PBUF_SIZE);
+            if (!hio_is_alloced_readbuf(io)) return;
+            memcpy(io->readbuf.base, pbuf + head, tail - head);
+            io->readbuf.tail = tail - head;
+        }
+        return;
+    }
+    // readbuf already in use, copy into it
+    if (nio_readbuf_reserve(io, nread) != 0) return;
+    char* buf = io->readbuf.base + io->readbuf.tail;
+    memcpy(buf, pbuf, nread);
+    io->readbuf.tail += nread;
+    if (io->events & HV_READ) {
+        __read_cb(io, buf, nread);
+    }
+}
+
+static void nio_uring_recv(hio_t* io, huring_op_t* op) {
+    int nread = op->res;
+    if (nread < 0) {
+        int err = -nread;
+        if (err == EAGAIN || err == EINTR || err == ECANCELED) return;
+        io->error = err;
+        hio_close(io);
+        return;
+    }
+    if (nread == 0) {
+        // disconnect
+        hio_close(io);
+        return;
+    }
+    char* pbuf = uring_pbuf(io, op);
+    if (pbuf) {
+        nio_uring_recv_pbuf(io, pbuf, nread);
+        uring_pbuf_recycle(io, op);
+        return;
+    }
+    char* buf = io->readbuf.base + io->readbuf.tail;
+    if (op->buf != buf) {
+        // NOTE: readbuf memmoved by hio_handle_read after recv submitted
+        if (op->buf < io->readbuf.base || op->buf + nread > io->readbuf.base + io->readbuf.len) {
+            hloge("fd=%d recv buffer lost!", io->fd);
+            return;
+        }
+        memmove(buf, op->buf, nread);
+    }
+    if (nread < op->len && io->readbuf.tail + nread < io->readbuf.len) {
+        // NOTE: make string friendly
+        buf[nread] = '\0';
+    }
+    io->readbuf.tail += nread;
+    // NOTE: data received after hio_del(io, HV_READ) stays in readbuf, see hio_read_remain.
+    if (io->events & HV_READ) {
+        __read_cb(io, buf, nread);
+    }
+}
+
+static void nio_uring_send(hio_t* io, huring_op_t* op) {
+    int nwrite = op->res;
+    if (nwrite < 0) {
+        int err = -nwrite;
+        if (err == EAGAIN || err == EINTR || err == ECANCELED) return;
+        io->error = err;
+        hio_close(io);
+        return;
+    }
+    hrecursive_mutex_lock(&io->write_mutex);
+    hio_wbuf_t* pbuf = write_queue_front(&io->write_queue);
+    if (pbuf == NULL || pbuf->base + pbuf->offset != op->buf) {
+        hrecursive_mutex_unlock(&io->write_mutex);
+        return;
+    }
+    hio_wbuf_t wbuf = *pbuf;
+    char* buf = op->buf;
+    int len = pbuf->len - pbuf->offset;
+    if (nwrite == 0) {
+        hrecursive_mutex_unlock(&io->write_mutex);
+        hio_close(io);
+        return;
+    }
+    pbuf->offset += nwrite;
+    io->write_bufsize -= nwrite;
+    __write_cb(io, buf, nwrite);
+    if (nwrite == len) {
+        // NOTE: after write_cb, pbuf maybe invalid.
+        write_queue_pop_front(&io->write_queue);
+        hio_free_wbuf(&wbuf);
+    }
+    if (write_queue_empty(&io->write_queue) && !io->closed) {
+        hio_del(io, HV_WRITE);
+        hrecursive_mutex_unlock(&io->write_mutex);
+        if (io->close) {
+            io->close = 0;
+            hio_close(io);
+        }
+        return;
+    }
+    hrecursive_mutex_unlock(&io->write_mutex);
+}
+
+static void nio_uring_handle_events(hio_t* io) {
+    huring_op_t* op = (huring_op_t*)io->uring_rop;
+    if ((io->revents & HV_READ) && op && op->done) {
+        io->uring_rop = NULL;
+        if (op->op == HURING_OP_ACCEPT) {
+            nio_uring_accept(io, op);
+        } else {
+            nio_uring_recv(io, op);
+        }
+        // NOTE: error cqe may also carry a buffer
+        uring_pbuf_recycle(io, op);
+        if (op->flags & IORING_CQE_F_MORE) {
+            // multishot op still in flight
+            op->done = 0;
+            if (io->closed) {
+                op->io = NULL;
+                uring_cancel(io, op);
+            } else {
+                io->uring_rop = op;
+                if (!(io->events & HV_READ)) {
+                    uring_cancel(io, op);
+                }
+            }
+        } else {
+            uring_free_op(op);
+        }
+    }
+
+    op = (huring_op_t*)io->uring_wop;
+    if ((io->revents & HV_WRITE) && op && op->done && !io->closed) {
+        io->uring_wop = NULL;
+        if (op->op == HURING_OP_CONNECT) {
+            nio_uring_connect(io, op);
+        } else {
+            nio_uring_send(io, op);
+        }
+        uring_free_op(op);
+    }
+
+    io->revents = 0;
+    if (!io->closed && io->events) {
+        // submit next accept/recv/send
+        uring_arm_ops(io);
+    }
+}
+#endif
+
+static void hio_handle_events(hio_t* io) {
+    ++io->event_cnt;
+#ifdef EVENT_IO_URING
+    if (hio_is_uring(io)) {
+        nio_uring_handle_events(io);
+        return;
+    }
+#endif
+#ifdef NIO_ZEROCOPY
+    // NOTE: notifications pending in socket error queue wake up any event,
+    // the backend may report it as read or write only, reap on every event.
+    if (io->zerocopy_done != io->zerocopy_seq) {
+        nio_zerocopy_complete(io);
+    }
+#endif
+    if ((io->events & HV_READ) && (io->revents & HV_READ)) {
+        if (io->accept) {
+            nio_accept(io);
         }
         else {
             nio_read(io);
@@ -441,6 +1331,11 @@ static void hio_handle_events(hio_t* io) {
         }
         else {
             nio_write(io);
+#ifdef NIO_SPLICE
+            if (io->splice && !io->closed) {
+                nio_splice_resume(io);
+            }
+#endif
         }
     }
 
@@ -452,7 +1347,22 @@ int hio_accept(hio_t* io) {
     return hio_add(io, hio_handle_events, HV_READ);
 }
 
+static int nio_connect_wait(hio_t* io) {
+    hio_ext_t* ext = hio_ext(io);
+    int timeout = ext->connect_timeout ? ext->connect_timeout : HIO_DEFAULT_CONNECT_TIMEOUT;
+    ext->connect_timer = htimer_add_wheel(io->loop, __connect_timeout_cb, timeout, 1);
+    ext->connect_timer->privdata = io;
+    io->connect = 1;
+    return hio_add(io, hio_handle_events, HV_WRITE);
+}
+
 int hio_connect(hio_t* io) {
+#ifdef EVENT_IO_URING
+    if (hio_is_uring(io)) {
+        // NOTE: connect submitted by iowatcher
+        return nio_connect_wait(io);
+    }
+#endif
     int ret = connect(io->fd, io->peeraddr, SOCKADDR_LEN(io->peeraddr));
 #ifdef OS_WIN
     if (ret < 0 && socket_errno() != WSAEWOULDBLOCK) {
@@ -469,11 +1379,7 @@ int hio_connect(hio_t* io) {
         nio_connect_async(io);
         return 0;
     }
-    int timeout = io->connect_timeout ? io->connect_timeout : HIO_DEFAULT_CONNECT_TIMEOUT;
-    io->connect_timer = htimer_add(io->loop, __connect_timeout_cb, timeout, 1);
-    io->connect_timer->privdata = io;
-    io->connect = 1;
-    return hio_add(io, hio_handle_events, HV_WRITE);
+    return nio_connect_wait(io);
 }
 
 int hio_read (hio_t* io) {
@@ -483,13 +1389,98 @@ int hio_read (hio_t* io) {
     }
     hio_add(io, hio_handle_events, HV_READ);
     if (io->readbuf.tail > io->readbuf.head &&
-        io->unpack_setting == NULL &&
+        hio_ext_field(io, unpack_setting) == NULL &&
         io->read_flags == 0) {
         hio_read_remain(io);
     }
     return 0;
 }
 
+// NOTE: file bytes queued by hio_sendfile are not in memory, so not limited.
+static int hio_write_bufsize_check(hio_t* io, size_t unwritten_len) {
+    if (io->write_bufsize - io->sendfile_bufsize + io->zerocopy_bufsize + unwritten_len <= io->max_write_bufsize) {
+        return 0;
+    }
+#ifdef NIO_ZEROCOPY
+    // NOTE: reap buffers completed but not notified yet before giving up.
+    if (io->zerocopy_done != io->zerocopy_seq) {
+        nio_zerocopy_complete(io);
+        if (io->write_bufsize - io->sendfile_bufsize + io->zerocopy_bufsize + unwritten_len <= io->max_write_bufsize) {
+            return 0;
+        }
+    }
+#endif
+    hloge("write bufsize > %u, close it!", io->max_write_bufsize);
+    io->error = ERR_OVER_LIMIT;
+    return -1;
+}
+
+static int hio_write_queue_push(hio_t* io, hio_wbuf_t* wbuf) {
+    size_t unwritten_len = wbuf->len - wbuf->offset;
+    if (wbuf->sendfile) {
+        if (unwritten_len > UINT32_MAX - io->write_bufsize) {
+            hloge("sendfile bufsize > %u, close it!", (unsigned int)UINT32_MAX);
+            return -1;
+        }
+    } else if (hio_write_bufsize_check(io, unwritten_len) != 0) {
+        return -1;
+    }
+    if (io->write_queue.maxsize == 0) {
+        write_queue_init(&io->write_queue, 4);
+    }
+    write_queue_push_back(&io->write_queue, wbuf);
+    io->write_bufsize += unwritten_len;
+    if (wbuf->sendfile) {
+        io->sendfile_bufsize += unwritten_len;
+    } else if (io->write_bufsize - io->sendfile_bufsize > WRITE_BUFSIZE_HIGH_WATER) {
+        hlogw("write enqueue %u, bufsize=%u over high water %u",
+            (unsigned int)unwritten_len,
+            (unsigned int)io->write_bufsize,
+            (unsigned int)WRITE_BUFSIZE_HIGH_WATER);
+    }
+    if (!io->over_high_water) {
+        hio_write_water_cb(io);
+    }
+    return 0;
+}
+
+// copy unwritten data of bufs (from offset) into write_queue
+static int hio_write_enqueue(hio_t* io, const hbuf_t* bufs, int nbufs, size_t offset, struct sockaddr* addr) {
+    size_t len = 0;
+    for (int i = 0; i < nbufs; ++i) {
+        len += bufs[i].len;
+    }
+    size_t unwritten_len = len - offset;
+    if (hio_write_bufsize_check(io, unwritten_len) != 0) {
+        return -1;
+    }
+    size_t addrlen = 0;
+    if ((io->io_type & (HIO_TYPE_SOCK_DGRAM | HIO_TYPE_SOCK_RAW)) && addr) {
+        addrlen = SOCKADDR_LEN(addr);
+    }
+    hio_wbuf_t remain;
+    memset(&remain, 0, sizeof(remain));
+    remain.offset = addrlen;
+    remain.len = addrlen + unwritten_len;
+    // NOTE: free in nio_write
+    HV_ALLOC(remain.base, remain.len);
+    if (addr && addrlen > 0) {
+        memcpy(remain.base, addr, addrlen);
+    }
+    char* dst = remain.base + remain.offset;
+    for (int i = 0; i < nbufs; ++i) {
+        if (offset >= bufs[i].len) {
+            offset -= bufs[i].len;
+            continue;
+        }
+        memcpy(dst, bufs[i].base + offset, bufs[i].len - offset);
+        dst += bufs[i].len - offset;
+        offset = 0;
+    }
+    // NOTE: addr prefix is skipped by offset, not counted in write_bufsize.
+    return hio_write_queue_push(io, &remain);
+}
+
 static int hio_write4 (hio_t* io, const void* buf, size_t len, struct sockaddr* addr) {
     if (io->closed) {
         hloge("hio_write called but fd[%d] already closed!", io->fd);
@@ -530,37 +1521,12 @@ enqueue:
         hio_add(io, hio_handle_events, HV_WRITE);
     }
     if (nwrite < len) {
-        size_t unwritten_len = len - nwrite;
-        if (io->write_bufsize + unwritten_len > io->max_write_bufsize) {
-            hloge("write bufsize > %u, close it!", io->max_write_bufsize);
-            io->error = ERR_OVER_LIMIT;
+        hbuf_t hbuf;
+        hbuf.base = (char*)buf;
+        hbuf.len = len;
+        if (hio_write_enqueue(io, &hbuf, 1, nwrite, addr) != 0) {
             goto write_error;
         }
-        size_t addrlen = 0;
-        if ((io->io_type & (HIO_TYPE_SOCK_DGRAM | HIO_TYPE_SOCK_RAW)) && addr) {
-            addrlen = SOCKADDR_LEN(addr);
-        }
-        offset_buf_t remain;
-        remain.offset = addrlen;
-        remain.len = addrlen + unwritten_len;
-        // NOTE: free in nio_write
-        HV_ALLOC(remain.base, remain.len);
-        if (addr && addrlen > 0) {
-            memcpy(remain.base, addr, addrlen);
-        }
-        memcpy(remain.base + remain.offset, ((char*)buf) + nwrite, unwritten_len);
-        if (io->write_queue.maxsize == 0) {
-            write_queue_init(&io->write_queue, 4);
-        }
-        write_queue_push_back(&io->write_queue, &remain);
-        io->write_bufsize += unwritten_len;
-        if (io->write_bufsize > WRITE_BUFSIZE_HIGH_WATER) {
-            hlogw("write len=%u enqueue %u, bufsize=%u over high water %u",
-                (unsigned int)len,
-                (unsigned int)unwritten_len,
-                (unsigned int)io->write_bufsize,
-                (unsigned int)WRITE_BUFSIZE_HIGH_WATER);
-        }
     }
 write_done:
     hrecursive_mutex_unlock(&io->write_mutex);
@@ -590,6 +1556,374 @@ int hio_sendto (hio_t* io, const void* buf, size_t len, struct sockaddr* addr) {
     return hio_write4(io, buf, len, addr ? addr : io->peeraddr);
 }
 
+int hio_writev(hio_t* io, const hbuf_t* bufs, int nbufs) {
+    if (nbufs <= 0) return 0;
+    if (nbufs == 1) {
+        return hio_write(io, bufs[0].base, bufs[0].len);
+    }
+    if (io->closed) {
+        hloge("hio_writev called but fd[%d] already closed!", io->fd);
+        return -1;
+    }
+    size_t len = 0;
+    for (int i = 0; i < nbufs; ++i) {
+        len += bufs[i].len;
+    }
+    if (!nio_is_writev(io) || nbufs > NIO_IOV_MAX) {
+        // NOTE: merge into one buffer, keep boundary for datagram and ssl record.
+        char* buf = NULL;
+        HV_ALLOC(buf, len);
+        char* dst = buf;
+        for (int i = 0; i < nbufs; ++i) {
+            memcpy(dst, bufs[i].base, bufs[i].len);
+            dst += bufs[i].len;
+        }
+        int nwrite = hio_write(io, buf, len);
+        HV_FREE(buf);
+        return nwrite;
+    }
+    int nwrite = 0, err = 0;
+    hrecursive_mutex_lock(&io->write_mutex);
+    if (write_queue_empty(&io->write_queue)) {
+        nio_iovec_t iov[NIO_IOV_MAX];
+        for (int i = 0; i < nbufs; ++i) {
+            NIO_IOV_SET(iov[i], bufs[i].base, bufs[i].len);
+        }
+        nwrite = __nio_writev(io, iov, nbufs);
+        // printd("writev retval=%d\n", nwrite);
+        if (nwrite < 0) {
+            err = socket_errno();
+            if (err == EAGAIN || err == EINTR) {
+                nwrite = 0;
+                hlogw("try_writev failed, enqueue!");
+                goto enqueue;
+            } else {
+                io->error = err;
+                goto write_error;
+            }
+        }
+        if (nwrite == len) {
+            goto write_done;
+        }
+        if (nwrite == 0) {
+            goto disconnect;
+        }
+enqueue:
+        hio_add(io, hio_handle_events, HV_WRITE);
+    }
+    if (nwrite < len) {
+        if (hio_write_enqueue(io, bufs, nbufs, nwrite, NULL) != 0) {
+            goto write_error;
+        }
+    }
+write_done:
+    hrecursive_mutex_unlock(&io->write_mutex);
+    for (int i = 0, remain = nwrite; i < nbufs && remain > 0; ++i) {
+        int n = MIN(remain, (int)bufs[i].len);
+        __write_cb(io, bufs[i].base, n);
+        remain -= n;
+    }
+    return nwrite;
+write_error:
+disconnect:
+    hrecursive_mutex_unlock(&io->write_mutex);
+    hio_close_async(io);
+    return nwrite < 0 ? nwrite : -1;
+}
+
+#ifdef NIO_SENDFILE
+bool hio_sendfile_supported(hio_t* io) {
+    // NOTE: ssl must encrypt in userspace, unless kernel TLS engaged
+    if (!nio_is_writev(io)) return false;
+#ifdef EVENT_IO_URING
+    if (hio_is_uring(io)) return false;
+#endif
+    return true;
+}
+
+int hio_sendfile(hio_t* io, int fd, uint64_t offset, size_t len) {
+    if (io->closed) {
+        hloge("hio_sendfile called but fd[%d] already closed!", io->fd);
+        return -1;
+    }
+    if (!hio_sendfile_supported(io) || len > INT_MAX) return -1;
+    if (len == 0) return 0;
+    hio_wbuf_t wbuf;
+    memset(&wbuf, 0, sizeof(wbuf));
+    wbuf.sendfile = 1;
+    wbuf.offset = offset;
+    wbuf.len = offset + len;
+    ssize_t nwrite = 0;
+    int err = 0;
+    hrecursive_mutex_lock(&io->write_mutex);
+    if (write_queue_empty(&io->write_queue)) {
+        off_t off = offset;
+        nwrite = sendfile(io->fd, fd, &off, len);
+        if (nwrite < 0) {
+            err = socket_errno();
+            if (err == EAGAIN || err == EINTR) {
+                nwrite = 0;
+                goto enqueue;
+            }
+            io->error = err;
+            goto write_error;
+        }
+        if (nwrite == len) {
+            hrecursive_mutex_unlock(&io->write_mutex);
+            __write_cb(io, NULL, nwrite);
+            return nwrite;
+        }
+        if (nwrite == 0) {
+            // file shorter than offset + len
+            io->error = ERR_READ_FILE;
+            goto write_error;
+        }
+enqueue:
+        hio_add(io, hio_handle_events, HV_WRITE);
+    }
+    wbuf.offset += nwrite;
+    // NOTE: close in hio_free_wbuf
+    wbuf.fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (wbuf.fd < 0) {
+        io->error = errno;
+        goto write_error;
+    }
+    if (hio_write_queue_push(io, &wbuf) != 0) {
+        close(wbuf.fd);
+        goto write_error;
+    }
+    if (nwrite > 0) {
+        __write_cb(io, NULL, nwrite);
+    }
+    hrecursive_mutex_unlock(&io->write_mutex);
+    return nwrite;
+write_error:
+    hrecursive_mutex_unlock(&io->write_mutex);
+    hio_close_async(io);
+    return -1;
+}
+#else
+bool hio_sendfile_supported(hio_t* io) {
+    return false;
+}
+
+int hio_sendfile(hio_t* io, int fd, uint64_t offset, size_t len) {
+    return -1;
+}
+#endif
+
+int hio_write_owned(hio_t* io, void* buf, size_t len, hfree_cb free_cb, void* userdata) {
+    hio_wbuf_t wbuf;
+    memset(&wbuf, 0, sizeof(wbuf));
+    wbuf.base = (char*)buf;
+    wbuf.len = len;
+    wbuf.free_cb = free_cb;
+    wbuf.userdata = userdata;
+    if (io->closed) {
+        hloge("hio_write called but fd[%d] already closed!", io->fd);
+        hio_free_wbuf(&wbuf);
+        return -1;
+    }
+    if (!(io->io_type & HIO_TYPE_SOCK_STREAM)) {
+        // NOTE: datagram need peeraddr prefix in write_queue, just copy.
+        int nwrite = hio_write(io, buf, len);
+        hio_free_wbuf(&wbuf);
+        return nwrite;
+    }
+    int nwrite = 0, err = 0;
+    hrecursive_mutex_lock(&io->write_mutex);
+    if (write_queue_empty(&io->write_queue)) {
+#ifdef NIO_ZEROCOPY
+        if (nio_is_writev(io) && nio_is_zerocopy(io, len)) {
+            int zerocopy = 0;
+            nio_iovec_t iov;
+            NIO_IOV_SET(iov, buf, len);
+            nwrite = nio_send_zerocopy(io, &iov, 1, &zerocopy);
+            if (zerocopy) {
+                wbuf.zerocopy = 1;
+                wbuf.zerocopy_seq = io->zerocopy_seq++;
+            }
+        } else
+#endif
+        nwrite = __nio_write(io, buf, len, NULL);
+        // printd("write retval=%d\n", nwrite);
+        if (nwrite < 0) {
+            err = socket_errno();
+            if (err == EAGAIN || err == EINTR) {
+                nwrite = 0;
+                hlogw("try_write failed, enqueue!");
+                goto enqueue;
+            } else {
+                io->error = err;
+                goto write_error;
+            }
+        }
+        if (nwrite == len) {
+            __write_cb(io, buf, nwrite);
+            nio_release_wbuf(io, &wbuf);
+            hrecursive_mutex_unlock(&io->write_mutex);
+            return nwrite;
+        }
+        if (nwrite == 0) {
+            goto disconnect;
+        }
+enqueue:
+        hio_add(io, hio_handle_events, HV_WRITE);
+    }
+    wbuf.offset = nwrite;
+    if (hio_write_queue_push(io, &wbuf) != 0) {
+        goto write_error;
+    }
+    // NOTE: buf is owned by write_queue now, write_cb before unlock.
+    if (nwrite > 0) {
+        __write_cb(io, buf, nwrite);
+    }
+    hrecursive_mutex_unlock(&io->write_mutex);
+    return nwrite;
+write_error:
+disconnect:
+    hrecursive_mutex_unlock(&io->write_mutex);
+    hio_free_wbuf(&wbuf);
+    hio_close_async(io);
+    return nwrite < 0 ? nwrite : -1;
+}
+
+int hio_set_batch(hio_t* io, int batch, int offload) {
+#ifdef NIO_MMSG
+    if (io->io_type != HIO_TYPE_UDP && io->io_type != HIO_TYPE_KCP) return -1;
+    // NOTE: unpack works on readbuf
+    if (hio_ext_field(io, unpack_setting)) return -1;
+    if (batch <= 0) {
+        io->read_batch = 0;
+        return 0;
+    }
+    io->read_batch = MIN(batch, HIO_MAX_BATCH);
+    int on = (offload & HIO_UDP_GRO) ? 1 : 0;
+#ifdef UDP_GRO
+    if (on != io->udp_gro) {
+        if (setsockopt(io->fd, SOL_UDP, UDP_GRO, &on, sizeof(int)) == 0) {
+            io->udp_gro = on;
+        } else {
+            hlogw("setsockopt UDP_GRO fd=%d error=%d", io->fd, socket_errno());
+        }
+    }
+#endif
+#ifdef UDP_SEGMENT
+    io->udp_gso = (offload & HIO_UDP_GSO) ? 1 : 0;
+#endif
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int hio_sendto_batch(hio_t* io, const hio_dgram_t* dgrams, int cnt) {
+    if (io->closed) {
+        hloge("hio_sendto_batch called but fd[%d] already closed!", io->fd);
+        return -1;
+    }
+#ifdef NIO_MMSG
+    if (io->io_type != HIO_TYPE_UDP)
+#endif
+    {
+        int nsent = 0;
+        for (int i = 0; i < cnt; ++i) {
+            if (hio_sendto(io, dgrams[i].buf, dgrams[i].len, dgrams[i].addr) < 0) {
+                return nsent ? nsent : -1;
+            }
+            ++nsent;
+        }
+        return nsent;
+    }
+#ifdef NIO_MMSG
+    struct mmsghdr msgs[HIO_MAX_BATCH];
+    struct iovec iovs[HIO_MAX_BATCH];
+    int ndgrams[HIO_MAX_BATCH];
+#ifdef UDP_SEGMENT
+    char control[HIO_MAX_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+#endif
+    int nsent = 0, err = 0;
+    hrecursive_mutex_lock(&io->write_mutex);
+    if (!write_queue_empty(&io->write_queue)) goto enqueue;
+    while (nsent < cnt) {
+        int nmsgs = 0, niovs = 0, i = nsent;
+        memset(msgs, 0, sizeof(msgs));
+        while (i < cnt && nmsgs < HIO_MAX_BATCH && niovs < HIO_MAX_BATCH) {
+            struct sockaddr* addr = nio_dgram_addr(io, &dgrams[i]);
+            struct msghdr* msg = &msgs[nmsgs].msg_hdr;
+            msg->msg_name = addr;
+            msg->msg_namelen = SOCKADDR_LEN(addr);
+            msg->msg_iov = &iovs[niovs];
+            int segsize = dgrams[i].len;
+            int total = 0, n = 0;
+            // UDP_SEGMENT: same peer and size, the last one may be shorter.
+            do {
+                NIO_IOV_SET(iovs[niovs], dgrams[i].buf, dgrams[i].len);
+                total += dgrams[i].len;
+                ++niovs; ++n; ++i;
+                if (!io->udp_gso || segsize == 0 || dgrams[i-1].len < segsize) break;
+            } while (i < cnt && niovs < HIO_MAX_BATCH && n < NIO_GSO_MAXSEGS &&
+                     dgrams[i].len <= segsize && total + dgrams[i].len <= NIO_GSO_MAXSIZE &&
+                     nio_sockaddr_equal(nio_dgram_addr(io, &dgrams[i]), addr));
+            msg->msg_iovlen = n;
+#ifdef UDP_SEGMENT
+            if (n > 1) {
+                struct cmsghdr* cm;
+                msg->msg_control = control[nmsgs];
+                msg->msg_controllen = sizeof(control[nmsgs]);
+                cm = CMSG_FIRSTHDR(msg);
+                cm->cmsg_level = SOL_UDP;
+                cm->cmsg_type = UDP_SEGMENT;
+                cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                *(uint16_t*)CMSG_DATA(cm) = segsize;
+            }
+#endif
+            ndgrams[nmsgs++] = n;
+        }
+        int nmsgs_sent = sendmmsg(io->fd, msgs, nmsgs, 0);
+        // printd("sendmmsg retval=%d\n", nmsgs_sent);
+        if (nmsgs_sent < 0) {
+            err = socket_errno();
+            if (err == EAGAIN || err == EINTR) break;
+            if (io->udp_gso && (err == EIO || err == EINVAL)) {
+                // NOTE: no UDP_SEGMENT support by kernel or device
+                hlogw("sendmmsg UDP_SEGMENT fd=%d error=%d, disable gso.", io->fd, err);
+                io->udp_gso = 0;
+                continue;
+            }
+            io->error = err;
+            hrecursive_mutex_unlock(&io->write_mutex);
+            return -1;
+        }
+        for (int m = 0; m < nmsgs_sent; ++m) {
+            nsent += ndgrams[m];
+        }
+        if (nmsgs_sent < nmsgs) break;
+    }
+    if (nsent > 0 && ((sockaddr_u*)io->localaddr)->sin.sin_port == 0) {
+        socklen_t addrlen = sizeof(sockaddr_u);
+        getsockname(io->fd, io->localaddr, &addrlen);
+    }
+enqueue:
+    if (nsent < cnt) {
+        for (int i = nsent; i < cnt; ++i) {
+            hbuf_t hbuf;
+            hbuf.base = (char*)dgrams[i].buf;
+            hbuf.len = dgrams[i].len;
+            if (hio_write_enqueue(io, &hbuf, 1, 0, nio_dgram_addr(io, &dgrams[i])) != 0) {
+                break;
+            }
+        }
+        hio_add(io, hio_handle_events, HV_WRITE);
+    }
+    hrecursive_mutex_unlock(&io->write_mutex);
+    for (int i = 0; i < nsent; ++i) {
+        __write_cb(io, dgrams[i].buf, dgrams[i].len);
+    }
+    return nsent;
+#endif
+}
+
 int hio_close (hio_t* io) {
     if (io->closed) return 0;
     if (io->destroy == 0 && hv_gettid() != io->loop->tid) {
@@ -605,9 +1939,10 @@ int hio_close (hio_t* io) {
         io->close = 1;
         hrecursive_mutex_unlock(&io->write_mutex);
         hlogw("write_queue not empty, close later.");
-        int timeout_ms = io->close_timeout ? io->close_timeout : HIO_DEFAULT_CLOSE_TIMEOUT;
-        io->close_timer = htimer_add(io->loop, __close_timeout_cb, timeout_ms, 1);
-        io->close_timer->privdata = io;
+        hio_ext_t* ext = hio_ext(io);
+        int timeout_ms = ext->close_timeout ? ext->close_timeout : HIO_DEFAULT_CLOSE_TIMEOUT;
+        ext->close_timer = htimer_add_wheel(io->loop, __close_timeout_cb, timeout_ms, 1);
+        ext->close_timer->privdata = io;
         return 0;
     }
     io->closed = 1;
@@ -615,15 +1950,19 @@ int hio_close (hio_t* io) {
 
     hio_done(io);
     __close_cb(io);
-    if (io->ssl) {
-        hssl_free(io->ssl);
-        io->ssl = NULL;
+#ifdef NIO_SPLICE
+    nio_splice_cleanup(io);
+#endif
+    hio_ext_t* ext = io->ext;
+    if (ext && ext->ssl) {
+        hssl_free(ext->ssl);
+        ext->ssl = NULL;
     }
-    if (io->ssl_ctx && io->alloced_ssl_ctx) {
-        hssl_ctx_free(io->ssl_ctx);
-        io->ssl_ctx = NULL;
+    if (ext && ext->ssl_ctx && io->alloced_ssl_ctx) {
+        hssl_ctx_free(ext->ssl_ctx);
+        ext->ssl_ctx = NULL;
     }
-    SAFE_FREE(io->hostname);
+    if (ext) SAFE_FREE(ext->hostname);
     if (io->io_type & HIO_TYPE_SOCKET) {
         closesocket(io->fd);
     } else if (io->io_type == HIO_TYPE_PIPE) {
@@ -387,6 +387,18 @@ int hio_sendto (hio_t* io, const void* buf, size_t len, struct sockaddr* addr) {
     return hio_write4(io, buf, len, addr ? addr : io->peeraddr);
 }
 
+bool hio_sendfile_supported(hio_t* io) {
+    return false;
+}
+
+int hio_sendfile (hio_t* io, int fd, uint64_t offset, size_t len) {
+    return -1;
+}
+
+int hio_set_splice_upstream(hio_t* io, int on) {
+    return on ? -1 : 0;
+}
+
 int hio_close (hio_t* io) {
     if (io->closed) return 0;
     io->closed = 1;
@@ -137,21 +137,21 @@ void rudp_del(rudp_t* rudp, struct sockaddr* addr) {
 }
 
 rudp_entry_t* hio_get_rudp(hio_t* io, struct sockaddr* addr) {
-    rudp_entry_t* rudp = rudp_get(&io->rudp, addr ? addr : io->peeraddr);
+    rudp_entry_t* rudp = rudp_get(&io->ext->rudp, addr ? addr : io->peeraddr);
     rudp->io = io;
     return rudp;
 }
 
 static void hio_close_rudp_event_cb(hevent_t* ev) {
     rudp_entry_t* entry = (rudp_entry_t*)ev->userdata;
-    rudp_del(&entry->io->rudp, (struct sockaddr*)&entry->addr);
+    rudp_del(&entry->io->ext->rudp, (struct sockaddr*)&entry->addr);
     // rudp_entry_free(entry);
 }
 
 int hio_close_rudp(hio_t* io, struct sockaddr* peeraddr) {
     if (peeraddr == NULL) peeraddr = io->peeraddr;
     // NOTE: do rudp_del for thread-safe
-    rudp_entry_t* entry = rudp_get(&io->rudp, peeraddr);
+    rudp_entry_t* entry = rudp_get(&io->ext->rudp, peeraddr);
     // NOTE: just rudp_remove first, do rudp_entry_free async for safe.
     // rudp_entry_t* entry = rudp_remove(&io->rudp, peeraddr);
     if (entry) {
@@ -4,8 +4,102 @@
 #include "hlog.h"
 #include "hmath.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define UNPACK_SIMD_BYTES   32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UNPACK_SIMD_BYTES   16
+#endif
+
+#if defined(UNPACK_SIMD_BYTES) && defined(_MSC_VER)
+#include <intrin.h>
+static inline int ctz32(unsigned int x) {
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (int)i;
+}
+#elif defined(UNPACK_SIMD_BYTES)
+#define ctz32(x)    __builtin_ctz(x)
+#endif
+
+/*
+ * @return the first delimiter in [p, ep), NULL if not found.
+ * SIMD: compare the first and last byte of delimiter at once, 16/32 positions per step,
+ * then verify the middle bytes of candidates. memchr is used for the tail.
+ */
+const unsigned char* unpack_find_delimiter(const unsigned char* p, const unsigned char* ep,
+                                          const unsigned char* delimiter, int delimiter_bytes) {
+    int last = delimiter_bytes - 1;
+#ifdef UNPACK_SIMD_BYTES
+#if UNPACK_SIMD_BYTES == 32
+    const __m256i first_byte = _mm256_set1_epi8((char)delimiter[0]);
+    const __m256i last_byte  = _mm256_set1_epi8((char)delimiter[last]);
+#else
+    const __m128i first_byte = _mm_set1_epi8((char)delimiter[0]);
+    const __m128i last_byte  = _mm_set1_epi8((char)delimiter[last]);
+#endif
+    while (ep - p >= UNPACK_SIMD_BYTES + last) {
+#if UNPACK_SIMD_BYTES == 32
+        __m256i first_block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i last_block  = _mm256_loadu_si256((const __m256i*)(p + last));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first_block, first_byte),
+            _mm256_cmpeq_epi8(last_block, last_byte)));
+#else
+        __m128i first_block = _mm_loadu_si128((const __m128i*)p);
+        __m128i last_block  = _mm_loadu_si128((const __m128i*)(p + last));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first_block, first_byte),
+            _mm_cmpeq_epi8(last_block, last_byte)));
+#endif
+        while (mask) {
+            const unsigned char* candidate = p + ctz32(mask);
+            if (last <= 1 || memcmp(candidate + 1, delimiter + 1, last - 1) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+        p += UNPACK_SIMD_BYTES;
+    }
+#endif
+    while (ep - p > last) {
+        p = (const unsigned char*)memchr(p, delimiter[0], ep - p - last);
+        if (p == NULL) return NULL;
+        if (memcmp(p + 1, delimiter + 1, last) == 0) return p;
+        ++p;
+    }
+    return NULL;
+}
+
+// collect packages for read_batch_cb, @see hio_setcb_read_batch
+typedef struct unpack_batch_s {
+    hio_dgram_t pkgs[HIO_MAX_BATCH];
+    int         cnt;
+} unpack_batch_t;
+
+static void unpack_batch_flush(hio_t* io, unpack_batch_t* batch) {
+    if (batch->cnt == 0) return;
+    hio_read_batch_cb(io, batch->pkgs, batch->cnt);
+    batch->cnt = 0;
+}
+
+static void unpack_deliver(hio_t* io, unpack_batch_t* batch, const unsigned char* buf, int len) {
+    if (io->read_batch_cb == NULL) {
+        hio_read_cb(io, (void*)buf, len);
+        return;
+    }
+    hio_dgram_t* pkg = &batch->pkgs[batch->cnt];
+    pkg->buf = (void*)buf;
+    pkg->len = len;
+    pkg->addr = NULL;
+    if (++batch->cnt == HIO_MAX_BATCH) {
+        unpack_batch_flush(io, batch);
+    }
+}
+
 int hio_unpack(hio_t* io, void* buf, int readbytes) {
-    unpack_setting_t* setting = io->unpack_setting;
+    unpack_setting_t* setting = io->ext->unpack_setting;
     switch(setting->mode) {
     case UNPACK_BY_FIXED_LENGTH:
         return hio_unpack_by_fixed_length(io, buf, readbytes);
@@ -22,7 +116,7 @@ int hio_unpack(hio_t* io, void* buf, int readbytes) {
 int hio_unpack_by_fixed_length(hio_t* io, void* buf, int readbytes) {
     const unsigned char* sp = (const unsigned char*)io->readbuf.base + io->readbuf.head;
     const unsigned char* ep = (const unsigned char*)buf + readbytes;
-    unpack_setting_t* setting = io->unpack_setting;
+    unpack_setting_t* setting = io->ext->unpack_setting;
 
     int fixed_length = setting->fixed_length;
     assert(io->readbuf.len >= fixed_length);
@@ -30,21 +124,17 @@ int hio_unpack_by_fixed_length(hio_t* io, void* buf, int readbytes) {
     const unsigned char* p = sp;
     int remain = ep - p;
     int handled = 0;
+    unpack_batch_t batch;
+    batch.cnt = 0;
     while (remain >= fixed_length) {
-        hio_read_cb(io, (void*)p, fixed_length);
+        unpack_deliver(io, &batch, p, fixed_length);
         handled += fixed_length;
         p += fixed_length;
         remain -= fixed_length;
     }
+    unpack_batch_flush(io, &batch);
 
-    io->readbuf.head = 0;
-    io->readbuf.tail = remain;
-    if (remain) {
-        // [p, p+remain] => [base, base+remain]
-        if (p != (unsigned char*)io->readbuf.base) {
-            memmove(io->readbuf.base, p, remain);
-        }
-    }
+    hio_keep_readbuf(io, p, remain);
 
     return handled;
 }
@@ -52,46 +142,29 @@ int hio_unpack_by_fixed_length(hio_t* io, void* buf, int readbytes) {
 int hio_unpack_by_delimiter(hio_t* io, void* buf, int readbytes) {
     const unsigned char* sp = (const unsigned char*)io->readbuf.base + io->readbuf.head;
     const unsigned char* ep = (const unsigned char*)buf + readbytes;
-    unpack_setting_t* setting = io->unpack_setting;
+    unpack_setting_t* setting = io->ext->unpack_setting;
 
     unsigned char* delimiter = setting->delimiter;
     int delimiter_bytes = setting->delimiter_bytes;
 
     const unsigned char* p = (const unsigned char*)buf - delimiter_bytes + 1;
     if (p < sp) p = sp;
-    int remain = ep - p;
+    int remain = 0;
     int handled = 0;
-    int i = 0;
-    while (remain >= delimiter_bytes) {
-        char match = 1;
-        for (i = 0; i < delimiter_bytes; ++i) {
-            if (p[i] != delimiter[i]) {
-                match = 0;
-                break;
-            }
-        }
-        if(match){
-            p += delimiter_bytes;
-            remain -= delimiter_bytes;
-            hio_read_cb(io, (void*)sp, p - sp);
-            handled += p - sp;
-            sp = p;
-        }
-        else{
-            ++p;
-            --remain;
-        }
+    unpack_batch_t batch;
+    batch.cnt = 0;
+    while ((p = unpack_find_delimiter(p, ep, delimiter, delimiter_bytes)) != NULL) {
+        p += delimiter_bytes;
+        unpack_deliver(io, &batch, sp, p - sp);
+        handled += p - sp;
+        sp = p;
     }
+    unpack_batch_flush(io, &batch);
 
     remain = ep - sp;
-    io->readbuf.head = 0;
-    io->readbuf.tail = remain;
+    hio_keep_readbuf(io, sp, remain);
     if (remain) {
-        // [sp, sp+remain] => [base, base+remain]
-        if (sp != (unsigned char*)io->readbuf.base) {
-            memmove(io->readbuf.base, sp, remain);
-        }
-        if (io->readbuf.tail == io->readbuf.len) {
+        if (remain == io->readbuf.len) {
             if (io->readbuf.len >= setting->package_max_length) {
                 hloge("recv package over %d bytes!", (int)setting->package_max_length);
                 io->error = ERR_OVER_LIMIT;
@@ -109,7 +182,7 @@ int hio_unpack_by_delimiter(hio_t* io, void* buf, int readbytes) {
 int hio_unpack_by_length_field(hio_t* io, void* buf, int readbytes) {
     const unsigned char* sp = (const unsigned char*)io->readbuf.base + io->readbuf.head;
     const unsigned char* ep = (const unsigned char*)buf + readbytes;
-    unpack_setting_t* setting = io->unpack_setting;
+    unpack_setting_t* setting = io->ext->unpack_setting;
 
     const unsigned char* p = sp;
     int remain = ep - p;
@@ -118,6 +191,8 @@ int hio_unpack_by_length_field(hio_t* io, void* buf, int readbytes) {
     unsigned int body_len = 0;
     unsigned int package_len = head_len;
     const unsigned char* lp = NULL;
+    unpack_batch_t batch;
+    batch.cnt = 0;
     while (remain >= setting->body_offset) {
         body_len = 0;
         lp = p + setting->length_field_offset;
@@ -138,6 +213,7 @@ int hio_unpack_by_length_field(hio_t* io, void* buf, int readbytes) {
             if (varint_bytes == -1) {
                 hloge("varint is too big!");
                 io->error = ERR_OVER_LIMIT;
+                unpack_batch_flush(io, &batch);
                 hio_close(io);
                 return -1;
             }
@@ -150,6 +226,7 @@ int hio_unpack_by_length_field(hio_t* io, void* buf, int readbytes) {
             if (varint_bytes == -1) {
                 hloge("varint is too big!");
                 io->error = ERR_OVER_LIMIT;
+                unpack_batch_flush(io, &batch);
                 hio_close(io);
                 return -1;
             }
@@ -157,12 +234,13 @@ int hio_unpack_by_length_field(hio_t* io, void* buf, int readbytes) {
         } else {
             hloge("Unknown length_field_coding!");
             io->error = ERR_INVALID_PARAM;
+            unpack_batch_flush(io, &batch);
             hio_close(io);
             return -1;
         }
         package_len = head_len + body_len + setting->length_adjustment;
         if (remain >= package_len) {
-            hio_read_cb(io, (void*)p, package_len);
+            unpack_deliver(io, &batch, p, package_len);
             handled += package_len;
             p += package_len;
             remain -= package_len;
@@ -171,13 +249,10 @@ int hio_unpack_by_length_field(hio_t* io, void* buf, int readbytes) {
         }
     }
 
-    io->readbuf.head = 0;
-    io->readbuf.tail = remain;
+    unpack_batch_flush(io, &batch);
+
+    hio_keep_readbuf(io, p, remain);
     if (remain) {
-        // [p, p+remain] => [base, base+remain]
-        if (p != (unsigned char*)io->readbuf.base) {
-            memmove(io->readbuf.base, p, remain);
-        }
         if (package_len > io->readbuf.len) {
             if (package_len > setting->package_max_length) {
                 hloge("package length over %d bytes!", (int)setting->package_max_length);
@@ -8,4 +8,8 @@ int hio_unpack_by_fixed_length(hio_t* io, void* buf, int readbytes);
 int hio_unpack_by_delimiter(hio_t* io, void* buf, int readbytes);
 int hio_unpack_by_length_field(hio_t* io, void* buf, int readbytes);
 
+// @return the first delimiter in [p, ep), NULL if not found.
+HV_EXPORT const unsigned char* unpack_find_delimiter(const unsigned char* p, const unsigned char* ep,
+                                                     const unsigned char* delimiter, int delimiter_bytes);
+
 #endif // HV_UNPACK_H_
@@ -0,0 +1,61 @@
+#ifndef HV_URINGIO_H_
+#define HV_URINGIO_H_
+
+#include "iowatcher.h"
+
+#ifdef EVENT_IO_URING
+
+#include <liburing.h>
+
+#include "hsocket.h"
+#include "list.h"
+
+typedef enum {
+    HURING_OP_ACCEPT    = 1,
+    HURING_OP_CONNECT   = 2,
+    HURING_OP_RECV      = 3,
+    HURING_OP_SEND      = 4,
+} huring_op_e;
+
+// provided buffer ring, see IORING_REGISTER_PBUF_RING
+#define HURING_PBUF_COUNT   256     // must be power of 2
+#define HURING_PBUF_SIZE    HLOOP_READ_BUFSIZE
+
+// NOTE: one op per submission, io->uring_rop for accept/recv, io->uring_wop for connect/send.
+// multishot op stays in flight until cqe without IORING_CQE_F_MORE.
+typedef struct huring_op_s {
+    struct list_node node;      // for io_uring_ctx_t.ops
+    huring_op_e op;
+    int         res;            // cqe->res
+    unsigned    flags;          // cqe->flags
+    unsigned    done        :1; // completed, waiting for hio_handle_events
+    unsigned    multishot   :1; // IORING_ACCEPT_MULTISHOT, IORING_RECV_MULTISHOT
+    unsigned    bufsel      :1; // IOSQE_BUFFER_SELECT
+    hio_t*      io;             // NULL if orphaned by hio_close
+    char*       buf;            // recv/send buffer
+    size_t      len;
+    void*       orphan;         // buffer owned by op after hio_close, free when cqe returned
+    hfree_cb    orphan_free_cb; // @see hio_write_owned
+    void*       orphan_userdata;
+    // for accept
+    sockaddr_u  addr;
+    socklen_t   addrlen;
+} huring_op_t;
+
+// NOTE: Only plain tcp use completion ops, others still use poll readiness.
+#define hio_is_uring(io)    ((io)->io_type == HIO_TYPE_TCP)
+
+// NOTE: Submissions are deferred to next iowatcher_poll_events,
+// so readbuf and write_queue are stable when the kernel owns them.
+void uring_arm_ops(hio_t* io);
+// hio_done: orphan ops in flight, buffers are freed when cqe returned.
+void uring_done_ops(hio_t* io);
+void uring_free_op(huring_op_t* op);
+void uring_cancel(hio_t* io, huring_op_t* op);
+// provided buffer of cqe, must be recycled after used.
+char* uring_pbuf(hio_t* io, huring_op_t* op);
+void  uring_pbuf_recycle(hio_t* io, huring_op_t* op);
+
+#endif
+
+#endif // HV_URINGIO_H_
@@ -0,0 +1,291 @@
+#include "hloop.h"
+#include "hevent.h"
+
+#include "hdef.h"
+#include "hbase.h"
+#include "hlog.h"
+#include "htime.h"
+#include "hthread.h"
+#include "hmutex.h"
+#include "hatomic.h"
+
+#if defined(OS_LINUX) && defined(__GLIBC__)
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#define HAVE_WATCHDOG_BACKTRACE 1
+// NOTE: SIGURG is ignored by default and rarely used, same as go runtime preemption.
+#ifndef HLOOP_WATCHDOG_SIGNAL
+#define HLOOP_WATCHDOG_SIGNAL   SIGURG
+#endif
+#define WATCHDOG_BACKTRACE_DEPTH        32
+#define WATCHDOG_BACKTRACE_TIMEOUT      100 // ms
+#endif
+
+#define WATCHDOG_MAX_LOOPS      1024
+
+typedef struct watchdog_entry_s {
+    hloop_t*        loop;
+    // last heartbeat
+    long            cb_seq;
+    uint64_t        loop_cnt;
+    uint64_t        since_us;
+    // current stall
+    int             stalled;
+    hloop_stall_t   stall;
+} watchdog_entry_t;
+
+// copied from loop, so backtrace can be captured without holding mutex.
+typedef struct watchdog_target_s {
+    long    pid;
+    long    tid;
+} watchdog_target_t;
+
+typedef struct watchdog_s {
+    hmutex_t            mutex;
+    hthread_t           thread;
+    volatile int        running;
+    int                 threshold_ms;
+    int                 flags;
+    int                 nloops;
+    watchdog_entry_t    entries[WATCHDOG_MAX_LOOPS];
+    // loops stalled in this round, for watchdog_thread only
+    int                 nbacktraces;
+    watchdog_target_t   backtraces[WATCHDOG_MAX_LOOPS];
+} watchdog_t;
+
+static watchdog_t*  s_watchdog = NULL;
+static hmutex_t     s_watchdog_mutex;
+static honce_t     s_watchdog_once = HONCE_INIT;
+
+static void watchdog_init_once() {
+    hmutex_init(&s_watchdog_mutex);
+}
+
+static const char* event_type_str(int event_type) {
+    switch (event_type) {
+    case HEVENT_TYPE_NONE:      return "loop";
+    case HEVENT_TYPE_IO:        return "io";
+    case HEVENT_TYPE_TIMEOUT:   return "timeout";
+    case HEVENT_TYPE_PERIOD:    return "period";
+    case HEVENT_TYPE_IDLE:      return "idle";
+    case HEVENT_TYPE_SIGNAL:    return "signal";
+    default:                    return "custom";
+    }
+}
+
+#ifdef HAVE_WATCHDOG_BACKTRACE
+static void* volatile   s_frames[WATCHDOG_BACKTRACE_DEPTH];
+static volatile int     s_nframes = -1;
+static struct sigaction s_old_sigaction;
+
+static void watchdog_signal_handler(int signo) {
+    s_nframes = backtrace((void**)s_frames, WATCHDOG_BACKTRACE_DEPTH);
+}
+
+static void watchdog_install_signal() {
+    // NOTE: backtrace lazily loads libgcc, call it once outside signal handler.
+    void* frame = NULL;
+    backtrace(&frame, 1);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watchdog_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(HLOOP_WATCHDOG_SIGNAL, &sa, &s_old_sigaction);
+}
+
+static void watchdog_uninstall_signal() {
+    sigaction(HLOOP_WATCHDOG_SIGNAL, &s_old_sigaction, NULL);
+}
+
+// NOTE: sleep up to WATCHDOG_BACKTRACE_TIMEOUT, call without holding wdg->mutex.
+static void watchdog_log_backtrace(const watchdog_target_t* target) {
+    s_nframes = -1;
+    if (syscall(SYS_tgkill, target->pid, target->tid, HLOOP_WATCHDOG_SIGNAL) != 0) return;
+    for (int i = 0; i < WATCHDOG_BACKTRACE_TIMEOUT && s_nframes < 0; ++i) {
+        hv_msleep(1);
+    }
+    int nframes = s_nframes;
+    if (nframes <= 0) return;
+    char** symbols = backtrace_symbols((void**)s_frames, nframes);
+    if (symbols == NULL) return;
+    // skip watchdog_signal_handler and signal trampoline
+    for (int i = 2; i < nframes; ++i) {
+        hlogw("[watchdog]   #%d %s", i - 2, symbols[i]);
+    }
+    free(symbols);
+}
+
+static void watchdog_symbol(void* addr, char* buf, int len) {
+    char** symbols = addr ? backtrace_symbols(&addr, 1) : NULL;
+    if (symbols) {
+        snprintf(buf, len, "%s", symbols[0]);
+        free(symbols);
+    } else {
+        snprintf(buf, len, "%p", addr);
+    }
+}
+#else
+static void watchdog_symbol(void* addr, char* buf, int len) {
+    snprintf(buf, len, "%p", addr);
+}
+#endif
+
+static void watchdog_check(watchdog_t* wdg, watchdog_entry_t* entry, uint64_t now_us) {
+    hloop_t* loop = entry->loop;
+    long cb_seq = loop->cb_seq;
+    int busy = loop->status == HLOOP_STATUS_RUNNING && !loop->in_poll;
+    uint64_t loop_cnt = hatomic_load_relaxed(&loop->loop_cnt);
+    if (!busy || cb_seq != entry->cb_seq || loop_cnt != entry->loop_cnt) {
+        // heartbeat
+        if (entry->stalled) {
+            entry->stalled = 0;
+            hlogw("[watchdog] loop tid=%ld recovered after %llums", loop->tid,
+                (unsigned long long)entry->stall.duration / 1000);
+            hmutex_lock(&loop->stalls_mutex);
+            hloop_stall_add_slowest(&loop->stats, &entry->stall);
+            hmutex_unlock(&loop->stalls_mutex);
+        }
+        entry->cb_seq = cb_seq;
+        entry->loop_cnt = loop_cnt;
+        entry->since_us = now_us;
+        return;
+    }
+    uint64_t duration = now_us - entry->since_us;
+    if (entry->stalled) {
+        entry->stall.duration = duration;
+        return;
+    }
+    if (duration < (uint64_t)wdg->threshold_ms * 1000) return;
+    // NOTE: cb_seq unchanged, so cur_cb is stable.
+    entry->stalled = 1;
+    entry->stall = loop->cur_cb;
+    entry->stall.start_ms = gettimeofday_ms() - duration / 1000;
+    entry->stall.duration = duration;
+    hmutex_lock(&loop->stalls_mutex);
+    ++loop->stats.stalls;
+    hmutex_unlock(&loop->stalls_mutex);
+    char symbol[256];
+    watchdog_symbol(entry->stall.cb, symbol, sizeof(symbol));
+    hlogw("[watchdog] loop pid=%ld tid=%ld stalled %llums in %s callback id=%llu fd=%d cb=%s",
+        loop->pid, loop->tid, (unsigned long long)duration / 1000,
+        event_type_str(entry->stall.event_type),
+        (unsigned long long)entry->stall.event_id, entry->stall.fd, symbol);
+#ifdef HAVE_WATCHDOG_BACKTRACE
+    if (wdg->flags & HLOOP_WATCHDOG_BACKTRACE) {
+        watchdog_target_t* target = &wdg->backtraces[wdg->nbacktraces++];
+        target->pid = loop->pid;
+        target->tid = loop->tid;
+    }
+#endif
+}
+
+static HTHREAD_ROUTINE(watchdog_thread) {
+    watchdog_t* wdg = (watchdog_t*)userdata;
+    int interval_ms = MAX(wdg->threshold_ms / 4, 1);
+    while (wdg->running) {
+        hv_msleep(interval_ms);
+        uint64_t now_us = gethrtime_us();
+        wdg->nbacktraces = 0;
+        hmutex_lock(&wdg->mutex);
+        for (int i = 0; i < wdg->nloops; ++i) {
+            watchdog_check(wdg, &wdg->entries[i], now_us);
+        }
+        hmutex_unlock(&wdg->mutex);
+#ifdef HAVE_WATCHDOG_BACKTRACE
+        for (int i = 0; i < wdg->nbacktraces; ++i) {
+            watchdog_log_backtrace(&wdg->backtraces[i]);
+        }
+#endif
+    }
+    return 0;
+}
+
+int hloop_watchdog_start(int threshold_ms, int flags) {
+    honce(&s_watchdog_once, watchdog_init_once);
+    hmutex_lock(&s_watchdog_mutex);
+    if (s_watchdog) {
+        hmutex_unlock(&s_watchdog_mutex);
+        return 0;
+    }
+    watchdog_t* wdg = NULL;
+    HV_ALLOC_SIZEOF(wdg);
+    hmutex_init(&wdg->mutex);
+    wdg->threshold_ms = threshold_ms > 0 ? threshold_ms : 1000;
+    wdg->flags = flags;
+    wdg->running = 1;
+#ifdef HAVE_WATCHDOG_BACKTRACE
+    if (flags & HLOOP_WATCHDOG_BACKTRACE) {
+        watchdog_install_signal();
+    }
+#endif
+    wdg->thread = hthread_create(watchdog_thread, wdg);
+    s_watchdog = wdg;
+    hmutex_unlock(&s_watchdog_mutex);
+    hlogi("[watchdog] start threshold=%dms flags=%d", wdg->threshold_ms, flags);
+    return 0;
+}
+
+void hloop_watchdog_stop() {
+    honce(&s_watchdog_once, watchdog_init_once);
+    hmutex_lock(&s_watchdog_mutex);
+    watchdog_t* wdg = s_watchdog;
+    s_watchdog = NULL;
+    hmutex_unlock(&s_watchdog_mutex);
+    if (wdg == NULL) return;
+    wdg->running = 0;
+    hthread_join(wdg->thread);
+#ifdef HAVE_WATCHDOG_BACKTRACE
+    if (wdg->flags & HLOOP_WATCHDOG_BACKTRACE) {
+        watchdog_uninstall_signal();
+    }
+#endif
+    for (int i = 0; i < wdg->nloops; ++i) {
+        wdg->entries[i].loop->watched = 0;
+    }
+    hmutex_destroy(&wdg->mutex);
+    HV_FREE(wdg);
+}
+
+int hloop_watch(hloop_t* loop) {
+    honce(&s_watchdog_once, watchdog_init_once);
+    int ret = -1;
+    hmutex_lock(&s_watchdog_mutex);
+    watchdog_t* wdg = s_watchdog;
+    if (wdg) {
+        hmutex_lock(&wdg->mutex);
+        if (loop->watched) {
+            ret = 0;
+        } else if (wdg->nloops < WATCHDOG_MAX_LOOPS) {
+            watchdog_entry_t* entry = &wdg->entries[wdg->nloops++];
+            memset(entry, 0, sizeof(watchdog_entry_t));
+            entry->loop = loop;
+            entry->since_us = gethrtime_us();
+            loop->watched = 1;
+            ret = 0;
+        }
+        hmutex_unlock(&wdg->mutex);
+    }
+    hmutex_unlock(&s_watchdog_mutex);
+    return ret;
+}
+
+int hloop_unwatch(hloop_t* loop) {
+    honce(&s_watchdog_once, watchdog_init_once);
+    hmutex_lock(&s_watchdog_mutex);
+    watchdog_t* wdg = s_watchdog;
+    if (wdg) {
+        hmutex_lock(&wdg->mutex);
+        for (int i = 0; i < wdg->nloops; ++i) {
+            if (wdg->entries[i].loop == loop) {
+                wdg->entries[i] = wdg->entries[--wdg->nloops];
+                break;
+            }
+        }
+        hmutex_unlock(&wdg->mutex);
+    }
+    loop->watched = 0;
+    hmutex_unlock(&s_watchdog_mutex);
+    return 0;
+}
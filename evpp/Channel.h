@@ -155,6 +155,24 @@ public:
         return write(str.data(), str.size());
     }
 
+    // NOTE: zero-copy, buf is referenced by write_queue until all written.
+    int write(const BufferPtr& buf) {
+        if (!isOpened()) return -1;
+        return hio_write_owned(io_, buf->data(), buf->size(), release_buffer, new BufferPtr(buf));
+    }
+
+    // NOTE: zero-copy, linux tcp or kernel TLS only, @see hio_sendfile
+    // Unsent file bytes are not limited by setMaxWriteBufsize.
+    int sendFile(int fd, uint64_t offset, size_t len) {
+        if (!isOpened()) return -1;
+        return hio_sendfile(io_, fd, offset, len);
+    }
+
+    bool isSendFileSupported() {
+        if (!isOpened()) return false;
+        return hio_sendfile_supported(io_);
+    }
+
     // iobuf setting
     void setReadBuf(void* buf, size_t len) {
         if (io_ == NULL) return;
@@ -164,6 +182,11 @@ public:
         if (io_ == NULL) return;
         hio_set_max_read_bufsize(io_, size);
     }
+    // mirrored ring readbuf for setUnpack, @see hio_set_readbuf_mirror
+    int setReadBufMirror(bool on = true) {
+        if (io_ == NULL) return -1;
+        return hio_set_readbuf_mirror(io_, on);
+    }
     void setMaxWriteBufsize(uint32_t size) {
         if (io_ == NULL) return;
         hio_set_max_write_bufsize(io_, size);
@@ -175,6 +198,19 @@ public:
     bool isWriteComplete() {
         return writeBufsize() == 0;
     }
+    // write backpressure: onhighwater when writeBufsize > high_water, ondrained when <= low_water,
+    // low_water 0 defaults to high_water / 2.
+    // NOTE: onhighwater is called in the thread of write, ondrained in the loop thread.
+    void setWriteWater(uint32_t high_water, uint32_t low_water = 0) {
+        if (io_ == NULL) return;
+        hio_setcb_high_water(io_, on_high_water);
+        hio_setcb_drained(io_, on_drained);
+        hio_set_write_water(io_, high_water, low_water);
+    }
+    bool isOverHighWater() {
+        if (io_ == NULL) return false;
+        return hio_is_over_high_water(io_);
+    }
 
     // close thread-safe
     int close(bool async = false) {
@@ -204,6 +240,9 @@ public:
     // NOTE: Use Channel::isWriteComplete in onwrite callback to determine whether all data has been written.
     std::function<void(Buffer*)> onwrite;
     std::function<void()>        onclose;
+    // @see setWriteWater
+    std::function<void(size_t)>  onhighwater;
+    std::function<void(size_t)>  ondrained;
     std::shared_ptr<void>        contextPtr_;
 
 private:
@@ -223,6 +262,24 @@ private:
         }
     }
 
+    static void on_high_water(hio_t* io, size_t write_bufsize) {
+        Channel* channel = (Channel*)hio_context(io);
+        if (channel && channel->onhighwater) {
+            channel->onhighwater(write_bufsize);
+        }
+    }
+
+    static void on_drained(hio_t* io, size_t write_bufsize) {
+        Channel* channel = (Channel*)hio_context(io);
+        if (channel && channel->ondrained) {
+            channel->ondrained(write_bufsize);
+        }
+    }
+
+    static void release_buffer(void* data, void* userdata) {
+        delete (BufferPtr*)userdata;
+    }
+
     static void on_close(hio_t* io) {
         Channel* channel = (Channel*)hio_context(io);
         if (channel) {
@@ -252,6 +309,11 @@ public:
         if (io_ == NULL) return false;
         return hio_is_ssl(io_);
     }
+    // HSSL_KTLS_TX | HSSL_KTLS_RX after handshake, @see hio_get_ktls
+    int getKtls() {
+        if (io_ == NULL) return 0;
+        return hio_get_ktls(io_);
+    }
     int setSSL(hssl_t ssl) {
         if (io_ == NULL) return -1;
         return hio_set_ssl(io_, ssl);
@@ -23,6 +23,7 @@ public:
         tls_setting = NULL;
         reconn_setting = NULL;
         unpack_setting = NULL;
+        write_high_water = write_low_water = 0;
     }
 
     virtual ~TcpClientEventLoopTmpl() {
@@ -141,6 +142,9 @@ public:
             if (unpack_setting) {
                 channel->setUnpack(unpack_setting);
             }
+            if (write_high_water) {
+                channel->setWriteWater(write_high_water, write_low_water);
+            }
             channel->startRead();
             if (onConnection) {
                 onConnection(channel);
@@ -159,6 +163,16 @@ public:
                 onWriteComplete(channel, buf);
             }
         };
+        channel->onhighwater = [this](size_t write_bufsize) {
+            if (onHighWater) {
+                onHighWater(channel, write_bufsize);
+            }
+        };
+        channel->ondrained = [this](size_t write_bufsize) {
+            if (onDrained) {
+                onDrained(channel, write_bufsize);
+            }
+        };
         channel->onclose = [this]() {
             bool reconnect = reconn_setting != NULL;
             if (onConnection) {
@@ -246,6 +260,12 @@ public:
         *unpack_setting = *setting;
     }
 
+    // @see TcpServer::setWriteWater
+    void setWriteWater(uint32_t high_water, uint32_t low_water = 0) {
+        write_high_water = high_water;
+        write_low_water = low_water;
+    }
+
 public:
     TSocketChannelPtr       channel;
 
@@ -257,12 +277,17 @@ public:
     hssl_ctx_opt_t*         tls_setting;
     reconn_setting_t*       reconn_setting;
     unpack_setting_t*       unpack_setting;
+    uint32_t                write_high_water;
+    uint32_t                write_low_water;
 
     // Callback
     std::function<void(const TSocketChannelPtr&)>           onConnection;
     std::function<void(const TSocketChannelPtr&, Buffer*)>  onMessage;
     // NOTE: Use Channel::isWriteComplete in onWriteComplete callback to determine whether all data has been written.
     std::function<void(const TSocketChannelPtr&, Buffer*)>  onWriteComplete;
+    // NOTE: onHighWater may be called in the thread of write, @see setWriteWater
+    std::function<void(const TSocketChannelPtr&, size_t)>   onHighWater;
+    std::function<void(const TSocketChannelPtr&, size_t)>   onDrained;
 
 private:
     EventLoopPtr            loop_;
@@ -1,6 +1,8 @@
 #ifndef HV_TCP_SERVER_HPP_
 #define HV_TCP_SERVER_HPP_
 
+#include <algorithm>
+
 #include "hsocket.h"
 #include "hssl.h"
 #include "hlog.h"
@@ -23,7 +25,13 @@ public:
         tls_setting = NULL;
         unpack_setting = NULL;
         max_connections = 0xFFFFFFFF;
+        write_high_water = write_low_water = 0;
         load_balance = LB_RoundRobin;
+        reuseport = false;
+        reuseport_steer_by_cpu = false;
+        rebalance_interval_ms = 0;
+        rebalance_imbalance = 0;
+        rebalance_timer = INVALID_TIMER_ID;
     }
 
     virtual ~TcpServerEventLoopTmpl() {
@@ -41,14 +49,34 @@ public:
 
     //@retval >=0 listenfd, <0 error
     int createsocket(int port, const char* host = "0.0.0.0") {
-        listenfd = Listen(port, host);
+        listenfd = reuseport ? ListenReusePort(port, host) : Listen(port, host);
         if (listenfd < 0) return listenfd;
+        if (port == 0) {
+            // NOTE: other SO_REUSEPORT listeners must bind the same port
+            sockaddr_u addr;
+            socklen_t addrlen = sizeof(addr);
+            getsockname(listenfd, &addr.sa, &addrlen);
+            port = sockaddr_port(&addr);
+        }
         this->host = host;
         this->port = port;
         return listenfd;
     }
     // closesocket thread-safe
     void closesocket() {
+        if (listenfds.size() > 0) {
+            // NOTE: listenfds[i] is accepted by worker_threads.loop(i)
+            for (size_t i = 0; i < listenfds.size(); ++i) {
+                hloop_t* loop = worker_threads.hloop(i);
+                if (loop) {
+                    hio_t* listenio = hio_get(loop, listenfds[i]);
+                    assert(listenio != NULL);
+                    hio_close_async(listenio);
+                }
+            }
+            listenfds.clear();
+            listenfd = -1;
+        }
         if (listenfd >= 0) {
             hloop_t* loop = acceptor_loop->loop();
             if (loop) {
@@ -68,11 +96,43 @@ public:
         load_balance = lb;
     }
 
+    // NOTE: SO_REUSEPORT: each worker_thread listens on its own socket and accepts locally,
+    // no acceptor thread and no cross-thread handoff, load_balance is done by kernel.
+    // @param steer_by_cpu: @see so_reuseport_steer_by_cpu, pin worker_threads to cpus to make use of it.
+    // NOTE: call before createsocket, ignored if setThreadNum(0).
+    void setReusePort(bool on = true, bool steer_by_cpu = false) {
+        reuseport = on;
+        reuseport_steer_by_cpu = on && steer_by_cpu;
+    }
+
+    // NOTE: load_balance only balances new connections, long-lived connections with
+    // different message rates make worker_threads skewed. The rebalancer measures busy time
+    // of worker_threads every interval_ms, if the busiest one exceeds the idlest one by
+    // imbalance * interval_ms, migrates its hottest connections to the idlest one.
+    // @see hio_migrate, hloop_stats_t.migrated_out
+    // NOTE: call before start, onMessage of migrated channels will be called in new thread.
+    void setRebalance(int interval_ms = 1000, float imbalance = 0.2) {
+        rebalance_interval_ms = interval_ms;
+        rebalance_imbalance = imbalance;
+    }
+
+    // @brief connections migrated by rebalancer
+    uint64_t migrationNum() {
+        hloop_stats_t stats;
+        worker_threads.stats(&stats);
+        return stats.migrated_out;
+    }
+
     // NOTE: totalThreadNum = 1 acceptor_thread + N worker_threads (N can be 0)
     void setThreadNum(int num) {
         worker_threads.setThreadNum(num);
     }
 
+    // bind worker_threads to cpus, @see EventLoopThreadPool::setCpuAffinity
+    int setCpuAffinity(const char* affinity) {
+        return worker_threads.setCpuAffinity(affinity);
+    }
+
     int startAccept() {
         if (listenfd < 0) {
             listenfd = createsocket(port, host.c_str());
@@ -81,27 +141,25 @@ public:
                 return listenfd;
             }
         }
-        hloop_t* loop = acceptor_loop->loop();
-        if (loop == NULL) return -2;
-        hio_t* listenio = haccept(loop, listenfd, onAccept);
-        assert(listenio != NULL);
-        hevent_set_userdata(listenio, this);
-        if (tls) {
-            hio_enable_ssl(listenio);
-            if (tls_setting) {
-                int ret = hio_new_ssl_ctx(listenio, tls_setting);
-                if (ret != 0) {
-                    hloge("new SSL_CTX failed: %d", ret);
-                    closesocket();
-                    return ret;
-                }
-            }
+        if (reuseport && worker_threads.threadNum() > 0) {
+            return startAcceptReusePort();
         }
-        return 0;
+        return startAcceptInLoop(acceptor_loop->loop(), listenfd);
     }
 
     int stopAccept() {
         if (listenfd < 0) return -1;
+        if (listenfds.size() > 0) {
+            for (size_t i = 0; i < listenfds.size(); ++i) {
+                EventLoopPtr worker_loop = worker_threads.loop(i);
+                if (worker_loop == NULL) continue;
+                int fd = listenfds[i];
+                worker_loop->runInLoop([worker_loop, fd](){
+                    hio_del(hio_get(worker_loop->loop(), fd), HV_READ);
+                });
+            }
+            return 0;
+        }
         hloop_t* loop = acceptor_loop->loop();
         if (loop == NULL) return -2;
         hio_t* listenio = hio_get(loop, listenfd);
@@ -112,12 +170,23 @@ public:
     // start thread-safe
     void start(bool wait_threads_started = true) {
         if (worker_threads.threadNum() > 0) {
+            if (rebalance_interval_ms > 0 && worker_threads.threadNum() > 1) {
+                // NOTE: busy time is the sum of HLOOP_HIST_ITERATION
+                worker_threads.enableStats(true);
+                rebalance_busy_us.assign(worker_threads.threadNum(), 0);
+                rebalance_timer = acceptor_loop->setInterval(rebalance_interval_ms,
+                    std::bind(&TcpServerEventLoopTmpl::rebalance, this));
+            }
             worker_threads.start(wait_threads_started);
         }
         acceptor_loop->runInLoop(std::bind(&TcpServerEventLoopTmpl::startAccept, this));
     }
     // stop thread-safe
     void stop(bool wait_threads_stopped = true) {
+        if (rebalance_timer != INVALID_TIMER_ID) {
+            acceptor_loop->killTimer(rebalance_timer);
+            rebalance_timer = INVALID_TIMER_ID;
+        }
         closesocket();
         if (worker_threads.threadNum() > 0) {
             worker_threads.stop(wait_threads_stopped);
@@ -147,6 +216,13 @@ public:
         *unpack_setting = *setting;
     }
 
+    // onHighWater when write bufsize of a channel > high_water, onDrained when <= low_water (0: high_water / 2),
+    // e.g. stop producing for a slow consumer and resume later, @see Channel::setWriteWater
+    void setWriteWater(uint32_t high_water, uint32_t low_water = 0) {
+        write_high_water = high_water;
+        write_low_water = low_water;
+    }
+
     // channel
     const TSocketChannelPtr& addChannel(hio_t* io) {
         uint32_t id = hio_id(io);
@@ -193,6 +269,54 @@ public:
     }
 
 private:
+    int startAcceptInLoop(hloop_t* loop, int fd) {
+        if (loop == NULL) return -2;
+        hio_t* listenio = haccept(loop, fd, onAccept);
+        assert(listenio != NULL);
+        hevent_set_userdata(listenio, this);
+        if (tls) {
+            hio_enable_ssl(listenio);
+            if (tls_setting) {
+                int ret = hio_new_ssl_ctx(listenio, tls_setting);
+                if (ret != 0) {
+                    hloge("new SSL_CTX failed: %d", ret);
+                    closesocket();
+                    return ret;
+                }
+            }
+        }
+        return 0;
+    }
+
+    // NOTE: listenfds[0] = listenfd, listenfds[i] is accepted by worker_threads.loop(i),
+    // so the index of so_reuseport_steer_by_cpu is the index of worker_threads.
+    int startAcceptReusePort() {
+        int nloops = worker_threads.threadNum();
+        listenfds.clear();
+        listenfds.push_back(listenfd);
+        for (int i = 1; i < nloops; ++i) {
+            int fd = ListenReusePort(port, host.c_str());
+            if (fd < 0) {
+                hloge("ListenReusePort %s:%d return %d!", host.c_str(), port, fd);
+                break;
+            }
+            listenfds.push_back(fd);
+        }
+        if (reuseport_steer_by_cpu) {
+            if (so_reuseport_steer_by_cpu(listenfd, listenfds.size()) != 0) {
+                hlogw("so_reuseport_steer_by_cpu failed, fallback to hash!");
+            }
+        }
+        for (size_t i = 0; i < listenfds.size(); ++i) {
+            EventLoopPtr worker_loop = worker_threads.loop(i);
+            int fd = listenfds[i];
+            worker_loop->runInLoop([this, worker_loop, fd](){
+                startAcceptInLoop(worker_loop->loop(), fd);
+            });
+        }
+        return 0;
+    }
+
     static void newConnEvent(hio_t* connio) {
         TcpServerEventLoopTmpl* server = (TcpServerEventLoopTmpl*)hevent_userdata(connio);
         if (server->connectionNum() >= server->max_connections) {
@@ -204,7 +328,9 @@ private:
         // NOTE: attach to worker loop
         EventLoop* worker_loop = currentThreadEventLoop;
         assert(worker_loop != NULL);
-        hio_attach(worker_loop->loop(), connio);
+        if (hevent_loop(connio) != worker_loop->loop()) {
+            hio_attach(worker_loop->loop(), connio);
+        }
 
         const TSocketChannelPtr& channel = server->addChannel(connio);
         channel->status = SocketChannel::CONNECTED;
@@ -236,17 +362,109 @@ private:
         if (server->unpack_setting) {
             channel->setUnpack(server->unpack_setting);
         }
+        if (server->write_high_water) {
+            channel->onhighwater = [server, &channel](size_t write_bufsize) {
+                if (server->onHighWater) {
+                    server->onHighWater(channel, write_bufsize);
+                }
+            };
+            channel->ondrained = [server, &channel](size_t write_bufsize) {
+                if (server->onDrained) {
+                    server->onDrained(channel, write_bufsize);
+                }
+            };
+            channel->setWriteWater(server->write_high_water, server->write_low_water);
+        }
         channel->startRead();
         if (server->onConnection) {
             server->onConnection(channel);
         }
     }
 
+    // in acceptor_loop
+    void rebalance() {
+        int nloops = worker_threads.threadNum();
+        if (!worker_threads.isRunning() || (int)rebalance_busy_us.size() != nloops) return;
+        int hot = -1, cold = -1;
+        uint64_t hot_busy_us = 0, cold_busy_us = 0;
+        hloop_stats_t stats;
+        for (int i = 0; i < nloops; ++i) {
+            hloop_stats(worker_threads.hloop(i), &stats);
+            uint64_t sum = stats.hists[HLOOP_HIST_ITERATION].sum;
+            uint64_t busy_us = sum - rebalance_busy_us[i];
+            rebalance_busy_us[i] = sum;
+            if (hot < 0 || busy_us > hot_busy_us) {
+                hot = i;
+                hot_busy_us = busy_us;
+            }
+            if (cold < 0 || busy_us < cold_busy_us) {
+                cold = i;
+                cold_busy_us = busy_us;
+            }
+        }
+        uint64_t gap_us = hot_busy_us - cold_busy_us;
+        if (hot == cold || gap_us < rebalance_imbalance * rebalance_interval_ms * 1000) return;
+        EventLoopPtr hot_loop = worker_threads.loop(hot);
+        EventLoopPtr cold_loop = worker_threads.loop(cold);
+        hot_loop->runInLoop([this, hot_loop, cold_loop, hot_busy_us, gap_us]() {
+            migrateHotChannels(hot_loop.get(), cold_loop.get(), hot_busy_us, gap_us);
+        });
+    }
+
+    // in hot_loop, move hot connections to cold_loop to narrow the busy gap_us
+    void migrateHotChannels(EventLoop* hot_loop, EventLoop* cold_loop, uint64_t busy_us, uint64_t gap_us) {
+        std::vector<std::pair<uint32_t, hio_t*>> hot_ios;
+        uint64_t total_events = 0;
+        foreachChannel([hot_loop, &hot_ios, &total_events](const TSocketChannelPtr& channel) {
+            hio_t* io = channel->io();
+            if (io == NULL || hevent_loop(io) != hot_loop->loop()) return;
+            uint32_t nevents = hio_take_event_count(io);
+            total_events += nevents;
+            if (nevents) hot_ios.push_back(std::make_pair(nevents, io));
+        });
+        if (total_events == 0) return;
+        std::sort(hot_ios.begin(), hot_ios.end(),
+            [](const std::pair<uint32_t, hio_t*>& lhs, const std::pair<uint32_t, hio_t*>& rhs) {
+                return lhs.first > rhs.first;
+            });
+        // NOTE: estimate cost by event rate, move it only if the gap narrowed,
+        // so a single connection hotter than the gap will not ping-pong.
+        uint64_t moved_us = 0;
+        for (auto& pair : hot_ios) {
+            uint64_t cost_us = busy_us * pair.first / total_events;
+            if (2 * moved_us + cost_us >= gap_us) continue;
+            if (hio_migrate(pair.second, cold_loop->loop(), onMigrated, hot_loop) == 0) {
+                moved_us += cost_us;
+            }
+        }
+    }
+
+    // in cold_loop
+    static void onMigrated(hio_t* connio, void* userdata) {
+        EventLoop* hot_loop = (EventLoop*)userdata;
+        --hot_loop->connectionNum;
+        ++currentThreadEventLoop->connectionNum;
+    }
+
     static void onAccept(hio_t* connio) {
         TcpServerEventLoopTmpl* server = (TcpServerEventLoopTmpl*)hevent_userdata(connio);
+        if (server->reuseport && server->worker_threads.threadNum() > 0) {
+            // NOTE: SO_REUSEPORT: accepted by worker loop, no handoff
+            ++currentThreadEventLoop->connectionNum;
+            newConnEvent(connio);
+            return;
+        }
         // NOTE: detach from acceptor loop
         hio_detach(connio);
-        EventLoopPtr worker_loop = server->worker_threads.nextLoop(server->load_balance);
+        EventLoopPtr worker_loop;
+        if (server->load_balance == LB_IpHash) {
+            char ip[SOCKADDR_STRLEN] = {0};
+            sockaddr_ip((sockaddr_u*)hio_peeraddr(connio), ip, sizeof(ip));
+            worker_loop = server->worker_threads.nextLoop(LB_IpHash, ip, strlen(ip));
+        } else {
+            // NOTE: no url for LB_UrlHash, fallback to LB_RoundRobin
+            worker_loop = server->worker_threads.nextLoop(server->load_balance);
+        }
         if (worker_loop == NULL) {
             worker_loop = server->acceptor_loop;
         }
@@ -266,9 +484,18 @@ public:
     std::function<void(const TSocketChannelPtr&, Buffer*)>  onMessage;
     // NOTE: Use Channel::isWriteComplete in onWriteComplete callback to determine whether all data has been written.
     std::function<void(const TSocketChannelPtr&, Buffer*)>  onWriteComplete;
+    // NOTE: onHighWater may be called in the thread of write, @see setWriteWater
+    std::function<void(const TSocketChannelPtr&, size_t)>   onHighWater;
+    std::function<void(const TSocketChannelPtr&, size_t)>   onDrained;
 
     uint32_t                max_connections;
+    uint32_t                write_high_water;
+    uint32_t                write_low_water;
     load_balance_e          load_balance;
+    bool                    reuseport;
+    bool                    reuseport_steer_by_cpu;
+    int                     rebalance_interval_ms;
+    float                   rebalance_imbalance;
 
 private:
     // id => TSocketChannelPtr
@@ -277,6 +504,10 @@ private:
 
     EventLoopPtr            acceptor_loop;
     EventLoopThreadPool     worker_threads;
+    std::vector<int>        listenfds; // SO_REUSEPORT, one per worker_thread
+    // rebalance, @see setRebalance
+    TimerID                 rebalance_timer;
+    std::vector<uint64_t>   rebalance_busy_us; // last sum of HLOOP_HIST_ITERATION
 };
 
 template<class TSocketChannel = SocketChannel>
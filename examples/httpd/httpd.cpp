@@ -112,6 +112,14 @@ int parse_confile(const char* confile) {
         g_http_server.worker_connections = atoi(str.c_str());
     }
 
+    // worker_cpu_affinity
+    str = ini.GetValue("worker_cpu_affinity");
+    if (str.size() != 0) {
+        if (g_http_server.setCpuAffinity(str.c_str()) != 0) {
+            hloge("Invalid worker_cpu_affinity: %s", str.c_str());
+        }
+    }
+
     // http_port
     int port = 0;
     const char* szPort = get_arg("p");
@@ -190,6 +198,11 @@ int parse_confile(const char* confile) {
         param.key_file = key_file.c_str();
         param.ca_file = ca_file.c_str();
         param.endpoint = HSSL_SERVER;
+        param.ktls = ini.Get<bool>("ssl_ktls");
+        param.session_cache_size = ini.Get<int>("ssl_session_cache_size");
+        param.ticket_rotate_s = ini.Get<int>("ssl_session_ticket_rotate");
+        std::string ticket_secret = ini.GetValue("ssl_session_ticket_secret");
+        param.ticket_secret = ticket_secret.c_str();
         if (g_http_server.newSslCtx(&param) != 0) {
 #ifdef OS_WIN
             if (strcmp(hssl_backend(), "schannel") == 0) {
@@ -117,6 +117,8 @@ static void on_upstream_connect(hio_t* upstream_io) {
     hio_write(conn->io, resp, resp_len);
     hio_setcb_read(upstream_io, hio_write_upstream);
     hio_setcb_read(conn->io, hio_write_upstream);
+    // NOTE: relayed by splice in kernel on linux, fallback to hio_write_upstream if not supported
+    hio_set_splice_upstream(conn->io, 1);
     hio_read(conn->io);
     hio_read(upstream_io);
 }
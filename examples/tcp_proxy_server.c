@@ -35,6 +35,7 @@ static int  backend_port = 80;
 static int  backend_ssl = 0;
 
 // hloop_create_tcp_server -> on_accept -> hio_setup_tcp_upstream
+// NOTE: relayed by splice in kernel on linux if not ssl, @see hio_set_splice_upstream
 
 static void on_accept(hio_t* io) {
     /*
@@ -48,6 +49,8 @@ static void on_accept(hio_t* io) {
 
     if (backend_port % 1000 == 443) backend_ssl = 1;
     hio_setup_tcp_upstream(io, backend_host, backend_port, backend_ssl);
+    // NOTE: fallback to hio_write_upstream if ssl or not supported
+    hio_set_splice_upstream(io, 1);
 }
 
 int main(int argc, char** argv) {
@@ -65,6 +65,8 @@ int main(int argc, char** argv) {
 #if TEST_KCP
     hio_set_kcp(io, NULL);
 #endif
+    // recvmmsg up to HIO_MAX_BATCH datagrams per readable event, @see unittest/udp_pps_test.c
+    hio_set_batch(io, HIO_MAX_BATCH, 0);
     hio_setcb_read(io, on_recvfrom);
     hio_read(io);
     hloop_run(loop);
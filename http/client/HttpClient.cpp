@@ -242,6 +242,10 @@ int http_client_connect(http_client_t* cli, const char* host, int port, int http
         if (!is_ipaddr(host)) {
             hssl_set_sni_hostname(cli->ssl, host);
         }
+        // resume session of the same host:port
+        char peer[256] = {0};
+        snprintf(peer, sizeof(peer), "%s:%d", host, port);
+        hssl_reuse_session(cli->ssl, peer);
         unsigned int elapsed = gettick_ms() - start_time;
         int ssl_timeout = blocktime - (int)elapsed;
         if (ssl_timeout <= 0) {
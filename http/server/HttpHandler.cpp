@@ -36,6 +36,7 @@ HttpHandler::HttpHandler(hio_t* io) :
     proxy_connected(0),
     forward_proxy(0),
     reverse_proxy(0),
+    migrating(0),
     ip{'\0'},
     port(0),
     pid(0),
@@ -52,7 +53,8 @@ HttpHandler::HttpHandler(hio_t* io) :
     files(NULL),
     file(NULL),
     // for proxy
-    proxy_port(0)
+    proxy_port(0),
+    server(NULL)
 {
     // Init();
 }
@@ -672,6 +674,28 @@ int HttpHandler::defaultLargeFileHandler(const std::string &filepath) {
         // forbidden to send large file
         resp->content_length = 0;
         resp->status_code = HTTP_STATUS_FORBIDDEN;
+    } else if (!resp->IsChunked() && hio_sendfile_supported(io)) {
+        // sendfile: plaintext tcp or kernel TLS, zero-copy from page cache
+        // NOTE: file has been seeked to the beginning of range
+        file->offset = ftell(file->fp);
+        if (service->limit_rate < 0) {
+            file->chunk = 1 << 20; // 1M
+            writer->onwrite = [this](HBuf* buf) {
+                if (writer->isWriteComplete()) {
+                    sendFile();
+                }
+            };
+        } else {
+            // limit_rate drives chunk size, interval_ms >= 10 to avoid busy timer
+            // limit_rate=40KB/s  interval_ms=1000 chunk=40K
+            // limit_rate=40MB/s  interval_ms=10   chunk=400K
+            int interval_ms = 40960 * 1000 / 1024 / service->limit_rate;
+            if (interval_ms < 10) interval_ms = 10;
+            file->chunk = (size_t)service->limit_rate * 1024 * interval_ms / 1000;
+            file->timer = setInterval(interval_ms, std::bind(&HttpHandler::sendFile, this));
+        }
+        // cork headers with the first chunk of file, uncork in sendFile
+        tcp_nopush(hio_fd(io), 1);
     } else {
         size_t bufsize = 40960; // 40K
         file->buf.resize(bufsize);
@@ -867,6 +891,10 @@ return_header:
     return 0;
 }
 
+static void free_body(void* buf, void* userdata) {
+    delete (std::string*)userdata;
+}
+
 int HttpHandler::SendHttpResponse(bool submit) {
     if (!io || !parser) return -1;
     char* data = NULL;
@@ -875,7 +903,13 @@ int HttpHandler::SendHttpResponse(bool submit) {
     while (GetSendData(&data, &len)) {
         // printf("GetSendData %d\n", (int)len);
         if (data && len) {
-            hio_write(io, data, len);
+            if (data == resp->body.data() && len == resp->body.size()) {
+                // NOTE: large body, move it to write_queue instead of copying the unwritten tail
+                std::string* body = new std::string(std::move(resp->body));
+                hio_write_owned(io, (void*)body->data(), body->size(), free_body, body);
+            } else {
+                hio_write(io, data, len);
+            }
             total_len += len;
         }
     }
@@ -896,6 +930,8 @@ int HttpHandler::openFile(const char* filepath) {
     closeFile();
     file = new LargeFile;
     file->timer = INVALID_TIMER_ID;
+    file->offset = 0;
+    file->chunk = 0;
 #ifdef OS_WIN
     return file->open(hv::utf8_to_ansi(filepath).c_str(), "rb");
 #else
@@ -910,11 +946,35 @@ bool HttpHandler::isFileOpened() {
 int HttpHandler::sendFile() {
     if (!writer || !writer->isWriteComplete() ||
         !isFileOpened() ||
-        file->buf.len == 0 ||
+        (file->buf.len == 0 && file->chunk == 0) ||
         resp->content_length == 0) {
         return -1;
     }
 
+    if (file->chunk) {
+        size_t len = MIN(file->chunk, resp->content_length);
+        uint64_t offset = file->offset;
+        bool first = writer->state != HttpResponseWriter::SEND_BODY;
+        file->offset += len;
+        resp->content_length -= len;
+        // NOTE: write_cb may call sendFile recursively
+        int nwrite = writer->WriteBodyFile(fileno(file->fp), offset, len);
+        if (nwrite < 0) {
+            hloge("sendfile: %s error!", file->filepath);
+            error = ERR_READ_FILE;
+            writer->close(true);
+            return nwrite;
+        }
+        if (first) {
+            tcp_nopush(hio_fd(io), 0);
+        }
+        if (resp->content_length == 0 && isFileOpened()) {
+            writer->End();
+            closeFile();
+        }
+        return len;
+    }
+
     int readbytes = MIN(file->buf.len, resp->content_length);
     size_t nread = file->read(file->buf.base, readbytes);
     if (nread <= 0) {
@@ -8,6 +8,8 @@
 #include "WebSocketServer.h"
 #include "WebSocketParser.h"
 
+struct http_server_s;
+
 class HttpHandler {
 public:
     enum ProtocolType {
@@ -40,6 +42,7 @@ public:
     unsigned proxy_connected    :1;
     unsigned forward_proxy      :1;
     unsigned reverse_proxy      :1;
+    unsigned migrating          :1;
 
     // peeraddr
     char                    ip[64];
@@ -76,12 +79,19 @@ public:
     struct LargeFile : public HFile {
         HBuf        buf;
         uint64_t    timer;
+        // sendfile if chunk > 0
+        uint64_t    offset;
+        size_t      chunk;
     }                       *file;  // for large file
 
     // for proxy
     std::string             proxy_host;
     int                     proxy_port;
 
+    // for LB_UrlHash, data received while migrating to another loop
+    struct http_server_s    *server;
+    std::string             migrating_data;
+
     HttpHandler(hio_t* io = NULL);
     ~HttpHandler();
 
@@ -52,6 +52,14 @@ int HttpResponseWriter::WriteBody(const char* buf, int len /* = -1 */) {
     }
 }
 
+int HttpResponseWriter::WriteBodyFile(int fd, uint64_t offset, size_t len) {
+    if (state == SEND_BEGIN || response->IsChunked()) {
+        return -1;
+    }
+    state = SEND_BODY;
+    return sendFile(fd, offset, len);
+}
+
 int HttpResponseWriter::WriteResponse(HttpResponse* resp) {
     if (resp == NULL) {
         response->status_code = HTTP_STATUS_INTERNAL_SERVER_ERROR;
@@ -156,6 +164,9 @@ int HttpResponseWriter::ResponseFile(const char* path, HttpRequest* req, int spe
         return response->status_code;
     }
     else { // range with file cache
+        // sendfile if plaintext tcp or kernel TLS, cork headers with the first chunk of file
+        bool sendfile = hio_sendfile_supported(io());
+        if (sendfile) tcp_nopush(fd(), 1);
         // response header
         EndHeaders();
         state = SEND_BODY;
@@ -175,6 +186,7 @@ int HttpResponseWriter::ResponseFile(const char* path, HttpRequest* req, int spe
             };
         }
         writeFile(speed);
+        if (sendfile) tcp_nopush(fd(), 0);
         return 0;
     }
 }
@@ -189,6 +201,43 @@ void HttpResponseWriter::endFile() {
 void HttpResponseWriter::writeFile(int maxSize) {
     if (!file.isopen()) return;
 
+    // zero-copy: limited by maxSize per heartbeat, or 1M per writable event
+    if (!response->IsChunked() && hio_sendfile_supported(io())) {
+        while (response->content_length && maxSize) {
+            long offset = ftell(file.fp);
+            int len = 1 << 20;
+            if (len > response->content_length) len = response->content_length;
+            if (maxSize > 0 && len > maxSize) len = maxSize;
+
+            int n = sendFile(fileno(file.fp), offset, len);
+            if (n < 0) {
+                // network write error or file truncated
+                endFile();
+                break;
+            }
+            // NOTE: sendfile does not move file position
+            file.seek(offset + len);
+
+            response->content_length -= len;
+            if (maxSize > 0) {
+                maxSize -= len;
+                if (writeBufsize()) return;
+            }
+            else if (n != len) {
+                wait_writable = true;
+                return;
+            }
+        }
+        if (!response->content_length) {
+            endFile();
+            state = SEND_END;
+            if (!response->IsKeepAlive()) {
+                close(true);
+            }
+        }
+        return;
+    }
+
     char buf[4096];
     while (response->content_length && maxSize) {
         int len = sizeof(buf);
@@ -84,6 +84,9 @@ public:
         return WriteBody(str.c_str(), str.size());
     }
 
+    // NOTE: sendfile [offset, offset+len) of fd as body, -1 if not supported.
+    int WriteBodyFile(int fd, uint64_t offset, size_t len);
+
     int WriteResponse(HttpResponse* resp);
 
     int SSEvent(const std::string& data, const char* event = "message");
@@ -8,6 +8,8 @@
 #include "EventLoop.h"
 using namespace hv;
 
+#include "hconsistenthash.h"
+
 #include "HttpHandler.h"
 
 static void on_accept(hio_t* io);
@@ -20,13 +22,80 @@ struct HttpServerPrivdata {
     std::mutex                      mutex_;
     std::shared_ptr<HttpService>    service;
     FileCache                       filecache;
+    int                             nworkers; // worker index in this process
+    HConsistentHash                 ring; // index of loops, for LB_IpHash, LB_UrlHash
+
+    HttpServerPrivdata() : nworkers(0) {}
 };
 
+// @return the loop pinned by key, NULL if current loop or not started
+static EventLoopPtr hash_loop(http_server_t* server, const char* key, size_t keylen) {
+    HttpServerPrivdata* privdata = (HttpServerPrivdata*)server->privdata;
+    int idx = privdata->ring.getNode(key, keylen);
+    if (idx < 0) return NULL;
+    std::lock_guard<std::mutex> locker(privdata->mutex_);
+    if (idx >= (int)privdata->loops.size()) return NULL;
+    const EventLoopPtr& loop = privdata->loops[idx];
+    return loop.get() == currentThreadEventLoop ? NULL : loop;
+}
+
+// @return path of request-line without query, for LB_UrlHash
+static bool request_path(const char* data, size_t len, const char** path, size_t* pathlen) {
+    const char* end = data + len;
+    const char* p = (const char*)memchr(data, ' ', len);
+    if (p == NULL || ++p == end || *p != '/') return false;
+    const char* start = p;
+    while (p < end && *p != ' ' && *p != '?') ++p;
+    if (p == end) return false;
+    *path = start;
+    *pathlen = p - start;
+    return true;
+}
+
+static bool is_request_begin(HttpHandler* handler) {
+    if (handler->protocol == HttpHandler::UNKNOWN) return true;
+    return handler->protocol == HttpHandler::HTTP_V1 &&
+           handler->state == HttpHandler::WANT_RECV &&
+           handler->parser->GetState() == HP_START_REQ_OR_RES;
+}
+
+static void on_migrated(hio_t* io, void* userdata) {
+    EventLoop* prev_loop = (EventLoop*)userdata;
+    --prev_loop->connectionNum;
+    ++currentThreadEventLoop->connectionNum;
+    HttpHandler* handler = (HttpHandler*)hevent_userdata(io);
+    if (handler == NULL) return;
+    handler->migrating = 0;
+    handler->tid = hv_gettid();
+    std::string data;
+    data.swap(handler->migrating_data);
+    on_recv(io, (void*)data.data(), data.size());
+}
+
 static void on_recv(hio_t* io, void* buf, int readbytes) {
     // printf("on_recv fd=%d readbytes=%d\n", hio_fd(io), readbytes);
     HttpHandler* handler = (HttpHandler*)hevent_userdata(io);
     assert(handler != NULL);
 
+    if (handler->migrating) {
+        // NOTE: more data read before detached, fed after migrated
+        handler->migrating_data.append((const char*)buf, readbytes);
+        return;
+    }
+    http_server_t* server = handler->server;
+    if (server && server->load_balance == LB_UrlHash && is_request_begin(handler)) {
+        const char* path = NULL;
+        size_t pathlen = 0;
+        if (request_path((const char*)buf, readbytes, &path, &pathlen)) {
+            EventLoopPtr worker_loop = hash_loop(server, path, pathlen);
+            if (worker_loop && hio_migrate(io, worker_loop->loop(), on_migrated, currentThreadEventLoop) == 0) {
+                handler->migrating = 1;
+                handler->migrating_data.assign((const char*)buf, readbytes);
+                return;
+            }
+        }
+    }
+
     int nfeed = handler->FeedRecvData((const char*)buf, readbytes);
     if (nfeed != readbytes) {
         hio_close(io);
@@ -59,6 +128,21 @@ static void on_accept(hio_t* io) {
             SOCKADDR_STR(hio_peeraddr(io), peeraddrstr));
     */
 
+    if (server->load_balance == LB_IpHash) {
+        char ip[SOCKADDR_STRLEN] = {0};
+        sockaddr_ip((sockaddr_u*)hio_peeraddr(io), ip, sizeof(ip));
+        EventLoopPtr worker_loop = hash_loop(server, ip, strlen(ip));
+        if (worker_loop) {
+            // NOTE: detach from this loop, accepted again in the pinned loop
+            hio_detach(io);
+            worker_loop->runInLoop([io]() {
+                hio_attach(currentThreadEventLoop->loop(), io);
+                on_accept(io);
+            });
+            return;
+        }
+    }
+
     EventLoop* loop = currentThreadEventLoop;
     if (loop->connectionNum >= server->worker_connections) {
         hlogw("over worker_connections");
@@ -89,23 +173,55 @@ static void on_accept(hio_t* io) {
     // FileCache
     HttpServerPrivdata* privdata = (HttpServerPrivdata*)server->privdata;
     handler->files = &privdata->filecache;
+    handler->server = server;
     hevent_set_userdata(io, handler);
 }
 
+// NOTE: The first loop accepts on listenfd of http_server_run, others listen on their own.
+// The order of bind is the order of loops, @see so_reuseport_steer_by_cpu
+static void reuseport_listen(http_server_t* server, int idx, int listenfd[2]) {
+    if (idx == 0) return;
+    int ports[2] = { server->port, server->https_port };
+    for (int i = 0; i < 2; ++i) {
+        if (listenfd[i] < 0) continue;
+        int fd = ListenReusePort(ports[i], server->host);
+        if (fd < 0) {
+            hlogw("ListenReusePort %s:%d return %d, share listenfd!", server->host, ports[i], fd);
+            continue;
+        }
+        listenfd[i] = fd;
+    }
+}
+
 static void loop_thread(void* userdata) {
     http_server_t* server = (http_server_t*)userdata;
     HttpService* service = server->service;
+    HttpServerPrivdata* privdata = (HttpServerPrivdata*)server->privdata;
+
+    int listenfd[2] = { server->listenfd[0], server->listenfd[1] };
+    {
+        std::lock_guard<std::mutex> locker(privdata->mutex_);
+        int idx = privdata->nworkers++;
+        // NOTE: bind before creating loop, so memory of loop is node local.
+        // worker_processes are bound by master_workers_run.
+        if (!server->worker_processes && server->cpu_affinity.policy != CPU_AFFINITY_NONE) {
+            cpu_affinity_apply(&server->cpu_affinity, idx);
+        }
+        if (server->reuseport) {
+            reuseport_listen(server, idx, listenfd);
+        }
+    }
 
     auto loop = std::make_shared<EventLoop>();
     hloop_t* hloop = loop->loop();
     // http
-    if (server->listenfd[0] >= 0) {
-        hio_t* listenio = haccept(hloop, server->listenfd[0], on_accept);
+    if (listenfd[0] >= 0) {
+        hio_t* listenio = haccept(hloop, listenfd[0], on_accept);
         hevent_set_userdata(listenio, server);
     }
     // https
-    if (server->listenfd[1] >= 0) {
-        hio_t* listenio = haccept(hloop, server->listenfd[1], on_accept);
+    if (listenfd[1] >= 0) {
+        hio_t* listenio = haccept(hloop, listenfd[1], on_accept);
         hevent_set_userdata(listenio, server);
         hio_enable_ssl(listenio);
         if (server->ssl_ctx) {
@@ -113,7 +229,6 @@ static void loop_thread(void* userdata) {
         }
     }
 
-    HttpServerPrivdata* privdata = (HttpServerPrivdata*)server->privdata;
     privdata->mutex_.lock();
     if (privdata->loops.size() == 0) {
         // NOTE: fsync logfile when idle
@@ -180,13 +295,13 @@ int http_server_run(http_server_t* server, int wait) {
     // http_port
     if (server->port > 0) {
         if (server->listenfd[0] < 0)
-            server->listenfd[0] = Listen(server->port, server->host);
+            server->listenfd[0] = server->reuseport ? ListenReusePort(server->port, server->host) : Listen(server->port, server->host);
         if (server->listenfd[0] < 0) return server->listenfd[0];
         hlogi("http server listening on %s:%d", server->host, server->port);
     }
     // https_port
     if (server->https_port > 0 && HV_WITH_SSL) {
-        server->listenfd[1] = Listen(server->https_port, server->host);
+        server->listenfd[1] = server->reuseport ? ListenReusePort(server->https_port, server->host) : Listen(server->https_port, server->host);
         if (server->listenfd[1] < 0) return server->listenfd[1];
         hlogi("https server listening on %s:%d", server->host, server->https_port);
     }
@@ -207,20 +322,46 @@ int http_server_run(http_server_t* server, int wait) {
 #endif
     }
 
+    if (server->reuseport && server->reuseport_steer_by_cpu && server->worker_processes) {
+        // NOTE: worker_processes bind in the order they are scheduled,
+        // so the index in reuseport group is not the index of loop pinned to cpu.
+        hlogw("reuseport_steer_by_cpu is not supported with worker_processes, fallback to hash!");
+    }
+    else if (server->reuseport && server->reuseport_steer_by_cpu) {
+        int nloops = server->worker_threads > 0 ? server->worker_threads : 1;
+        for (int i = 0; i < 2; ++i) {
+            if (server->listenfd[i] < 0) continue;
+            if (so_reuseport_steer_by_cpu(server->listenfd[i], nloops) != 0) {
+                hlogw("so_reuseport_steer_by_cpu failed, fallback to hash!");
+            }
+        }
+    }
+
     HttpServerPrivdata* privdata = new HttpServerPrivdata;
     server->privdata = privdata;
     if (server->service == NULL) {
         privdata->service = std::make_shared<HttpService>();
         server->service = privdata->service.get();
     }
+    if (server->load_balance == LB_IpHash || server->load_balance == LB_UrlHash) {
+        // NOTE: node is the index of privdata->loops, so resizing worker_threads moves minimal keys.
+        int nthreads = server->worker_threads > 0 ? server->worker_threads : 1;
+        for (int i = 0; i < nthreads; ++i) {
+            privdata->ring.addNode(i);
+        }
+    }
 
     if (server->worker_processes) {
         // multi-processes
+        g_main_ctx.worker_cpu_affinity = server->cpu_affinity;
         return master_workers_run(loop_thread, server, server->worker_processes, server->worker_threads, wait);
     }
     else {
         // multi-threads
         if (server->worker_threads == 0) server->worker_threads = 1;
+        if (server->cpu_affinity.policy != CPU_AFFINITY_NONE) {
+            cpu_affinity_report(&server->cpu_affinity, server->worker_threads);
+        }
         for (int i = wait ? 1 : 0; i < server->worker_threads; ++i) {
 #ifdef OS_WIN
             hthread_t thrd = hthread_create((hthread_routine)loop_thread_stdcall, server);
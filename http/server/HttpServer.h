@@ -3,6 +3,7 @@
 
 #include "hexport.h"
 #include "hssl.h"
+#include "hsysinfo.h"
 // #include "EventLoop.h"
 #include "HttpService.h"
 // #include "WebSocketServer.h"
@@ -32,6 +33,14 @@ typedef struct http_server_s {
     // SSL/TLS
     hssl_ctx_t  ssl_ctx;
     unsigned    alloced_ssl_ctx: 1;
+    // SO_REUSEPORT: one listener per worker loop
+    unsigned    reuseport: 1;
+    unsigned    reuseport_steer_by_cpu: 1;
+    // bind worker loops to cpus
+    cpu_affinity_t cpu_affinity;
+    // LB_IpHash, LB_UrlHash: pin the same client ip or url path to the same worker loop,
+    // others: connections are accepted by any worker loop.
+    load_balance_e load_balance;
 
 #ifdef __cplusplus
     http_server_s() {
@@ -53,6 +62,10 @@ typedef struct http_server_s {
         // SSL/TLS
         ssl_ctx = NULL;
         alloced_ssl_ctx = 0;
+        reuseport = 0;
+        reuseport_steer_by_cpu = 0;
+        memset(&cpu_affinity, 0, sizeof(cpu_affinity));
+        load_balance = LB_RoundRobin;
     }
 #endif
 } http_server_t;
@@ -111,7 +124,7 @@ public:
         if (ssl_fd >= 0) this->listenfd[1] = ssl_fd;
     }
     int bindHttp(int port) {
-      int fd = Listen(port, host);
+      int fd = reuseport ? ListenReusePort(port, host) : Listen(port, host);
       if (fd < 0) return fd;
       if (!port) {
         sockaddr_u addr;
@@ -126,7 +139,7 @@ public:
       return fd;
     }
     int bindHttps(int port) {
-      int fd = Listen(port, host);
+      int fd = reuseport ? ListenReusePort(port, host) : Listen(port, host);
       if (fd < 0) return fd;
       if (!port) {
         sockaddr_u addr;
@@ -148,6 +161,30 @@ public:
         this->worker_threads = num;
     }
 
+    // NOTE: SO_REUSEPORT: each worker loop listens on its own socket instead of sharing one,
+    // kernel distributes connections between them.
+    // @param steer_by_cpu: @see so_reuseport_steer_by_cpu, multi-threads only,
+    // ignored with worker_processes because the bind order of processes is not deterministic.
+    // NOTE: call before bindHttp/bindHttps/run.
+    void setReusePort(bool on = true, bool steer_by_cpu = false) {
+        this->reuseport = on;
+        this->reuseport_steer_by_cpu = on && steer_by_cpu;
+    }
+
+    // worker[i] = worker_processes[i / worker_threads] worker_threads[i % worker_threads]
+    // @param affinity: "compact", "scatter", "node", "0-3,8", @see cpu_affinity_select
+    int setCpuAffinity(const char* affinity) {
+        return cpu_affinity_parse(&this->cpu_affinity, affinity);
+    }
+
+    // LB_IpHash: connection is handed to the loop of its peer ip when accepted.
+    // LB_UrlHash: connection is migrated to the loop of the url path before each request,
+    // so that per-loop caches get high hit rates, @see hio_migrate
+    // NOTE: pinned within one process, consistent hashing on worker_threads.
+    void setLoadBalance(load_balance_e lb) {
+        this->load_balance = lb;
+    }
+
     void setMaxWorkerConnectionNum(uint32_t num) {
         this->worker_connections = num;
     }
@@ -0,0 +1,228 @@
+#ifndef HV_ATOMIC_H_
+#define HV_ATOMIC_H_
+
+#ifdef __cplusplus
+
+// c++11
+#include <atomic>
+
+using std::atomic_flag;
+using std::atomic_long;
+
+#define ATOMIC_FLAG_TEST_AND_SET(p)     ((p)->test_and_set())
+#define ATOMIC_FLAG_CLEAR(p)            ((p)->clear())
+
+#else
+
+#include "hplatform.h"  // for HAVE_STDATOMIC_H
+#if HAVE_STDATOMIC_H
+
+// c11
+#include <stdatomic.h>
+
+#define ATOMIC_FLAG_TEST_AND_SET    atomic_flag_test_and_set
+#define ATOMIC_FLAG_CLEAR           atomic_flag_clear
+#define ATOMIC_ADD                  atomic_fetch_add
+#define ATOMIC_SUB                  atomic_fetch_sub
+#define ATOMIC_INC(p)               ATOMIC_ADD(p, 1)
+#define ATOMIC_DEC(p)               ATOMIC_SUB(p, 1)
+
+#else
+
+typedef volatile bool               atomic_bool;
+typedef volatile char               atomic_char;
+typedef volatile unsigned char      atomic_uchar;
+typedef volatile short              atomic_short;
+typedef volatile unsigned short     atomic_ushort;
+typedef volatile int                atomic_int;
+typedef volatile unsigned int       atomic_uint;
+typedef volatile long               atomic_long;
+typedef volatile unsigned long      atomic_ulong;
+typedef volatile long long          atomic_llong;
+typedef volatile unsigned long long atomic_ullong;
+typedef volatile size_t             atomic_size_t;
+
+typedef struct atomic_flag { atomic_long _Value; } atomic_flag;
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+
+#define ATOMIC_FLAG_TEST_AND_SET    atomic_flag_test_and_set
+static inline bool atomic_flag_test_and_set(atomic_flag* p) {
+    return !__sync_bool_compare_and_swap(&p->_Value, 0, 1);
+}
+
+#define ATOMIC_ADD          __sync_fetch_and_add
+#define ATOMIC_SUB          __sync_fetch_and_sub
+#define ATOMIC_INC(p)       ATOMIC_ADD(p, 1)
+#define ATOMIC_DEC(p)       ATOMIC_SUB(p, 1)
+
+#elif defined(_WIN32)
+
+#define ATOMIC_FLAG_TEST_AND_SET    atomic_flag_test_and_set
+static inline bool atomic_flag_test_and_set(atomic_flag* p) {
+    // return InterlockedIncrement((LONG*)&p->_Value, 1);
+    return InterlockedCompareExchange(&p->_Value, 1, 0);
+}
+
+#define ATOMIC_ADD          InterlockedExchangeAdd
+#define ATOMIC_SUB(p, n)    InterlockedExchangeAdd(p, -(n))
+#define ATOMIC_INC(p)       InterlockedExchangeAdd(p, 1)
+#define ATOMIC_DEC(p)       InterlockedExchangeAdd(p, -1)
+
+#endif
+
+#endif // HAVE_STDATOMIC_H
+
+#endif // __cplusplus
+
+#ifndef ATOMIC_FLAG_INIT
+#define ATOMIC_FLAG_INIT        { 0 }
+#endif
+
+#ifndef ATOMIC_VAR_INIT
+#define ATOMIC_VAR_INIT(value)  (value)
+#endif
+
+#ifndef ATOMIC_FLAG_TEST_AND_SET
+#define ATOMIC_FLAG_TEST_AND_SET    atomic_flag_test_and_set
+static inline bool atomic_flag_test_and_set(atomic_flag* p) {
+    bool ret = p->_Value;
+    p->_Value = 1;
+    return ret;
+}
+#endif
+
+#ifndef ATOMIC_FLAG_CLEAR
+#define ATOMIC_FLAG_CLEAR           atomic_flag_clear
+static inline void atomic_flag_clear(atomic_flag* p) {
+    p->_Value = 0;
+}
+#endif
+
+#ifndef ATOMIC_ADD
+#define ATOMIC_ADD(p, n)    (*(p) += (n))
+#endif
+
+#ifndef ATOMIC_SUB
+#define ATOMIC_SUB(p, n)    (*(p) -= (n))
+#endif
+
+#ifndef ATOMIC_INC
+#define ATOMIC_INC(p)       ((*(p))++)
+#endif
+
+#ifndef ATOMIC_DEC
+#define ATOMIC_DEC(p)       ((*(p))--)
+#endif
+
+typedef atomic_flag                 hatomic_flag_t;
+#define HATOMIC_FLAG_INIT           ATOMIC_FLAG_INIT
+#define hatomic_flag_test_and_set   ATOMIC_FLAG_TEST_AND_SET
+#define hatomic_flag_clear          ATOMIC_FLAG_CLEAR
+
+typedef atomic_long                 hatomic_t;
+#define HATOMIC_VAR_INIT            ATOMIC_VAR_INIT
+#define hatomic_add                 ATOMIC_ADD
+#define hatomic_sub                 ATOMIC_SUB
+#define hatomic_inc                 ATOMIC_INC
+#define hatomic_dec                 ATOMIC_DEC
+
+// NOTE: sequentially consistent ops on plain variables, for lock-free structures.
+#include "hplatform.h"
+#if defined(__GNUC__) || defined(__clang__)
+static inline void* hatomic_ptr_load(void* volatile* p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static inline void hatomic_ptr_store(void* volatile* p, void* v) {
+    __atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+}
+static inline void* hatomic_ptr_exchange(void* volatile* p, void* v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+// @return true if *p == expected and *p = desired
+static inline bool hatomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static inline long hatomic_long_exchange(volatile long* p, long v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+// @return old value
+static inline long hatomic_long_add(volatile long* p, long v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+}
+#elif defined(_WIN32)
+static inline void* hatomic_ptr_load(void* volatile* p) {
+    return InterlockedCompareExchangePointer(p, NULL, NULL);
+}
+static inline void hatomic_ptr_store(void* volatile* p, void* v) {
+    InterlockedExchangePointer(p, v);
+}
+static inline void* hatomic_ptr_exchange(void* volatile* p, void* v) {
+    return InterlockedExchangePointer(p, v);
+}
+static inline bool hatomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    return InterlockedCompareExchangePointer(p, desired, expected) == expected;
+}
+static inline long hatomic_long_exchange(volatile long* p, long v) {
+    return InterlockedExchange((volatile LONG*)p, v);
+}
+static inline long hatomic_long_add(volatile long* p, long v) {
+    return InterlockedExchangeAdd((volatile LONG*)p, v);
+}
+#else
+static inline void* hatomic_ptr_load(void* volatile* p) {
+    return *p;
+}
+static inline void hatomic_ptr_store(void* volatile* p, void* v) {
+    *p = v;
+}
+static inline void* hatomic_ptr_exchange(void* volatile* p, void* v) {
+    void* old = *p;
+    *p = v;
+    return old;
+}
+static inline bool hatomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    if (*p != expected) return false;
+    *p = desired;
+    return true;
+}
+static inline long hatomic_long_exchange(volatile long* p, long v) {
+    long old = *p;
+    *p = v;
+    return old;
+}
+static inline long hatomic_long_add(volatile long* p, long v) {
+    long old = *p;
+    *p += v;
+    return old;
+}
+#endif
+
+// NOTE: ops on plain integers written by one thread and read by others,
+// relaxed ones are atomic but not ordered, pair with fences for a seqlock.
+#if defined(__GNUC__) || defined(__clang__)
+#define hatomic_load_relaxed(p)         __atomic_load_n(p, __ATOMIC_RELAXED)
+#define hatomic_load_acquire(p)         __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define hatomic_store_relaxed(p, v)     __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define hatomic_store_release(p, v)     __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define hatomic_fence_acquire()         __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define hatomic_fence_release()         __atomic_thread_fence(__ATOMIC_RELEASE)
+#elif defined(_WIN32)
+#define hatomic_load_relaxed(p)         (*(p))
+#define hatomic_load_acquire(p)         (*(p))
+#define hatomic_store_relaxed(p, v)     (*(p) = (v))
+#define hatomic_store_release(p, v)     (*(p) = (v))
+#define hatomic_fence_acquire()         MemoryBarrier()
+#define hatomic_fence_release()         MemoryBarrier()
+#else
+#define hatomic_load_relaxed(p)         (*(p))
+#define hatomic_load_acquire(p)         (*(p))
+#define hatomic_store_relaxed(p, v)     (*(p) = (v))
+#define hatomic_store_release(p, v)     (*(p) = (v))
+#define hatomic_fence_acquire()
+#define hatomic_fence_release()
+#endif
+// only by the writer thread
+#define hatomic_add_relaxed(p, n)       hatomic_store_relaxed(p, *(p) + (n))
+
+#endif // HV_ATOMIC_H_
@@ -0,0 +1,102 @@
+#ifndef HV_CONSISTENT_HASH_H_
+#define HV_CONSISTENT_HASH_H_
+
+/*
+ * @usage unittest/consistenthash_test.cpp
+ *
+ * Consistent hashing ring with virtual nodes, maps key to node.
+ * Positions of virtual nodes only depend on node id, so when a node added or removed,
+ * only about 1/N of keys are moved, others stay on the same node.
+ * NOTE: getNode is thread-safe if no addNode/removeNode concurrently.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#define DEFAULT_CONSISTENT_HASH_VNODES  160
+
+class HConsistentHash {
+public:
+    // FNV-1a, then fmix32 of murmur3 to spread similar keys, such as ip and path.
+    static uint32_t hash(const void* key, size_t len) {
+        const unsigned char* p = (const unsigned char*)key;
+        uint32_t h = 2166136261U;
+        for (size_t i = 0; i < len; ++i) {
+            h ^= p[i];
+            h *= 16777619U;
+        }
+        h ^= h >> 16;
+        h *= 0x85ebca6bU;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35U;
+        h ^= h >> 16;
+        return h;
+    }
+
+    HConsistentHash(int vnodes = DEFAULT_CONSISTENT_HASH_VNODES)
+        : vnodes_(vnodes > 0 ? vnodes : DEFAULT_CONSISTENT_HASH_VNODES) {}
+
+    void addNode(int node) {
+        if (hasNode(node)) return;
+        nodes_.push_back(node);
+        for (int i = 0; i < vnodes_; ++i) {
+            int32_t vnode[2] = { node, i };
+            ring_.push_back(VNode(hash(vnode, sizeof(vnode)), node));
+        }
+        std::sort(ring_.begin(), ring_.end());
+    }
+
+    void removeNode(int node) {
+        auto iter = std::find(nodes_.begin(), nodes_.end(), node);
+        if (iter == nodes_.end()) return;
+        nodes_.erase(iter);
+        ring_.erase(std::remove_if(ring_.begin(), ring_.end(), [node](const VNode& vnode) {
+            return vnode.node == node;
+        }), ring_.end());
+    }
+
+    bool hasNode(int node) const {
+        return std::find(nodes_.begin(), nodes_.end(), node) != nodes_.end();
+    }
+
+    void clear() {
+        nodes_.clear();
+        ring_.clear();
+    }
+
+    int nodeNum() const {
+        return nodes_.size();
+    }
+
+    // @return node, -1 if empty
+    int getNode(const void* key, size_t len) const {
+        if (ring_.empty()) return -1;
+        // the first vnode clockwise
+        auto iter = std::lower_bound(ring_.begin(), ring_.end(), VNode(hash(key, len), -1));
+        if (iter == ring_.end()) iter = ring_.begin();
+        return iter->node;
+    }
+
+    int getNode(const std::string& key) const {
+        return getNode(key.data(), key.size());
+    }
+
+private:
+    struct VNode {
+        uint32_t    hash;
+        int         node;
+        VNode(uint32_t hash, int node) : hash(hash), node(node) {}
+        bool operator<(const VNode& rhs) const {
+            // NOTE: compare node if hash collision, make order irrelevant to addNode.
+            return hash < rhs.hash || (hash == rhs.hash && node < rhs.node);
+        }
+    };
+    int                 vnodes_;
+    std::vector<int>    nodes_;
+    std::vector<VNode>  ring_; // sorted by hash
+};
+
+#endif // HV_CONSISTENT_HASH_H_
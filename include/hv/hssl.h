@@ -0,0 +1,121 @@
+#ifndef HV_SSL_H_
+#define HV_SSL_H_
+
+#include "hexport.h"
+
+#include "hplatform.h"
+#if !defined(WITH_OPENSSL) &&   \
+    !defined(WITH_GNUTLS)  &&   \
+    !defined(WITH_MBEDTLS)
+#ifdef OS_WIN
+    #define WITH_WINTLS
+    #ifdef _MSC_VER
+        #pragma comment(lib, "secur32.lib")
+        #pragma comment(lib, "crypt32.lib")
+    #endif
+#elif defined(OS_DARWIN)
+    #define WITH_APPLETLS
+#else
+    #define HV_WITHOUT_SSL
+#endif
+#endif
+
+typedef void* hssl_ctx_t;   ///> SSL_CTX
+typedef void* hssl_t;       ///> SSL
+
+enum {
+    HSSL_SERVER = 0,
+    HSSL_CLIENT = 1,
+};
+
+enum {
+    HSSL_OK = 0,
+    HSSL_ERROR = -1,
+    HSSL_WANT_READ = -2,
+    HSSL_WANT_WRITE = -3,
+    HSSL_WOULD_BLOCK = -4,
+};
+
+// kernel TLS offload engaged, @see hssl_get_ktls
+enum {
+    HSSL_KTLS_TX = 0x01,
+    HSSL_KTLS_RX = 0x02,
+};
+
+typedef struct {
+    const char* crt_file;
+    const char* key_file;
+    const char* ca_file;
+    const char* ca_path;
+    short       verify_peer;
+    short       endpoint; // HSSL_SERVER / HSSL_CLIENT
+    short       ktls;     // opt-in kernel TLS offload, openssl only, @see hssl_get_ktls
+    // session resumption, openssl only
+    int         session_cache_size; // server side session cache, 0: default, <0: disabled
+    int         session_timeout;    // seconds, 0: default
+    // stateless session tickets, keys derived from ticket_secret and rotated every ticket_rotate_s,
+    // the previous keys still decrypt and renew tickets, so a ticket lives up to 2*ticket_rotate_s.
+    // 0: openssl default keys, never rotated, <0: tickets disabled
+    int         ticket_rotate_s;
+    // NULL: random secret, shared by threads and by worker processes forked after hssl_ctx_new,
+    // set the same secret to share ticket keys across hosts.
+    const char* ticket_secret;
+} hssl_ctx_opt_t, hssl_ctx_init_param_t;
+
+BEGIN_EXTERN_C
+
+/*
+const char* hssl_backend() {
+#ifdef WITH_OPENSSL
+    return "openssl";
+#elif defined(WITH_GNUTLS)
+    return "gnutls";
+#elif defined(WITH_MBEDTLS)
+    return "mbedtls";
+#else
+    return "nossl";
+#endif
+}
+*/
+HV_EXPORT const char* hssl_backend();
+#define HV_WITH_SSL (strcmp(hssl_backend(), "nossl") != 0)
+
+HV_EXPORT extern hssl_ctx_t g_ssl_ctx;
+HV_EXPORT hssl_ctx_t hssl_ctx_init(hssl_ctx_init_param_t* param);
+HV_EXPORT void hssl_ctx_cleanup(hssl_ctx_t ssl_ctx);
+HV_EXPORT hssl_ctx_t hssl_ctx_instance();
+
+// NOTE: opt NULL for a client context with defaults
+HV_EXPORT hssl_ctx_t hssl_ctx_new(hssl_ctx_opt_t* opt);
+HV_EXPORT void hssl_ctx_free(hssl_ctx_t ssl_ctx);
+
+HV_EXPORT hssl_t hssl_new(hssl_ctx_t ssl_ctx, int fd);
+HV_EXPORT void hssl_free(hssl_t ssl);
+
+HV_EXPORT int hssl_accept(hssl_t ssl);
+HV_EXPORT int hssl_connect(hssl_t ssl);
+HV_EXPORT int hssl_read(hssl_t ssl, void* buf, int len);
+HV_EXPORT int hssl_write(hssl_t ssl, const void* buf, int len);
+HV_EXPORT int hssl_close(hssl_t ssl);
+
+HV_EXPORT int hssl_set_sni_hostname(hssl_t ssl, const char* hostname);
+
+// client session resumption: sessions are cached by peer such as "host:port", shared by all contexts,
+// call before hssl_connect, new sessions of this connection are cached for peer.
+// @return 1 if cached session set, 0 if not cached, -1 if not supported.
+HV_EXPORT int hssl_reuse_session(hssl_t ssl, const char* peer);
+// @return 1 if session resumed (abbreviated handshake), 0 if full handshake
+HV_EXPORT int hssl_session_reused(hssl_t ssl);
+
+// NOTE: kernel owns the record layer if offload engaged after handshake,
+// plaintext could be written to fd directly, such as sendfile.
+// @return HSSL_KTLS_TX | HSSL_KTLS_RX, 0 if not engaged or not supported.
+HV_EXPORT int hssl_get_ktls(hssl_t ssl);
+
+#ifdef WITH_OPENSSL
+HV_EXPORT int hssl_ctx_set_alpn_protos(hssl_ctx_t ssl_ctx, const unsigned char* protos, unsigned int protos_len);
+#endif
+
+END_EXTERN_C
+
+#endif // HV_SSL_H_
@@ -0,0 +1,124 @@
+#ifndef HV_SYS_INFO_H_
+#define HV_SYS_INFO_H_
+
+#include "hexport.h"
+#include "hplatform.h"
+
+#ifdef OS_LINUX
+#include <sys/sysinfo.h>
+#endif
+
+#ifdef OS_DARWIN
+#include <mach/mach_host.h>
+#include <sys/sysctl.h>
+#endif
+
+static inline int get_ncpu() {
+#ifdef OS_WIN
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors;
+#else
+    //return get_nprocs();
+    //return get_nprocs_conf();
+    //return sysconf(_SC_NPROCESSORS_ONLN);     // processors available
+    return sysconf(_SC_NPROCESSORS_CONF);     // processors configured
+#endif
+}
+
+typedef struct meminfo_s {
+    unsigned long total;    // KB
+    unsigned long free;     // KB
+} meminfo_t;
+
+static inline int get_meminfo(meminfo_t* mem) {
+#ifdef OS_WIN
+    MEMORYSTATUSEX memstat;
+    memset(&memstat, 0, sizeof(memstat));
+    memstat.dwLength = sizeof(memstat);
+    GlobalMemoryStatusEx(&memstat);
+    mem->total = (unsigned long)(memstat.ullTotalPhys >> 10);
+    mem->free = (unsigned long)(memstat.ullAvailPhys >> 10);
+    return 0;
+#elif defined(OS_LINUX)
+    struct sysinfo info;
+    if (sysinfo(&info) < 0) {
+        return errno;
+    }
+    mem->total = info.totalram * info.mem_unit >> 10;
+    mem->free = info.freeram * info.mem_unit >> 10;
+    return 0;
+#elif defined(OS_DARWIN)
+    uint64_t memsize = 0;
+    size_t size = sizeof(memsize);
+    int which[2] = {CTL_HW, HW_MEMSIZE};
+    sysctl(which, 2, &memsize, &size, NULL, 0);
+    mem->total = memsize >> 10;
+
+    vm_statistics_data_t info;
+    mach_msg_type_number_t count = sizeof(info) / sizeof(integer_t);
+    host_statistics(mach_host_self(), HOST_VM_INFO, (host_info_t)&info, &count);
+    mem->free = ((uint64_t)info.free_count * sysconf(_SC_PAGESIZE)) >> 10;
+    return 0;
+#else
+    (void)(mem);
+    return -10;
+#endif
+}
+
+//-----------------------------cpu topology------------------------------------
+BEGIN_EXTERN_C
+
+#define HV_MAX_CPUS     1024
+
+// @return numa nodes, 1 if unknown
+HV_EXPORT int get_nnode();
+// @return numa node of cpu, 0 if unknown
+HV_EXPORT int get_cpu_node(int cpu);
+// @return cpu of current thread, -1 if unknown
+HV_EXPORT int get_current_cpu();
+// online cpus allowed to this process
+// @return ncpus
+HV_EXPORT int get_allowed_cpus(int* cpus, int maxcpus);
+
+// "0-3,8,10-11" => [0,1,2,3,8,10,11]
+// @return ncpus, <0 if invalid
+HV_EXPORT int cpulist_parse(const char* str, int* cpus, int maxcpus);
+// [0,1,2,3,8] => "0-3,8"
+HV_EXPORT char* cpulist_dump(const int* cpus, int ncpus, char* buf, int len);
+
+// bind current thread to cpus
+// @return 0 on success, -1 if failed or not supported
+HV_EXPORT int hv_setaffinity(const int* cpus, int ncpus);
+
+typedef enum {
+    CPU_AFFINITY_NONE = 0,
+    CPU_AFFINITY_COMPACT,   // worker[i] => i-th cpu ordered by node, fill node by node
+    CPU_AFFINITY_SCATTER,   // worker[i] => a cpu of node[i % nnode], spread across nodes
+    CPU_AFFINITY_NODE,      // worker[i] => all cpus of node[i % nnode]
+    CPU_AFFINITY_CPULIST,   // worker[i] => cpulist[i % ncpus]
+} cpu_affinity_e;
+
+typedef struct cpu_affinity_s {
+    cpu_affinity_e  policy;
+    char            cpulist[256]; // for CPU_AFFINITY_CPULIST
+} cpu_affinity_t;
+
+// "none", "compact", "scatter", "node", "0-3,8"
+// @return 0 on success
+HV_EXPORT int cpu_affinity_parse(cpu_affinity_t* affinity, const char* str);
+HV_EXPORT const char* cpu_affinity_str(const cpu_affinity_t* affinity);
+// cpus of worker[idx]
+// @return ncpus, 0 if CPU_AFFINITY_NONE
+HV_EXPORT int cpu_affinity_select(const cpu_affinity_t* affinity, int idx, int* cpus, int maxcpus);
+// cpu_affinity_select -> hv_setaffinity
+// NOTE: call it at the beginning of worker thread, before allocating per-thread memory,
+// then the memory will be allocated on the node of the worker on first touch.
+// @return numa node of worker[idx], -1 if not bound
+HV_EXPORT int cpu_affinity_apply(const cpu_affinity_t* affinity, int idx);
+// log cpu topology and the cpus of nworkers
+HV_EXPORT void cpu_affinity_report(const cpu_affinity_t* affinity, int nworkers);
+
+END_EXTERN_C
+
+#endif // HV_SYS_INFO_H_
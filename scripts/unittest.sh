@@ -29,3 +29,14 @@ bin/socketpair_test
 # bin/threadpool_test
 # bin/objectpool_test
 bin/sizeof_test
+bin/write_owned_test
+bin/ssl_et_test
+bin/ktls_test
+bin/ssl_resume_test
+bin/zerocopy_test
+bin/mirror_readbuf_test
+bin/unpack_test
+bin/upstream_water_test
+bin/timer_wheel_test
+bin/sendfile_test
+bin/TcpServerRebalance_test 3
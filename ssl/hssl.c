@@ -22,3 +22,17 @@ hssl_ctx_t hssl_ctx_instance() {
     }
     return g_ssl_ctx;
 }
+
+#ifndef WITH_OPENSSL
+int hssl_reuse_session(hssl_t ssl, const char* peer) {
+    return -1;
+}
+
+int hssl_session_reused(hssl_t ssl) {
+    return 0;
+}
+
+int hssl_get_ktls(hssl_t ssl) {
+    return 0;
+}
+#endif
@@ -36,6 +36,12 @@ enum {
     HSSL_WOULD_BLOCK = -4,
 };
 
+// kernel TLS offload engaged, @see hssl_get_ktls
+enum {
+    HSSL_KTLS_TX = 0x01,
+    HSSL_KTLS_RX = 0x02,
+};
+
 typedef struct {
     const char* crt_file;
     const char* key_file;
@@ -43,6 +49,17 @@ typedef struct {
     const char* ca_path;
     short       verify_peer;
     short       endpoint; // HSSL_SERVER / HSSL_CLIENT
+    short       ktls;     // opt-in kernel TLS offload, openssl only, @see hssl_get_ktls
+    // session resumption, openssl only
+    int         session_cache_size; // server side session cache, 0: default, <0: disabled
+    int         session_timeout;    // seconds, 0: default
+    // stateless session tickets, keys derived from ticket_secret and rotated every ticket_rotate_s,
+    // the previous keys still decrypt and renew tickets, so a ticket lives up to 2*ticket_rotate_s.
+    // 0: openssl default keys, never rotated, <0: tickets disabled
+    int         ticket_rotate_s;
+    // NULL: random secret, shared by threads and by worker processes forked after hssl_ctx_new,
+    // set the same secret to share ticket keys across hosts.
+    const char* ticket_secret;
 } hssl_ctx_opt_t, hssl_ctx_init_param_t;
 
 BEGIN_EXTERN_C
@@ -68,6 +85,7 @@ HV_EXPORT hssl_ctx_t hssl_ctx_init(hssl_ctx_init_param_t* param);
 HV_EXPORT void hssl_ctx_cleanup(hssl_ctx_t ssl_ctx);
 HV_EXPORT hssl_ctx_t hssl_ctx_instance();
 
+// NOTE: opt NULL for a client context with defaults
 HV_EXPORT hssl_ctx_t hssl_ctx_new(hssl_ctx_opt_t* opt);
 HV_EXPORT void hssl_ctx_free(hssl_ctx_t ssl_ctx);
 
@@ -82,6 +100,18 @@ HV_EXPORT int hssl_close(hssl_t ssl);
 
 HV_EXPORT int hssl_set_sni_hostname(hssl_t ssl, const char* hostname);
 
+// client session resumption: sessions are cached by peer such as "host:port", shared by all contexts,
+// call before hssl_connect, new sessions of this connection are cached for peer.
+// @return 1 if cached session set, 0 if not cached, -1 if not supported.
+HV_EXPORT int hssl_reuse_session(hssl_t ssl, const char* peer);
+// @return 1 if session resumed (abbreviated handshake), 0 if full handshake
+HV_EXPORT int hssl_session_reused(hssl_t ssl);
+
+// NOTE: kernel owns the record layer if offload engaged after handshake,
+// plaintext could be written to fd directly, such as sendfile.
+// @return HSSL_KTLS_TX | HSSL_KTLS_RX, 0 if not engaged or not supported.
+HV_EXPORT int hssl_get_ktls(hssl_t ssl);
+
 #ifdef WITH_OPENSSL
 HV_EXPORT int hssl_ctx_set_alpn_protos(hssl_ctx_t ssl_ctx, const unsigned char* protos, unsigned int protos_len);
 #endif
@@ -4,6 +4,13 @@
 
 #include "openssl/ssl.h"
 #include "openssl/err.h"
+#include "openssl/rand.h"
+#include "openssl/hmac.h"
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include "openssl/core_names.h"
+#endif
+
+#include "hmutex.h"
 #ifdef _MSC_VER
 //#pragma comment(lib, "libssl.a")
 //#pragma comment(lib, "libcrypto.a")
@@ -13,6 +20,190 @@ const char* hssl_backend() {
     return "openssl";
 }
 
+//------------------session resumption------------------------------
+#define HSSL_CLIENT_SESSION_CACHE_SIZE  1024
+
+typedef struct {
+    unsigned char   secret[32];
+    int             rotate_s;
+} hssl_ticket_keys_t;
+
+typedef struct {
+    char*           peer;
+    SSL_SESSION*    session;
+} hssl_client_session_t;
+
+static honce_t s_session_once = HONCE_INIT;
+static int s_ctx_ticket_keys_index = -1;   // SSL_CTX => hssl_ticket_keys_t
+static int s_ssl_peer_index = -1;          // SSL => peer
+static hmutex_t s_client_sessions_mutex;
+// NOTE: sessions of all contexts, as client contexts may be created per connection.
+static hssl_client_session_t s_client_sessions[HSSL_CLIENT_SESSION_CACHE_SIZE];
+static int s_client_sessions_num = 0;
+static int s_client_sessions_next = 0;     // round-robin eviction
+
+static void hssl_ex_data_free(void* parent, void* ptr, CRYPTO_EX_DATA* ad, int idx, long argl, void* argp) {
+    if (ptr) free(ptr);
+}
+
+static void hssl_session_init() {
+    s_ctx_ticket_keys_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, hssl_ex_data_free);
+    s_ssl_peer_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, hssl_ex_data_free);
+    hmutex_init(&s_client_sessions_mutex);
+}
+
+// label || epoch => HMAC-SHA256(secret)
+static void hssl_ticket_key(hssl_ticket_keys_t* keys, const char* label, uint64_t epoch, unsigned char out[32]) {
+    unsigned char msg[16] = {0};
+    unsigned int outlen = 32;
+    strncpy((char*)msg, label, 8);
+    for (int i = 0; i < 8; ++i) {
+        msg[8 + i] = (unsigned char)(epoch >> (56 - i * 8));
+    }
+    HMAC(EVP_sha256(), keys->secret, sizeof(keys->secret), msg, sizeof(msg), out, &outlen);
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+typedef EVP_MAC_CTX hssl_ticket_mac_ctx_t;
+static int hssl_ticket_mac_init(EVP_MAC_CTX* hctx, unsigned char key[32]) {
+    OSSL_PARAM params[3];
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key, 32);
+    params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*)"sha256", 0);
+    params[2] = OSSL_PARAM_construct_end();
+    return EVP_MAC_CTX_set_params(hctx, params);
+}
+#else
+typedef HMAC_CTX hssl_ticket_mac_ctx_t;
+static int hssl_ticket_mac_init(HMAC_CTX* hctx, unsigned char key[32]) {
+    return HMAC_Init_ex(hctx, key, 32, EVP_sha256(), NULL);
+}
+#endif
+
+// @return 1: ok, 2: decrypted by previous keys and renew, 0: not found, full handshake, -1: error
+static int hssl_ticket_key_cb(SSL* ssl, unsigned char key_name[16], unsigned char* iv,
+                              EVP_CIPHER_CTX* ectx, hssl_ticket_mac_ctx_t* hctx, int enc) {
+    hssl_ticket_keys_t* keys = (hssl_ticket_keys_t*)SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), s_ctx_ticket_keys_index);
+    if (keys == NULL) return -1;
+    uint64_t epoch = (uint64_t)time(NULL) / keys->rotate_s;
+    unsigned char name[32], aes_key[32], mac_key[32];
+    if (enc) {
+        hssl_ticket_key(keys, "name", epoch, name);
+        memcpy(key_name, name, 16);
+        if (RAND_bytes(iv, 16) != 1) return -1;
+        hssl_ticket_key(keys, "aes", epoch, aes_key);
+        hssl_ticket_key(keys, "mac", epoch, mac_key);
+        if (EVP_EncryptInit_ex(ectx, EVP_aes_256_cbc(), NULL, aes_key, iv) != 1) return -1;
+        return hssl_ticket_mac_init(hctx, mac_key) == 1 ? 1 : -1;
+    }
+    for (int i = 0; i < 2; ++i) {
+        hssl_ticket_key(keys, "name", epoch - i, name);
+        if (memcmp(key_name, name, 16) != 0) continue;
+        hssl_ticket_key(keys, "aes", epoch - i, aes_key);
+        hssl_ticket_key(keys, "mac", epoch - i, mac_key);
+        if (EVP_DecryptInit_ex(ectx, EVP_aes_256_cbc(), NULL, aes_key, iv) != 1) return -1;
+        if (hssl_ticket_mac_init(hctx, mac_key) != 1) return -1;
+#ifdef TLS1_3_VERSION
+        // NOTE: TLS1.3 clients use a ticket only once, always renew.
+        if (SSL_version(ssl) == TLS1_3_VERSION) return 2;
+#endif
+        return i == 0 ? 1 : 2;
+    }
+    return 0;
+}
+
+static int hssl_ctx_set_ticket_keys(SSL_CTX* ctx, const char* secret, int rotate_s) {
+    hssl_ticket_keys_t* keys = (hssl_ticket_keys_t*)calloc(1, sizeof(hssl_ticket_keys_t));
+    if (keys == NULL) return -1;
+    keys->rotate_s = rotate_s;
+    if (secret && *secret) {
+        unsigned int len = sizeof(keys->secret);
+        HMAC(EVP_sha256(), "libhv", 5, (const unsigned char*)secret, strlen(secret), keys->secret, &len);
+    } else if (RAND_bytes(keys->secret, sizeof(keys->secret)) != 1) {
+        free(keys);
+        return -1;
+    }
+    SSL_CTX_set_ex_data(ctx, s_ctx_ticket_keys_index, keys);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, hssl_ticket_key_cb);
+#else
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx, hssl_ticket_key_cb);
+#endif
+    return 0;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+// client: cache new session for peer, replace the old one
+static int hssl_new_session_cb(SSL* ssl, SSL_SESSION* session) {
+    const char* peer = (const char*)SSL_get_ex_data(ssl, s_ssl_peer_index);
+    if (peer == NULL || !SSL_SESSION_is_resumable(session)) return 0;
+    // NOTE: cache a copy, sessions in the internal cache of SSL_CTX are invalidated when SSL_CTX freed.
+    session = SSL_SESSION_dup(session);
+    if (session == NULL) return 0;
+    hssl_client_session_t* entry = NULL;
+    hmutex_lock(&s_client_sessions_mutex);
+    for (int i = 0; i < s_client_sessions_num; ++i) {
+        if (strcmp(s_client_sessions[i].peer, peer) == 0) {
+            entry = &s_client_sessions[i];
+            SSL_SESSION_free(entry->session);
+            break;
+        }
+    }
+    if (entry == NULL) {
+        if (s_client_sessions_num < HSSL_CLIENT_SESSION_CACHE_SIZE) {
+            entry = &s_client_sessions[s_client_sessions_num++];
+        } else {
+            entry = &s_client_sessions[s_client_sessions_next];
+            s_client_sessions_next = (s_client_sessions_next + 1) % HSSL_CLIENT_SESSION_CACHE_SIZE;
+            free(entry->peer);
+            SSL_SESSION_free(entry->session);
+        }
+        entry->peer = strdup(peer);
+    }
+    entry->session = session;
+    hmutex_unlock(&s_client_sessions_mutex);
+    return 0;
+}
+
+int hssl_reuse_session(hssl_t ssl, const char* peer) {
+    if (ssl == NULL || peer == NULL) return -1;
+    honce(&s_session_once, hssl_session_init);
+    // NOTE: sessions verified or not are cached apart.
+    int verify = SSL_get_verify_mode((SSL*)ssl) & SSL_VERIFY_PEER;
+    char* key = (char*)malloc(strlen(peer) + 3);
+    if (key == NULL) return -1;
+    sprintf(key, "%s#%d", peer, verify ? 1 : 0);
+    void* old = SSL_get_ex_data((SSL*)ssl, s_ssl_peer_index);
+    if (old) free(old);
+    SSL_set_ex_data((SSL*)ssl, s_ssl_peer_index, key);
+    int ret = 0;
+    hmutex_lock(&s_client_sessions_mutex);
+    for (int i = 0; i < s_client_sessions_num; ++i) {
+        hssl_client_session_t* entry = &s_client_sessions[i];
+        if (strcmp(entry->peer, key) != 0) continue;
+        if (SSL_SESSION_is_resumable(entry->session)) {
+            ret = SSL_set_session((SSL*)ssl, entry->session);
+        } else {
+            // NOTE: expired, or a TLS1.3 ticket already used, evict it and wait for a new one
+            free(entry->peer);
+            SSL_SESSION_free(entry->session);
+            *entry = s_client_sessions[--s_client_sessions_num];
+        }
+        break;
+    }
+    hmutex_unlock(&s_client_sessions_mutex);
+    return ret;
+}
+
+#else
+int hssl_reuse_session(hssl_t ssl, const char* peer) {
+    return -1;
+}
+#endif
+
+int hssl_session_reused(hssl_t ssl) {
+    return SSL_session_reused((SSL*)ssl);
+}
+
 hssl_ctx_t hssl_ctx_new(hssl_ctx_opt_t* param) {
     static int s_initialized = 0;
     if (s_initialized == 0) {
@@ -80,6 +271,47 @@ hssl_ctx_t hssl_ctx_new(hssl_ctx_opt_t* param) {
 #ifdef SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER
     SSL_CTX_set_mode(ctx, SSL_CTX_get_mode(ctx) | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 #endif
+    // session resumption
+    honce(&s_session_once, hssl_session_init);
+    // NOTE: hssl_ctx_new(NULL) without certificate is the default context of clients.
+    if (param == NULL || param->endpoint == HSSL_CLIENT) {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    } else {
+        // NOTE: server contexts may connect too (g_ssl_ctx), client sessions go to hssl_new_session_cb.
+        int cache_mode = SSL_SESS_CACHE_CLIENT;
+        if (param->session_cache_size >= 0) {
+            cache_mode |= SSL_SESS_CACHE_SERVER;
+            if (param->session_cache_size > 0) {
+                SSL_CTX_sess_set_cache_size(ctx, param->session_cache_size);
+            }
+        }
+        SSL_CTX_set_session_cache_mode(ctx, cache_mode);
+        // NOTE: required to resume sessions if verify peer
+        SSL_CTX_set_session_id_context(ctx, (const unsigned char*)"libhv", 5);
+        if (param->ticket_rotate_s < 0) {
+            SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        } else if (param->ticket_rotate_s > 0) {
+            if (hssl_ctx_set_ticket_keys(ctx, param->ticket_secret, param->ticket_rotate_s) != 0) {
+                fprintf(stderr, "ssl ticket keys error!\n");
+                goto error;
+            }
+        }
+    }
+    if (param && param->session_timeout > 0) {
+        SSL_CTX_set_timeout(ctx, param->session_timeout);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    SSL_CTX_sess_set_new_cb(ctx, hssl_new_session_cb);
+#endif
+
+    if (param && param->ktls) {
+#ifdef SSL_OP_ENABLE_KTLS
+        // NOTE: engaged per connection only if kernel tls module and negotiated cipher supported
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+        hlogw("ssl ktls not supported by this openssl!");
+#endif
+    }
     SSL_CTX_set_verify(ctx, mode, NULL);
     return ctx;
 error:
@@ -166,6 +398,15 @@ int hssl_set_sni_hostname(hssl_t ssl, const char* hostname) {
     return 0;
 }
 
+int hssl_get_ktls(hssl_t ssl) {
+    int ktls = 0;
+#ifdef SSL_OP_ENABLE_KTLS
+    if (BIO_get_ktls_send(SSL_get_wbio((SSL*)ssl))) ktls |= HSSL_KTLS_TX;
+    if (BIO_get_ktls_recv(SSL_get_rbio((SSL*)ssl))) ktls |= HSSL_KTLS_RX;
+#endif
+    return ktls;
+}
+
 #ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
 static int hssl_ctx_alpn_select_cb(SSL *ssl,
     const unsigned char **out, unsigned char *outlen,
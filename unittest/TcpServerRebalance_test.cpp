@@ -0,0 +1,123 @@
+/*
+ * TcpServerRebalance_test.cpp
+ *
+ * @build   make libhv && make unittest
+ * @test    bin/TcpServerRebalance_test [seconds]
+ *
+ * 4 worker_threads with LB_RoundRobin, 8 clients, the chatty ones are all
+ * accepted by worker_thread[0], the rebalancer should migrate them apart.
+ *
+ */
+
+#include <iostream>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "htime.h"
+
+using namespace hv;
+
+#define WORKER_THREADS  4
+#define CLIENTS         8
+#define WORK_US         200 // per message
+
+static bool isChatty(int i) {
+    // NOTE: LB_RoundRobin accepts client[i] by worker_thread[(i+1)%4]
+    return (i + 1) % WORKER_THREADS == 0;
+}
+
+static void busyWork(int us) {
+    uint64_t end_us = gethrtime_us() + us;
+    while (gethrtime_us() < end_us);
+}
+
+static void printLoops(TcpServer& srv, uint64_t* last_busy_us, uint64_t* busy_ms) {
+    for (int i = 0; i < WORKER_THREADS; ++i) {
+        EventLoopPtr loop = srv.loop(i);
+        hloop_stats_t stats;
+        hloop_stats(loop->loop(), &stats);
+        uint64_t sum = stats.hists[HLOOP_HIST_ITERATION].sum;
+        busy_ms[i] = (sum - last_busy_us[i]) / 1000;
+        last_busy_us[i] = sum;
+        printf("loop[%d] conns=%u busy=%llums  ", i, (unsigned)loop->connectionNum,
+            (unsigned long long)busy_ms[i]);
+    }
+    printf("migrations=%llu\n", (unsigned long long)srv.migrationNum());
+}
+
+int main(int argc, char* argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 5;
+
+    TcpServer srv;
+    int listenfd = srv.createsocket(0, "127.0.0.1");
+    if (listenfd < 0) {
+        return -20;
+    }
+    int port = srv.port;
+    srv.onMessage = [](const SocketChannelPtr& channel, Buffer* buf) {
+        busyWork(WORK_US);
+        channel->write(buf);
+    };
+    srv.setThreadNum(WORKER_THREADS);
+    srv.setLoadBalance(LB_RoundRobin);
+    srv.setRebalance(2000, 0.2);
+    srv.start();
+
+    auto loop_thread = std::make_shared<EventLoopThread>();
+    loop_thread->start();
+    std::vector<std::shared_ptr<TcpClientEventLoopTmpl<SocketChannel>>> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        auto cli = std::make_shared<TcpClientEventLoopTmpl<SocketChannel>>(loop_thread->loop());
+        bool chatty = isChatty(i);
+        EventLoopPtr loop = loop_thread->loop();
+        cli->onConnection = [loop, chatty](const SocketChannelPtr& channel) {
+            if (!channel->isConnected()) return;
+            channel->write("ping");
+            if (!chatty) {
+                loop->setInterval(100, [channel](TimerID timerID) {
+                    channel->write("ping");
+                });
+            }
+        };
+        cli->onMessage = [chatty](const SocketChannelPtr& channel, Buffer* buf) {
+            // ping-pong as fast as possible
+            if (chatty) channel->write(buf);
+        };
+        cli->createsocket(port, "127.0.0.1");
+        cli->start();
+        clients.push_back(cli);
+        // NOTE: wait accepted, make LB_RoundRobin deterministic
+        while (srv.connectionNum() < (size_t)i + 1) hv_msleep(1);
+    }
+
+    uint64_t last_busy_us[WORKER_THREADS] = {0};
+    uint64_t first_busy_ms[WORKER_THREADS] = {0};
+    uint64_t busy_ms[WORKER_THREADS] = {0};
+    for (int s = 0; s < seconds; ++s) {
+        hv_sleep(1);
+        printLoops(srv, last_busy_us, busy_ms);
+        if (s == 0) memcpy(first_busy_ms, busy_ms, sizeof(busy_ms));
+    }
+
+    // NOTE: busy time is wall time, share of the busiest loop is meaningful even if cpus < loops.
+    uint64_t first_max = 0, first_sum = 0, last_max = 0, last_sum = 0;
+    for (int i = 0; i < WORKER_THREADS; ++i) {
+        first_max = MAX(first_max, first_busy_ms[i]);
+        first_sum += first_busy_ms[i];
+        last_max = MAX(last_max, busy_ms[i]);
+        last_sum += busy_ms[i];
+    }
+    int first_share = first_sum ? first_max * 100 / first_sum : 0;
+    int last_share = last_sum ? last_max * 100 / last_sum : 0;
+    uint64_t migrations = srv.migrationNum();
+    printf("busiest loop share: %d%% => %d%%, migrations=%llu\n",
+        first_share, last_share, (unsigned long long)migrations);
+
+    for (auto& cli : clients) {
+        cli->closesocket();
+    }
+    loop_thread->stop();
+    loop_thread->join();
+    srv.stop();
+    return migrations > 0 && last_share < first_share ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <assert.h>
+
+#include "hconsistenthash.h"
+
+#define NKEYS   100000
+
+static void key_of(int i, char* key, int len) {
+    // ip like keys, the worst case of poor hash
+    snprintf(key, len, "192.168.%d.%d", (i >> 8) & 0xFF, i & 0xFF);
+}
+
+static void assign(const HConsistentHash& ring, std::vector<int>& nodes) {
+    char key[32];
+    for (int i = 0; i < NKEYS; ++i) {
+        key_of(i, key, sizeof(key));
+        nodes[i] = ring.getNode(key, strlen(key));
+    }
+}
+
+int main(int argc, char** argv) {
+    HConsistentHash ring;
+    assert(ring.getNode("empty") == -1);
+
+    std::vector<int> before(NKEYS), after(NKEYS);
+    for (int node = 0; node < 4; ++node) {
+        ring.addNode(node);
+    }
+    assign(ring, before);
+
+    // balance
+    int counts[4] = {0};
+    for (int i = 0; i < NKEYS; ++i) {
+        ++counts[before[i]];
+    }
+    for (int node = 0; node < 4; ++node) {
+        printf("node[%d] keys=%d\n", node, counts[node]);
+        assert(counts[node] > NKEYS / 4 * 0.8 && counts[node] < NKEYS / 4 * 1.2);
+    }
+
+    // 4 => 5 nodes: only keys moved to the new node
+    ring.addNode(4);
+    assign(ring, after);
+    int moved = 0;
+    for (int i = 0; i < NKEYS; ++i) {
+        if (after[i] != before[i]) {
+            assert(after[i] == 4);
+            ++moved;
+        }
+    }
+    printf("4 => 5 nodes moved=%d%%\n", moved * 100 / NKEYS);
+    assert(moved > NKEYS / 5 * 0.8 && moved < NKEYS / 5 * 1.2);
+
+    // 5 => 4 nodes: restored, independent of the order of addNode
+    ring.removeNode(4);
+    assign(ring, after);
+    assert(after == before);
+
+    HConsistentHash reversed;
+    for (int node = 3; node >= 0; --node) {
+        reversed.addNode(node);
+    }
+    assign(reversed, after);
+    assert(after == before);
+
+    printf("consistenthash_test OK\n");
+    return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * hloop_post_event benchmark: N threads post M events each to one loop.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/hloop_post_event_test [threads=4] [posts=1000000]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hloop.h"
+#include "htime.h"
+#include "hthread.h"
+
+static hloop_t* loop = NULL;
+static int nthreads = 4;
+static int nposts = 1000000;
+static long total = 0;
+static long nrecvs = 0;
+
+static void on_post_event(hevent_t* ev) {
+    if (++nrecvs == total) {
+        hloop_stop(ev->loop);
+    }
+}
+
+static HTHREAD_ROUTINE(post_thread) {
+    hevent_t ev;
+    for (int i = 0; i < nposts; ++i) {
+        memset(&ev, 0, sizeof(ev));
+        ev.cb = on_post_event;
+        hloop_post_event(loop, &ev);
+    }
+    return 0;
+}
+
+static void on_start(htimer_t* timer) {
+    for (int i = 0; i < nthreads; ++i) {
+        hthread_create(post_thread, NULL);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) nthreads = atoi(argv[1]);
+    if (argc > 2) nposts = atoi(argv[2]);
+    if (nthreads <= 0 || nposts <= 0) {
+        printf("Usage: %s [threads] [posts]\n", argv[0]);
+        return -10;
+    }
+    total = (long)nthreads * nposts;
+
+    loop = hloop_new(0);
+    htimer_add(loop, on_start, 1, 1);
+    uint64_t start_us = gethrtime_us();
+    hloop_run(loop);
+    uint64_t cost_us = gethrtime_us() - start_us;
+    if (cost_us == 0) cost_us = 1;
+
+    printf("threads=%d posts=%ld cost=%llums loops=%llu\n",
+        nthreads, nrecvs,
+        (unsigned long long)cost_us / 1000,
+        (unsigned long long)hloop_count(loop));
+    printf("%.0f posts/s, %.1f posts per loop\n",
+        (double)nrecvs * 1000000 / cost_us,
+        (double)nrecvs / hloop_count(loop));
+    hloop_free(&loop);
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * kernel TLS: without hssl_ctx_opt_t.ktls writes keep the hssl_write path
+ * and hio_sendfile is not supported on ssl; with ktls, if the kernel
+ * engages it, hio_sendfile is supported and the peer still decrypts writes.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/ktls_test [port=20003]
+ *
+ * NOTE: run from the source root for cert/server.crt, skipped without ssl.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hloop.h"
+#include "hbuf.h"
+#include "hssl.h"
+#include "hsocket.h"
+#include "hthread.h"
+
+static hloop_t* loop = NULL;
+static int port = 20003;
+static int ktls_opt = 0;
+static int ktls = -1;
+static int result = -1;
+static int server_result = -1;
+
+static void on_recv(hio_t* io, void* buf, int readbytes) {
+    ktls = hio_get_ktls(io);
+    if (ktls != hssl_get_ktls(hio_get_ssl(io))) return;
+    bool sendfile = hio_sendfile_supported(io);
+    if (ktls & HSSL_KTLS_TX) {
+        if (!sendfile) return;
+    } else {
+        // ssl must encrypt in userspace
+        if (ktls_opt == 0 && ktls != 0) return;
+        if (sendfile) return;
+    }
+    // the client fails to decrypt if plaintext bypasses hssl_write
+    hbuf_t bufs[2] = {{(char*)"pong", 4}, {(char*)"-ok", 3}};
+    if (hio_write(io, buf, readbytes) != readbytes) return;
+    if (hio_writev(io, bufs, 2) != 7) return;
+    server_result = 0;
+}
+
+static void on_accept(hio_t* io) {
+    hio_setcb_read(io, on_recv);
+    hio_read(io);
+}
+
+static HTHREAD_ROUTINE(client_thread) {
+    hssl_ctx_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.endpoint = HSSL_CLIENT;
+    hssl_ctx_t ssl_ctx = hssl_ctx_new(&opt);
+    int fd = ConnectTimeout("127.0.0.1", port, 3000);
+    if (ssl_ctx == NULL || fd < 0) goto end;
+    so_rcvtimeo(fd, 3000);
+    hssl_t ssl = hssl_new(ssl_ctx, fd);
+    if (hssl_connect(ssl) != 0) {
+        hssl_free(ssl);
+        goto end;
+    }
+    hssl_write(ssl, "ping", 4);
+    char reply[16] = {0};
+    int nread = 0;
+    while (nread < 11) {
+        int n = hssl_read(ssl, reply + nread, 11 - nread);
+        if (n <= 0) break;
+        nread += n;
+    }
+    if (nread == 11 && memcmp(reply, "pingpong-ok", 11) == 0) {
+        result = 0;
+    }
+    hssl_free(ssl);
+end:
+    if (fd >= 0) closesocket(fd);
+    if (ssl_ctx) hssl_ctx_free(ssl_ctx);
+    hloop_stop(loop);
+    return 0;
+}
+
+static int run(hssl_ctx_t ssl_ctx) {
+    result = server_result = -1;
+    ktls = -1;
+    loop = hloop_new(0);
+    hio_t* listenio = hloop_create_ssl_server(loop, "127.0.0.1", port, on_accept);
+    if (listenio == NULL) {
+        hloop_free(&loop);
+        return -20;
+    }
+    hio_set_ssl_ctx(listenio, ssl_ctx);
+    hthread_t th = hthread_create(client_thread, NULL);
+    hloop_run(loop);
+    hthread_join(th);
+    hloop_free(&loop);
+    printf("ktls opt=%d engaged=%d: %s\n", ktls_opt, ktls,
+        result == 0 && server_result == 0 ? "OK" : "FAILED");
+    return result == 0 && server_result == 0 ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) port = atoi(argv[1]);
+
+    hssl_ctx_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.crt_file = "cert/server.crt";
+    opt.key_file = "cert/server.key";
+    opt.endpoint = HSSL_SERVER;
+    hssl_ctx_t ssl_ctx = hssl_ctx_new(&opt);
+    if (ssl_ctx == NULL) {
+        printf("ssl not supported, skip.\n");
+        return 0;
+    }
+    ktls_opt = 0;
+    int ret = run(ssl_ctx);
+    hssl_ctx_free(ssl_ctx);
+    if (ret != 0) return ret;
+
+    opt.ktls = 1;
+    ssl_ctx = hssl_ctx_new(&opt);
+    ktls_opt = 1;
+    ret = run(ssl_ctx);
+    hssl_ctx_free(ssl_ctx);
+    return ret;
+}
@@ -0,0 +1,184 @@
+/*
+ * mirrored ring readbuf: packages wrapped around the end of the ring are
+ * contiguous, partial packages survive hio_keep_readbuf and growing
+ * (hio_move_readbuf), and the heap readbuf is used when memfd/mmap fails.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/mirror_readbuf_test
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "hevent.h"
+#include "hsocket.h"
+#include "hthread.h"
+#include "hlog.h"
+
+#ifdef OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#define NPACKAGES       300
+#define HEAD_LEN        2
+#define MAX_BODY_LEN    20000
+#define CHUNK_SIZE      1499
+
+static int fds[2] = {-1, -1};
+static int npackages = 0;
+static int nwrapped = 0;
+static int nerrors = 0;
+static size_t max_len = 0;
+
+static int body_len(int seq) {
+    return (seq * 977) % MAX_BODY_LEN + 1;
+}
+
+static unsigned char body_byte(int seq, int i) {
+    return (unsigned char)(seq + i * 7);
+}
+
+// @return 0 if not supported
+static int test_mirror_alloc() {
+    size_t len = 1;
+    char* base = (char*)hv_mirror_alloc(&len);
+    if (base == NULL) return 0;
+    assert(len >= 1 && len % 4096 == 0);
+    // write across the wrap point, read back contiguous
+    const char* str = "0123456789";
+    memcpy(base + len - 4, str, 10);
+    assert(memcmp(base, "456789", 6) == 0);
+    assert(memcmp(base + len - 4, str, 10) == 0);
+    base[len / 2] = 'x';
+    assert(base[len + len / 2] == 'x');
+    hv_mirror_free(base, len);
+    return 1;
+}
+
+static void on_package(hio_t* io, void* buf, int readbytes) {
+    hio_readbuf_t* rb = hio_get_readbuf(io);
+    const unsigned char* p = (const unsigned char*)buf;
+    if ((char*)buf + readbytes > rb->base + rb->len) {
+        ++nwrapped;
+    }
+    if (rb->len > max_len) max_len = rb->len;
+    int seq = npackages++;
+    int len = body_len(seq);
+    if (readbytes != HEAD_LEN + len || ((p[0] << 8) | p[1]) != len) {
+        ++nerrors;
+    } else {
+        for (int i = 0; i < len; ++i) {
+            if (p[HEAD_LEN + i] != body_byte(seq, i)) {
+                ++nerrors;
+                break;
+            }
+        }
+    }
+    if (npackages == NPACKAGES) {
+        hloop_stop(hevent_loop(io));
+    }
+}
+
+// packages are written in odd chunks, so they are split everywhere.
+static HTHREAD_ROUTINE(writer_thread) {
+    static unsigned char buf[HEAD_LEN + MAX_BODY_LEN];
+    for (int seq = 0; seq < NPACKAGES; ++seq) {
+        int len = body_len(seq);
+        buf[0] = (unsigned char)(len >> 8);
+        buf[1] = (unsigned char)len;
+        for (int i = 0; i < len; ++i) {
+            buf[HEAD_LEN + i] = body_byte(seq, i);
+        }
+        int off = 0;
+        while (off < HEAD_LEN + len) {
+            int n = MIN(CHUNK_SIZE, HEAD_LEN + len - off);
+            n = send(fds[1], (const char*)buf + off, n, 0);
+            if (n <= 0) return 0;
+            off += n;
+        }
+    }
+    return 0;
+}
+
+static int run(int mirror, int nofile) {
+    unpack_setting_t setting;
+    memset(&setting, 0, sizeof(setting));
+    setting.mode = UNPACK_BY_LENGTH_FIELD;
+    setting.package_max_length = HEAD_LEN + MAX_BODY_LEN;
+    setting.body_offset = HEAD_LEN;
+    setting.length_field_offset = 0;
+    setting.length_field_bytes = 2;
+    setting.length_field_coding = BIG_ENDIAN;
+
+    if (Socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return -10;
+    }
+    hloop_t* loop = hloop_new(0);
+    hio_t* io = hio_get(loop, fds[0]);
+    nonblocking(fds[0]);
+    if (hio_set_readbuf_mirror(io, mirror) != 0) {
+        printf("mirror not supported, skip.\n");
+        hloop_free(&loop);
+        closesocket(fds[1]);
+        return 0;
+    }
+#ifdef OS_UNIX
+    struct rlimit old_limit;
+    if (nofile) {
+        // no more fds, memfd_create fails
+        getrlimit(RLIMIT_NOFILE, &old_limit);
+        struct rlimit limit = old_limit;
+        limit.rlim_cur = dup(fds[1]);
+        closesocket(limit.rlim_cur);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        size_t len = 1;
+        assert(hv_mirror_alloc(&len) == NULL);
+    }
+#endif
+    hio_set_unpack(io, &setting);
+    assert(hio_is_alloced_readbuf(io));
+    assert(hio_is_mirrored_readbuf(io) == (mirror && !nofile));
+    size_t init_len = io->readbuf.len;
+    if (nofile) {
+        // keeps the heap readbuf
+        assert(hio_set_readbuf_mirror(io, 1) == -1);
+        assert(hio_is_alloced_readbuf(io) && !hio_is_mirrored_readbuf(io));
+#ifdef OS_UNIX
+        setrlimit(RLIMIT_NOFILE, &old_limit);
+#endif
+    }
+    hio_setcb_read(io, on_package);
+    hio_read(io);
+
+    npackages = nwrapped = nerrors = 0;
+    max_len = 0;
+    hthread_t th = hthread_create(writer_thread, NULL);
+    hloop_run(loop);
+    hthread_join(th);
+    // grown with partial packages kept
+    assert(max_len > init_len);
+    printf("mirror=%d nofile=%d: packages=%d wrapped=%d errors=%d readbuf=%u=>%u\n",
+        mirror, nofile, npackages, nwrapped, nerrors,
+        (unsigned)init_len, (unsigned)max_len);
+    int ret = (npackages == NPACKAGES && nerrors == 0) ? 0 : -1;
+    if (mirror && !nofile && nwrapped == 0) ret = -2;
+    hloop_free(&loop);
+    closesocket(fds[1]);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    hlog_disable();
+    int ret = run(0, 0);
+    if (!test_mirror_alloc()) {
+        printf("mirror not supported, skip.\n");
+        return ret;
+    }
+    if (ret == 0) ret = run(1, 0);
+#ifdef OS_UNIX
+    if (ret == 0) ret = run(1, 1);
+#endif
+    return ret;
+}
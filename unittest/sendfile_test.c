@@ -0,0 +1,120 @@
+/*
+ * hio_sendfile of a file larger than max_write_bufsize over loopback tcp:
+ * unsent file bytes are not limited by max_write_bufsize, data written
+ * before and after the file is received in order.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/sendfile_test [port=20005]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hloop.h"
+#include "hbase.h"
+#include "hsocket.h"
+#include "hthread.h"
+
+#define MAX_WRITE_BUFSIZE   (1 << 20)
+#define FILE_SIZE           (32 << 20)
+#define HEADER              "header"
+#define TRAILER             "trailer"
+#define TOTAL_SIZE          (sizeof(HEADER) - 1 + FILE_SIZE + sizeof(TRAILER) - 1)
+
+static hloop_t* loop = NULL;
+static int port = 20005;
+static int filefd = -1;
+static int server_result = -1;
+static int result = -1;
+static size_t queued_bufsize = 0;
+static int supported = -1;
+
+static unsigned char file_byte(size_t i) {
+    return (unsigned char)(i % 251);
+}
+
+static void on_accept(hio_t* io) {
+    hio_set_max_write_bufsize(io, MAX_WRITE_BUFSIZE);
+    supported = hio_sendfile_supported(io);
+    if (!supported) {
+        hio_close(io);
+        return;
+    }
+    if (hio_write(io, HEADER, sizeof(HEADER) - 1) < 0) return;
+    if (hio_sendfile(io, filefd, 0, FILE_SIZE) < 0) return;
+    queued_bufsize = hio_write_bufsize(io);
+    // queued after the file, still under max_write_bufsize
+    if (hio_write(io, TRAILER, sizeof(TRAILER) - 1) < 0) return;
+    server_result = 0;
+}
+
+static HTHREAD_ROUTINE(client_thread) {
+    int fd = ConnectTimeout("127.0.0.1", port, 3000);
+    if (fd < 0) goto end;
+    so_rcvtimeo(fd, 3000);
+    static char buf[65536];
+    size_t nrecv = 0;
+    int nerrors = 0;
+    const size_t header_len = sizeof(HEADER) - 1;
+    while (nrecv < TOTAL_SIZE) {
+        int n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        for (int i = 0; i < n; ++i) {
+            size_t pos = nrecv + i;
+            char expect = pos < header_len ? HEADER[pos] :
+                          pos < header_len + FILE_SIZE ? (char)file_byte(pos - header_len) :
+                          TRAILER[pos - header_len - FILE_SIZE];
+            if (buf[i] != expect) ++nerrors;
+        }
+        nrecv += n;
+    }
+    printf("recv=%u errors=%d\n", (unsigned)nrecv, nerrors);
+    if (nrecv == TOTAL_SIZE && nerrors == 0) result = 0;
+    closesocket(fd);
+end:
+    hloop_stop(loop);
+    return 0;
+}
+
+static int create_file() {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/sendfile_test.%d", (int)getpid());
+    filefd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (filefd < 0) return -1;
+    unlink(path);
+    static unsigned char buf[65536];
+    for (size_t off = 0; off < FILE_SIZE; off += sizeof(buf)) {
+        for (size_t i = 0; i < sizeof(buf); ++i) {
+            buf[i] = file_byte(off + i);
+        }
+        if (write(filefd, buf, sizeof(buf)) != sizeof(buf)) return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) port = atoi(argv[1]);
+
+    loop = hloop_new(0);
+    if (create_file() != 0) return -20;
+    hio_t* listenio = hloop_create_tcp_server(loop, "127.0.0.1", port, on_accept);
+    if (listenio == NULL) return -30;
+    hthread_t th = hthread_create(client_thread, NULL);
+    hloop_run(loop);
+    hthread_join(th);
+    hloop_free(&loop);
+    close(filefd);
+
+    if (supported == 0) {
+        printf("sendfile not supported, skip.\n");
+        return 0;
+    }
+    printf("queued=%u max_write_bufsize=%u\n", (unsigned)queued_bufsize, MAX_WRITE_BUFSIZE);
+    if (server_result != 0 || result != 0 || queued_bufsize <= MAX_WRITE_BUFSIZE) {
+        printf("FAILED\n");
+        return -1;
+    }
+    return 0;
+}
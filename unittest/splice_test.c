@@ -0,0 +1,141 @@
+/*
+ * splice relay benchmark: client => proxy => server over loopback tcp,
+ * proxy relays with hio_setup_tcp_upstream, spliced in kernel or copied by hio_write_upstream.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/splice_test [splice=1] [MB=1024] [port=20002]
+ *          splice=2: a read_cb installed after hio_set_splice_upstream takes the copy path.
+ *
+ * client closes after sent, server checks bytes in order then closes,
+ * so the half-close path of splice relay is covered too.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hloop.h"
+#include "hbase.h"
+#include "htime.h"
+
+#define BLOCK_SIZE  (1 << 20)
+
+static int use_splice = 1;
+static uint64_t total = 1024ULL << 20;
+static uint64_t nsend = 0;
+static uint64_t nrecv = 0;
+static uint64_t nsplice = 0;
+static uint64_t nfiltered = 0;
+static int nbad = 0;
+static int port = 20002;
+static hio_t* proxy_io = NULL;
+
+static void fill_block(char* buf, uint64_t offset, int len) {
+    static char pattern[BLOCK_SIZE + 251];
+    if (pattern[2] == 0) {
+        for (int i = 0; i < (int)sizeof(pattern); ++i) {
+            pattern[i] = (char)(i % 251);
+        }
+    }
+    memcpy(buf, pattern + offset % 251, len);
+}
+
+// server
+static void on_server_recv(hio_t* io, void* buf, int readbytes) {
+    const char* p = (const char*)buf;
+    // check sparsely, all bytes would make it cpu bound
+    for (int i = 0; i < readbytes; i += 997) {
+        if (p[i] != (char)((nrecv + i) % 251)) ++nbad;
+    }
+    nrecv += readbytes;
+}
+
+static void on_server_close(hio_t* io) {
+    nsplice = hio_splice_bytes(proxy_io);
+    hloop_stop(hevent_loop(io));
+}
+
+static void on_server_accept(hio_t* io) {
+    hio_setcb_read(io, on_server_recv);
+    hio_setcb_close(io, on_server_close);
+    hio_read(io);
+}
+
+// proxy
+// e.g. a logger installed after splice, must see all bytes
+static void on_proxy_filter(hio_t* io, void* buf, int readbytes) {
+    nfiltered += readbytes;
+    hio_write_upstream(io, buf, readbytes);
+}
+
+static void on_proxy_accept(hio_t* io) {
+    proxy_io = io;
+    hio_setup_tcp_upstream(io, "127.0.0.1", port, 0);
+    if (use_splice) {
+        hio_set_splice_upstream(io, 1);
+    }
+    if (use_splice == 2) {
+        hio_setcb_read(io, on_proxy_filter);
+    }
+}
+
+// client
+static void send_block(hio_t* io) {
+    // keep one block in write_queue
+    while (nsend < total && hio_write_bufsize(io) < BLOCK_SIZE) {
+        int len = total - nsend < BLOCK_SIZE ? (int)(total - nsend) : BLOCK_SIZE;
+        char* buf = NULL;
+        HV_ALLOC(buf, len);
+        fill_block(buf, nsend, len);
+        nsend += len;
+        if (hio_write_owned(io, buf, len, NULL, NULL) < 0) return;
+    }
+    if (nsend >= total) {
+        // close after write_queue written, only once
+        hio_setcb_write(io, NULL);
+        hio_close(io);
+    }
+}
+
+static void on_client_write(hio_t* io, const void* buf, int writebytes) {
+    send_block(io);
+}
+
+static void on_client_connect(hio_t* io) {
+    hio_setcb_write(io, on_client_write);
+    send_block(io);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) use_splice = atoi(argv[1]);
+    if (argc > 2) total = (uint64_t)atoi(argv[2]) << 20;
+    if (argc > 3) port = atoi(argv[3]);
+    if (total == 0) {
+        printf("Usage: %s [splice] [MB] [port]\n", argv[0]);
+        return -10;
+    }
+
+    hloop_t* loop = hloop_new(0);
+    if (hloop_create_tcp_server(loop, "127.0.0.1", port, on_server_accept) == NULL ||
+        hloop_create_tcp_server(loop, "127.0.0.1", port + 1, on_proxy_accept) == NULL) {
+        return -20;
+    }
+    hloop_create_tcp_client(loop, "127.0.0.1", port + 1, on_client_connect, NULL);
+    uint64_t start_us = gethrtime_us();
+    hloop_run(loop);
+    uint64_t cost_us = gethrtime_us() - start_us;
+    if (cost_us == 0) cost_us = 1;
+
+    printf("splice=%d recv=%lluMB spliced=%lluMB filtered=%lluMB bad=%d cost=%llums\n",
+        use_splice,
+        (unsigned long long)(nrecv >> 20),
+        (unsigned long long)(nsplice >> 20),
+        (unsigned long long)(nfiltered >> 20),
+        nbad,
+        (unsigned long long)cost_us / 1000);
+    printf("%.1f MB/s\n", (double)nrecv * 1000000 / cost_us / (1 << 20));
+    hloop_free(&loop);
+    if (use_splice == 2 && (nfiltered != total || nsplice != 0)) return 2;
+    return nrecv == total && nbad == 0 ? 0 : 1;
+}
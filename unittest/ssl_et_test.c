@@ -0,0 +1,111 @@
+/*
+ * HLOOP_FLAG_EDGE_TRIGGERED with ssl: many small TLS records arrive in one
+ * burst, the server must read them all from a single edge.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/ssl_et_test [port=20002]
+ *
+ * NOTE: run from the source root for cert/server.crt, skipped without ssl.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hloop.h"
+#include "hssl.h"
+#include "hsocket.h"
+#include "hthread.h"
+
+#define NRECORDS        256
+#define RECORD_SIZE     64
+
+static hloop_t* loop = NULL;
+static int port = 20002;
+static size_t nrecv = 0;
+static int result = -1;
+
+static void on_recv(hio_t* io, void* buf, int readbytes) {
+    nrecv += readbytes;
+    if (nrecv == NRECORDS * RECORD_SIZE) {
+        hio_write(io, "done", 4);
+    }
+}
+
+static void on_accept(hio_t* io) {
+    hio_setcb_read(io, on_recv);
+    hio_read(io);
+}
+
+static HTHREAD_ROUTINE(client_thread) {
+    hssl_ctx_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.endpoint = HSSL_CLIENT;
+    hssl_ctx_t ssl_ctx = hssl_ctx_new(&opt);
+    int fd = ConnectTimeout("127.0.0.1", port, 3000);
+    if (ssl_ctx == NULL || fd < 0) goto end;
+    so_rcvtimeo(fd, 3000);
+    hssl_t ssl = hssl_new(ssl_ctx, fd);
+    if (hssl_connect(ssl) != 0) {
+        hssl_free(ssl);
+        goto end;
+    }
+    // one record per hssl_write, corked to arrive in one burst
+#ifdef TCP_CORK
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, (const char*)&on, sizeof(on));
+#endif
+    char buf[RECORD_SIZE];
+    memset(buf, 'a', sizeof(buf));
+    for (int i = 0; i < NRECORDS; ++i) {
+        hssl_write(ssl, buf, sizeof(buf));
+    }
+#ifdef TCP_CORK
+    on = 0;
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, (const char*)&on, sizeof(on));
+#endif
+    // the server stalls and this read times out if records are left unread
+    char reply[4] = {0};
+    if (hssl_read(ssl, reply, sizeof(reply)) == sizeof(reply) &&
+        memcmp(reply, "done", 4) == 0) {
+        result = 0;
+    }
+    hssl_free(ssl);
+end:
+    if (fd >= 0) closesocket(fd);
+    if (ssl_ctx) hssl_ctx_free(ssl_ctx);
+    hloop_stop(loop);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) port = atoi(argv[1]);
+
+    hssl_ctx_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.crt_file = "cert/server.crt";
+    opt.key_file = "cert/server.key";
+    opt.endpoint = HSSL_SERVER;
+    hssl_ctx_t ssl_ctx = hssl_ctx_new(&opt);
+    if (ssl_ctx == NULL) {
+        printf("ssl not supported, skip.\n");
+        return 0;
+    }
+
+    loop = hloop_new(HLOOP_FLAG_EDGE_TRIGGERED);
+    hio_t* listenio = hloop_create_ssl_server(loop, "127.0.0.1", port, on_accept);
+    if (listenio == NULL) {
+        return -20;
+    }
+    hio_set_ssl_ctx(listenio, ssl_ctx);
+    hthread_t th = hthread_create(client_thread, NULL);
+    hloop_run(loop);
+    hthread_join(th);
+    hloop_free(&loop);
+    hssl_ctx_free(ssl_ctx);
+
+    printf("ssl edge-triggered recv=%u/%u %s\n",
+        (unsigned)nrecv, (unsigned)(NRECORDS * RECORD_SIZE), result == 0 ? "OK" : "FAILED");
+    return result;
+}
@@ -0,0 +1,134 @@
+/*
+ * ssl session resumption with rotated ticket keys (ticket_rotate_s=1):
+ * connection 1 is a full handshake, connections 2-4 resume and are counted
+ * by hloop_stats_t.ssl_resumed, a ticket of the previous epoch still resumes,
+ * a ticket two epochs old does not.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/ssl_resume_test [port=20004]
+ *
+ * NOTE: run from the source root for cert/server.crt, skipped without ssl.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hloop.h"
+#include "hssl.h"
+#include "hsocket.h"
+#include "hthread.h"
+#include "htime.h"
+
+#define NCONNS  6
+
+static hloop_t* loop = NULL;
+static int port = 20004;
+static char peer[64];
+// client side hssl_session_reused of each connection, -1 if failed
+static int resumed[NCONNS];
+
+static void on_recv(hio_t* io, void* buf, int readbytes) {
+    hio_write(io, buf, readbytes);
+}
+
+static void on_accept(hio_t* io) {
+    hio_setcb_read(io, on_recv);
+    hio_read(io);
+}
+
+// @return hssl_session_reused, -1 if failed
+static int connect_once(hssl_ctx_t ssl_ctx) {
+    int ret = -1;
+    int fd = ConnectTimeout("127.0.0.1", port, 3000);
+    if (fd < 0) return -1;
+    so_rcvtimeo(fd, 3000);
+    hssl_t ssl = hssl_new(ssl_ctx, fd);
+    hssl_reuse_session(ssl, peer);
+    if (hssl_connect(ssl) == 0) {
+        // NOTE: TLS1.3 tickets arrive after handshake, read to cache them
+        char reply[4] = {0};
+        if (hssl_write(ssl, "ping", 4) == 4 &&
+            hssl_read(ssl, reply, sizeof(reply)) == sizeof(reply)) {
+            ret = hssl_session_reused(ssl);
+        }
+    }
+    hssl_free(ssl);
+    closesocket(fd);
+    return ret;
+}
+
+static void wait_until(time_t t) {
+    while (time(NULL) < t) {
+        hv_msleep(10);
+    }
+}
+
+static HTHREAD_ROUTINE(client_thread) {
+    // default client context
+    hssl_ctx_t ssl_ctx = hssl_ctx_new(NULL);
+    if (ssl_ctx) {
+        for (int i = 0; i < 3; ++i) {
+            resumed[i] = connect_once(ssl_ctx);
+        }
+        // connection 4 in one epoch, at the start of a second
+        time_t epoch = time(NULL) + 1;
+        wait_until(epoch);
+        resumed[3] = connect_once(ssl_ctx);
+        // previous epoch
+        wait_until(epoch + 1);
+        resumed[4] = connect_once(ssl_ctx);
+        // two epochs old
+        wait_until(epoch + 3);
+        resumed[5] = connect_once(ssl_ctx);
+        hssl_ctx_free(ssl_ctx);
+    }
+    hloop_stop(loop);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) port = atoi(argv[1]);
+    snprintf(peer, sizeof(peer), "127.0.0.1:%d", port);
+
+    hssl_ctx_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.crt_file = "cert/server.crt";
+    opt.key_file = "cert/server.key";
+    opt.endpoint = HSSL_SERVER;
+    opt.ticket_rotate_s = 1;
+    opt.ticket_secret = "ssl_resume_test";
+    hssl_ctx_t ssl_ctx = hssl_ctx_new(&opt);
+    if (ssl_ctx == NULL) {
+        printf("ssl not supported, skip.\n");
+        return 0;
+    }
+
+    for (int i = 0; i < NCONNS; ++i) resumed[i] = -1;
+    loop = hloop_new(0);
+    hio_t* listenio = hloop_create_ssl_server(loop, "127.0.0.1", port, on_accept);
+    if (listenio == NULL) {
+        return -20;
+    }
+    hio_set_ssl_ctx(listenio, ssl_ctx);
+    hthread_t th = hthread_create(client_thread, NULL);
+    hloop_run(loop);
+    hthread_join(th);
+    hloop_stats_t stats;
+    hloop_stats(loop, &stats);
+    hloop_free(&loop);
+    hssl_ctx_free(ssl_ctx);
+
+    printf("resumed:");
+    for (int i = 0; i < NCONNS; ++i) printf(" %d", resumed[i]);
+    printf(" ssl_handshakes=%llu ssl_resumed=%llu\n",
+        (unsigned long long)stats.ssl_handshakes, (unsigned long long)stats.ssl_resumed);
+    int expect[NCONNS] = {0, 1, 1, 1, 1, 0};
+    if (memcmp(resumed, expect, sizeof(expect)) != 0 || stats.ssl_resumed != 4) {
+        printf("FAILED\n");
+        return -1;
+    }
+    return 0;
+}
@@ -1,6 +1,12 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <vector>
+#include <algorithm>
 
 #include "hthreadpool.h"
+#include "hworkstealingpool.h"
 #include "hthread.h"
 #include "htime.h"
 
@@ -9,7 +15,97 @@ void print_task(int i) {
     hv_sleep(1);
 }
 
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// producers simulate io loops committing tasks,
+// every task commits a child task to test the local queue of work-stealing.
+template<class ThreadPool>
+void benchmark(const char* name, int threads, int producers, int tasks) {
+    ThreadPool tp(threads, threads);
+    tp.start();
+    std::vector<int64_t> latency(tasks * 2);
+    std::atomic<int> done(0);
+    std::atomic<int> next(0);
+    auto work = [&latency, &done](int idx, int64_t commit_ns) {
+        latency[idx] = now_ns() - commit_ns;
+        volatile int sum = 0;
+        for (int i = 0; i < 1000; ++i) sum += i;
+        ++done;
+    };
+
+    int64_t start_ns = now_ns();
+    std::vector<std::thread> committers;
+    for (int p = 0; p < producers; ++p) {
+        committers.emplace_back([&]() {
+            int i;
+            while ((i = next++) < tasks) {
+                int64_t commit_ns = now_ns();
+                tp.commit([&tp, &work, i, commit_ns]() {
+                    work(i * 2, commit_ns);
+                    tp.commit(work, i * 2 + 1, now_ns());
+                });
+            }
+        });
+    }
+    for (auto& th : committers) th.join();
+    while (done < tasks * 2) {
+        std::this_thread::yield();
+    }
+    int64_t cost_ns = now_ns() - start_ns;
+    tp.stop();
+
+    // latency: from commit to start
+    int n = tasks * 2;
+    std::sort(latency.begin(), latency.end());
+    printf("%-18s threads=%d producers=%d tasks=%d cost=%lldms throughput=%.0f/s latency p50=%lldus p99=%lldus p999=%lldus\n",
+        name, threads, producers, n, (long long)(cost_ns / 1000000),
+        n * 1e9 / cost_ns,
+        (long long)(latency[n / 2] / 1000),
+        (long long)(latency[n * 99 / 100] / 1000),
+        (long long)(latency[n * 999 / 1000] / 1000));
+}
+
+// concurrent first commits start the pool once,
+// workers of one pool commit into another and back to their own deque.
+static void test_work_stealing_pool() {
+    HWorkStealingPool a(2, 2), b(2, 2);
+    std::atomic<int> done(0);
+    std::vector<std::thread> committers;
+    for (int i = 0; i < 8; ++i) {
+        committers.emplace_back([&]() {
+            a.commit([&]() {
+                b.commit([&]() { ++done; }).get();
+                a.commit([&]() { ++done; });
+            });
+        });
+    }
+    for (auto& th : committers) th.join();
+    while (done < 16) {
+        std::this_thread::yield();
+    }
+    assert(a.currentThreadNum() == 2);
+    a.stop();
+    b.stop();
+    printf("HWorkStealingPool done=%d\n", (int)done);
+}
+
 int main(int argc, char** argv) {
+    if (argc > 1) {
+        // threadpool_test threads [producers] [tasks]
+        int threads = atoi(argv[1]);
+        int producers = argc > 2 ? atoi(argv[2]) : 4;
+        int tasks = argc > 3 ? atoi(argv[3]) : 100000;
+        if (threads <= 0) threads = std::thread::hardware_concurrency();
+        if (producers <= 0) producers = 1;
+        if (tasks <= 0) tasks = 100000;
+        benchmark<HThreadPool>("HThreadPool", threads, producers, tasks);
+        benchmark<HWorkStealingPool>("HWorkStealingPool", threads, producers, tasks);
+        return 0;
+    }
+
     HThreadPool tp(1, 4);
     tp.start();
 
@@ -26,5 +122,6 @@ int main(int argc, char** argv) {
 
     tp.wait();
 
+    test_work_stealing_pool();
     return 0;
 }
@@ -0,0 +1,262 @@
+/*
+ * timing wheel of hio timers, checked by htimer_stats_t.wheel_* counters:
+ * read timeout expiry, reset before expiry (explicit and lazy on read),
+ * cancel, a timeout longer than one wheel round, and a heartbeat of exactly
+ * one round re-inserted into the slot being processed.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/timer_wheel_test
+ *
+ * NOTE: takes about 11s for the round of HTIMER_WHEEL_SLOTS * HTIMER_WHEEL_TICK ms.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hevent.h"
+#include "hsocket.h"
+#include "htime.h"
+#include "hlog.h"
+
+#define WHEEL_ROUND_MS  (HTIMER_WHEEL_SLOTS * HTIMER_WHEEL_TICK)
+// fired at the first tick not earlier than timeout, plus loop wakeup
+#define SLACK_MS        (2 * HTIMER_WHEEL_TICK + 50)
+
+typedef struct timer_case_s {
+    hio_t*      io;
+    int         peer_fd;
+    uint64_t    start_us;
+    int         closed;
+    int         close_ms;
+    int         error;
+    int         nheartbeats;
+} timer_case_t;
+
+static hloop_t* loop = NULL;
+static timer_case_t cases[2];
+static htimer_t* guard_timer = NULL;
+
+static int elapsed_ms(timer_case_t* c) {
+    return (int)((gethrtime_us() - c->start_us) / 1000);
+}
+
+static void on_close(hio_t* io) {
+    timer_case_t* c = (timer_case_t*)hevent_userdata(io);
+    c->closed = 1;
+    c->close_ms = elapsed_ms(c);
+    c->error = hio_error(io);
+    hloop_stop(loop);
+}
+
+static void on_recv(hio_t* io, void* buf, int readbytes) {
+}
+
+static void on_heartbeat(hio_t* io) {
+    timer_case_t* c = (timer_case_t*)hevent_userdata(io);
+    ++c->nheartbeats;
+}
+
+static int case_open(timer_case_t* c) {
+    int fds[2];
+    memset(c, 0, sizeof(timer_case_t));
+    if (Socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return -1;
+    nonblocking(fds[0]);
+    c->io = hio_get(loop, fds[0]);
+    c->peer_fd = fds[1];
+    hevent_set_userdata(c->io, c);
+    hio_setcb_close(c->io, on_close);
+    hio_setcb_read(c->io, on_recv);
+    c->start_us = gethrtime_us();
+    return 0;
+}
+
+static void case_close(timer_case_t* c) {
+    if (!c->closed) hio_close(c->io);
+    closesocket(c->peer_fd);
+}
+
+static void stats_delta(const htimer_stats_t* before, htimer_stats_t* delta) {
+    htimer_stats_t now;
+    hloop_timer_stats(loop, &now);
+    *delta = now;
+    delta->wheel_inserts -= before->wheel_inserts;
+    delta->wheel_removes -= before->wheel_removes;
+    delta->wheel_expires -= before->wheel_expires;
+    delta->wheel_ticks -= before->wheel_ticks;
+}
+
+static void on_guard(htimer_t* timer) {
+    guard_timer = NULL;
+    hloop_stop(loop);
+}
+
+// NOTE: heap timers below, so they are not counted in wheel_*
+static void run_until_closed(int max_ms) {
+    guard_timer = htimer_add(loop, on_guard, max_ms, 1);
+    hloop_run(loop);
+    if (guard_timer) {
+        htimer_del(guard_timer);
+        guard_timer = NULL;
+    }
+}
+
+#define CHECK(cond) \
+    do {\
+        if (!(cond)) {\
+            printf("%s:%d CHECK(%s) FAILED\n", __FUNCTION__, __LINE__, #cond);\
+            return -1;\
+        }\
+    } while(0)
+
+// read timeout fires once and closes
+static int test_expire() {
+    timer_case_t* c = &cases[0];
+    htimer_stats_t before, delta;
+    hloop_timer_stats(loop, &before);
+    CHECK(case_open(c) == 0);
+    hio_set_read_timeout(c->io, 100);
+    hio_read(c->io);
+    run_until_closed(1000);
+    stats_delta(&before, &delta);
+    case_close(c);
+    printf("expire: close=%dms inserts=%llu removes=%llu expires=%llu\n", c->close_ms,
+        (unsigned long long)delta.wheel_inserts, (unsigned long long)delta.wheel_removes,
+        (unsigned long long)delta.wheel_expires);
+    CHECK(c->closed && c->error == ETIMEDOUT);
+    CHECK(c->close_ms >= 100 && c->close_ms < 100 + SLACK_MS);
+    CHECK(delta.wheel_inserts == 1 && delta.wheel_removes == 1 && delta.wheel_expires == 1);
+    CHECK(delta.wheel_timers == 0);
+    return 0;
+}
+
+static void on_reset(htimer_t* timer) {
+    timer_case_t* c = (timer_case_t*)hevent_userdata(timer);
+    hio_set_read_timeout(c->io, 200);
+}
+
+// hio_set_read_timeout again before expiry moves the timer without firing
+static int test_reset() {
+    timer_case_t* c = &cases[0];
+    htimer_stats_t before, delta;
+    hloop_timer_stats(loop, &before);
+    CHECK(case_open(c) == 0);
+    hio_set_read_timeout(c->io, 200);
+    hio_read(c->io);
+    htimer_t* timer = htimer_add(loop, on_reset, 100, 1);
+    hevent_set_userdata(timer, c);
+    run_until_closed(1000);
+    stats_delta(&before, &delta);
+    case_close(c);
+    printf("reset: close=%dms inserts=%llu removes=%llu expires=%llu\n", c->close_ms,
+        (unsigned long long)delta.wheel_inserts, (unsigned long long)delta.wheel_removes,
+        (unsigned long long)delta.wheel_expires);
+    CHECK(c->closed && c->error == ETIMEDOUT);
+    CHECK(c->close_ms >= 300 && c->close_ms < 300 + SLACK_MS);
+    CHECK(delta.wheel_inserts == 2 && delta.wheel_removes == 2 && delta.wheel_expires == 1);
+    return 0;
+}
+
+static void on_send(htimer_t* timer) {
+    timer_case_t* c = (timer_case_t*)hevent_userdata(timer);
+    send(c->peer_fd, "x", 1, 0);
+}
+
+// reads do not touch the wheel, the expired keepalive timer re-arms for the rest
+static int test_reset_on_read() {
+    timer_case_t* c = &cases[0];
+    htimer_stats_t before, delta;
+    hloop_timer_stats(loop, &before);
+    CHECK(case_open(c) == 0);
+    hio_set_keepalive_timeout(c->io, 300);
+    hio_read(c->io);
+    htimer_t* timer = htimer_add(loop, on_send, 100, 5);
+    hevent_set_userdata(timer, c);
+    run_until_closed(2000);
+    stats_delta(&before, &delta);
+    case_close(c);
+    printf("reset_on_read: close=%dms inserts=%llu removes=%llu expires=%llu\n", c->close_ms,
+        (unsigned long long)delta.wheel_inserts, (unsigned long long)delta.wheel_removes,
+        (unsigned long long)delta.wheel_expires);
+    CHECK(c->closed && c->error == ETIMEDOUT);
+    // last read at 500ms
+    CHECK(c->close_ms >= 800 && c->close_ms < 800 + SLACK_MS + 100);
+    // each expiry but the last one re-inserts
+    CHECK(delta.wheel_expires >= 2);
+    CHECK(delta.wheel_inserts == delta.wheel_expires && delta.wheel_removes == delta.wheel_expires);
+    return 0;
+}
+
+static void on_cancel(htimer_t* timer) {
+    timer_case_t* c = (timer_case_t*)hevent_userdata(timer);
+    hio_set_read_timeout(c->io, 0);
+}
+
+// hio_set_read_timeout(io, 0) removes the timer, it never fires
+static int test_cancel() {
+    timer_case_t* c = &cases[0];
+    htimer_stats_t before, delta;
+    hloop_timer_stats(loop, &before);
+    CHECK(case_open(c) == 0);
+    hio_set_read_timeout(c->io, 100);
+    hio_read(c->io);
+    htimer_t* timer = htimer_add(loop, on_cancel, 50, 1);
+    hevent_set_userdata(timer, c);
+    run_until_closed(300);
+    stats_delta(&before, &delta);
+    int closed = c->closed;
+    case_close(c);
+    printf("cancel: inserts=%llu removes=%llu expires=%llu\n",
+        (unsigned long long)delta.wheel_inserts, (unsigned long long)delta.wheel_removes,
+        (unsigned long long)delta.wheel_expires);
+    CHECK(!closed);
+    CHECK(delta.wheel_inserts == 1 && delta.wheel_removes == 1 && delta.wheel_expires == 0);
+    CHECK(delta.wheel_timers == 0);
+    return 0;
+}
+
+/*
+ * read timeout of one round and more: its slot is passed once after 260ms
+ * and skipped by next_timeout, it fires in the next round.
+ * heartbeat of exactly one round: re-inserted into the slot being processed,
+ * fires once per round.
+ */
+static int test_round() {
+    timer_case_t* c = &cases[0];
+    timer_case_t* hb = &cases[1];
+    int timeout_ms = WHEEL_ROUND_MS + 260;
+    htimer_stats_t before, delta;
+    hloop_timer_stats(loop, &before);
+    CHECK(case_open(c) == 0);
+    CHECK(case_open(hb) == 0);
+    hio_set_read_timeout(c->io, timeout_ms);
+    hio_read(c->io);
+    hio_set_heartbeat(hb->io, WHEEL_ROUND_MS, on_heartbeat);
+    run_until_closed(timeout_ms + 1000);
+    stats_delta(&before, &delta);
+    case_close(c);
+    case_close(hb);
+    printf("round: close=%dms heartbeats=%d inserts=%llu removes=%llu expires=%llu ticks=%llu\n",
+        c->close_ms, hb->nheartbeats,
+        (unsigned long long)delta.wheel_inserts, (unsigned long long)delta.wheel_removes,
+        (unsigned long long)delta.wheel_expires, (unsigned long long)delta.wheel_ticks);
+    CHECK(c->closed && c->error == ETIMEDOUT);
+    CHECK(c->close_ms >= timeout_ms && c->close_ms < timeout_ms + SLACK_MS);
+    CHECK(hb->nheartbeats == 1);
+    // read timer: insert, expire and remove; heartbeat: insert, expire, remove and re-insert
+    CHECK(delta.wheel_inserts == 3 && delta.wheel_removes == 2 && delta.wheel_expires == 2);
+    CHECK(delta.wheel_ticks >= (uint64_t)timeout_ms / HTIMER_WHEEL_TICK);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    hlog_disable();
+    loop = hloop_new(0);
+    int ret = test_expire();
+    if (ret == 0) ret = test_reset();
+    if (ret == 0) ret = test_reset_on_read();
+    if (ret == 0) ret = test_cancel();
+    if (ret == 0) ret = test_round();
+    hloop_free(&loop);
+    return ret;
+}
@@ -0,0 +1,126 @@
+/*
+ * udp echo pps benchmark: one echo server loop, one client loop keeping window datagrams in flight.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/udp_pps_test [batch=64] [seconds=3] [size=64] [window=256] [port=20002]
+ *          batch=0 to compare with one recvfrom/sendto per datagram.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hloop.h"
+#include "hthread.h"
+
+static int batch = HIO_MAX_BATCH;
+static int seconds = 3;
+static int size = 64;
+static int window = 256;
+static int port = 20002;
+static hloop_t* server_loop = NULL;
+static hloop_t* client_loop = NULL;
+static unsigned long long nechos = 0;
+static char sendbuf[65536];
+
+// server
+static void on_server_recv(hio_t* io, void* buf, int readbytes) {
+    hio_write(io, buf, readbytes);
+}
+
+static void on_server_recv_batch(hio_t* io, hio_dgram_t* dgrams, int cnt) {
+    hio_sendto_batch(io, dgrams, cnt);
+}
+
+static HTHREAD_ROUTINE(server_thread) {
+    hloop_run(server_loop);
+    return 0;
+}
+
+// client
+static void send_dgrams(hio_t* io, int cnt) {
+    if (batch) {
+        hio_dgram_t dgrams[HIO_MAX_BATCH];
+        while (cnt > 0) {
+            int n = cnt < HIO_MAX_BATCH ? cnt : HIO_MAX_BATCH;
+            for (int i = 0; i < n; ++i) {
+                dgrams[i].buf = sendbuf;
+                dgrams[i].len = size;
+                dgrams[i].addr = NULL;
+            }
+            hio_sendto_batch(io, dgrams, n);
+            cnt -= n;
+        }
+    } else {
+        while (cnt-- > 0) {
+            hio_write(io, sendbuf, size);
+        }
+    }
+}
+
+static void on_client_recv(hio_t* io, void* buf, int readbytes) {
+    ++nechos;
+    send_dgrams(io, 1);
+}
+
+static void on_client_recv_batch(hio_t* io, hio_dgram_t* dgrams, int cnt) {
+    nechos += cnt;
+    send_dgrams(io, cnt);
+}
+
+static void on_timeout(htimer_t* timer) {
+    hloop_stop(hevent_loop(timer));
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) batch = atoi(argv[1]);
+    if (argc > 2) seconds = atoi(argv[2]);
+    if (argc > 3) size = atoi(argv[3]);
+    if (argc > 4) window = atoi(argv[4]);
+    if (argc > 5) port = atoi(argv[5]);
+    if (seconds <= 0 || size <= 0 || size > (int)sizeof(sendbuf) || window <= 0) {
+        printf("Usage: %s [batch] [seconds] [size] [window] [port]\n", argv[0]);
+        return -10;
+    }
+
+    server_loop = hloop_new(0);
+    hio_t* server_io = hloop_create_udp_server(server_loop, "127.0.0.1", port);
+    if (server_io == NULL) {
+        return -20;
+    }
+    client_loop = hloop_new(0);
+    hio_t* client_io = hloop_create_udp_client(client_loop, "127.0.0.1", port);
+    if (client_io == NULL) {
+        return -30;
+    }
+    if (batch) {
+        if (hio_set_batch(server_io, batch, 0) != 0 ||
+            hio_set_batch(client_io, batch, 0) != 0) {
+            printf("hio_set_batch not supported, fallback to batch=0\n");
+            batch = 0;
+        }
+    }
+    hio_setcb_read(server_io, on_server_recv);
+    hio_setcb_read(client_io, on_client_recv);
+    if (batch) {
+        hio_setcb_read_batch(server_io, on_server_recv_batch);
+        hio_setcb_read_batch(client_io, on_client_recv_batch);
+    }
+    hio_read(server_io);
+    hio_read(client_io);
+    hthread_t th = hthread_create(server_thread, NULL);
+
+    send_dgrams(client_io, window);
+    htimer_add(client_loop, on_timeout, seconds * 1000, 1);
+    hloop_run(client_loop);
+
+    printf("batch=%d size=%d window=%d echos=%llu\n", batch, size, window, nechos);
+    printf("%.0f pps\n", (double)nechos / seconds);
+
+    hloop_stop(server_loop);
+    hthread_join(th);
+    hloop_free(&client_loop);
+    hloop_free(&server_loop);
+    return 0;
+}
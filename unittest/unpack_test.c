@@ -0,0 +1,152 @@
+/*
+ * unpack_find_delimiter (SIMD) against a scalar memmem for delimiters at
+ * every alignment and length, across 16/32 bytes boundaries,
+ * and packages of one read delivered by hio_setcb_read_batch.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/unpack_test
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hloop.h"
+#include "hsocket.h"
+#include "unpack.h"
+
+#define MAX_ALIGN       64
+#define MAX_HAYSTACK    100
+
+static const unsigned char* scalar_memmem(const unsigned char* p, const unsigned char* ep,
+                                          const unsigned char* delimiter, int delimiter_bytes) {
+    for (; ep - p >= delimiter_bytes; ++p) {
+        if (memcmp(p, delimiter, delimiter_bytes) == 0) return p;
+    }
+    return NULL;
+}
+
+static int test_find_delimiter() {
+    static unsigned char storage[MAX_ALIGN + MAX_HAYSTACK + 64];
+    unsigned char delimiter[PACKAGE_MAX_DELIMITER_BYTES];
+    int ncases = 0;
+    srand(2024);
+    for (int dlen = 1; dlen <= PACKAGE_MAX_DELIMITER_BYTES; ++dlen) {
+        // first 'a', last 'b', so candidates of first and last byte often mismatch in the middle
+        for (int i = 0; i < dlen; ++i) {
+            delimiter[i] = i == 0 ? 'a' : i == dlen - 1 ? 'b' : "ab"[i & 1];
+        }
+        for (int align = 0; align < MAX_ALIGN; ++align) {
+            unsigned char* p = storage + align;
+            for (int len = 0; len <= MAX_HAYSTACK; ++len) {
+                for (int i = 0; i < len; ++i) {
+                    p[i] = "abc"[rand() % 3];
+                }
+                // bytes beyond the end must not be matched
+                memcpy(p + len, delimiter, dlen);
+                // pos -1: no delimiter inserted
+                for (int pos = -1; pos <= len - dlen; ++pos) {
+                    unsigned char saved[PACKAGE_MAX_DELIMITER_BYTES];
+                    if (pos >= 0) {
+                        memcpy(saved, p + pos, dlen);
+                        memcpy(p + pos, delimiter, dlen);
+                    }
+                    const unsigned char* expect = scalar_memmem(p, p + len, delimiter, dlen);
+                    const unsigned char* found = unpack_find_delimiter(p, p + len, delimiter, dlen);
+                    if (found != expect) {
+                        printf("find_delimiter dlen=%d align=%d len=%d pos=%d: found=%d expect=%d\n",
+                            dlen, align, len, pos,
+                            found ? (int)(found - p) : -1,
+                            expect ? (int)(expect - p) : -1);
+                        return -1;
+                    }
+                    if (pos >= 0) {
+                        memcpy(p + pos, saved, dlen);
+                    }
+                    ++ncases;
+                }
+            }
+        }
+    }
+    printf("find_delimiter: %d cases OK\n", ncases);
+    return 0;
+}
+
+#define NLINES      100
+#define PARTIAL     "partial"
+
+static int fds[2] = {-1, -1};
+static int nbatches = 0;
+static int npackages = 0;
+static int nerrors = 0;
+
+static void on_batch(hio_t* io, hio_dgram_t* pkgs, int cnt) {
+    char line[64];
+    ++nbatches;
+    if (cnt > HIO_MAX_BATCH) ++nerrors;
+    for (int i = 0; i < cnt; ++i, ++npackages) {
+        if (npackages < NLINES) {
+            snprintf(line, sizeof(line), "line%d\r\n", npackages);
+        } else {
+            snprintf(line, sizeof(line), "%s%s", PARTIAL, "\r\n");
+        }
+        if (pkgs[i].len != (int)strlen(line) || memcmp(pkgs[i].buf, line, pkgs[i].len) != 0) {
+            ++nerrors;
+        }
+    }
+    if (npackages == NLINES) {
+        // complete the partial package kept in readbuf
+        send(fds[1], "\r\n", 2, 0);
+    } else if (npackages > NLINES) {
+        hloop_stop(hevent_loop(io));
+    }
+}
+
+static int test_read_batch() {
+    if (Socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return -10;
+    }
+    // all lines and a partial one in one read
+    char buf[2048];
+    int len = 0;
+    for (int i = 0; i < NLINES; ++i) {
+        len += snprintf(buf + len, sizeof(buf) - len, "line%d\r\n", i);
+    }
+    len += snprintf(buf + len, sizeof(buf) - len, "%s", PARTIAL);
+    if (send(fds[1], buf, len, 0) != len) {
+        return -20;
+    }
+
+    unpack_setting_t setting;
+    memset(&setting, 0, sizeof(setting));
+    setting.mode = UNPACK_BY_DELIMITER;
+    setting.package_max_length = 1024;
+    setting.delimiter[0] = '\r';
+    setting.delimiter[1] = '\n';
+    setting.delimiter_bytes = 2;
+
+    hloop_t* loop = hloop_new(0);
+    hio_t* io = hio_get(loop, fds[0]);
+    nonblocking(fds[0]);
+    hio_set_unpack(io, &setting);
+    hio_setcb_read_batch(io, on_batch);
+    hio_read(io);
+    hloop_run(loop);
+    hloop_free(&loop);
+    closesocket(fds[1]);
+
+    // NLINES in batches of HIO_MAX_BATCH, then the completed partial one
+    int expect_batches = (NLINES + HIO_MAX_BATCH - 1) / HIO_MAX_BATCH + 1;
+    printf("read_batch: packages=%d batches=%d errors=%d\n", npackages, nbatches, nerrors);
+    if (npackages != NLINES + 1 || nbatches != expect_batches || nerrors) {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int ret = test_find_delimiter();
+    if (ret == 0) ret = test_read_batch();
+    return ret;
+}
@@ -0,0 +1,111 @@
+/*
+ * upstream flow control: src => sink by hio_setup_upstream over socketpairs,
+ * the peer of sink does not read at first, so src stops reading once sink
+ * is over high water, and resumes when sink drained to low water.
+ * A drained_cb set by hio_setcb_drained before hio_setup_upstream is kept.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/upstream_water_test
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hevent.h"
+#include "hsocket.h"
+
+#define HIGH_WATER      (256 * 1024)
+#define LOW_WATER       (64 * 1024)
+#define TOTAL_BYTES     (8 * 1024 * 1024)
+
+static hio_t* src = NULL;
+static hio_t* sink = NULL;
+static hio_t* sink_peer = NULL;
+static int paused = 0;
+static int ndrained = 0;
+static int nresumed = 0;
+static int nerrors = 0;
+static size_t nrecv = 0;
+
+static unsigned char data_byte(size_t i) {
+    return (unsigned char)(i % 251);
+}
+
+static void on_drained(hio_t* io, size_t write_bufsize) {
+    ++ndrained;
+    if (write_bufsize > LOW_WATER) ++nerrors;
+    // hio_read(upstream_io) before the user drained_cb
+    if (src->events & HV_READ) ++nresumed;
+}
+
+static void on_sink_peer_recv(hio_t* io, void* buf, int readbytes) {
+    const unsigned char* p = (const unsigned char*)buf;
+    for (int i = 0; i < readbytes; ++i) {
+        if (p[i] != data_byte(nrecv + i)) {
+            ++nerrors;
+            break;
+        }
+    }
+    nrecv += readbytes;
+    if (nrecv >= TOTAL_BYTES) {
+        hloop_stop(hevent_loop(io));
+    }
+}
+
+static void on_check_paused(htimer_t* timer) {
+    // src stopped reading above high water
+    if (hio_is_over_high_water(sink) && !(src->events & HV_READ)) {
+        paused = 1;
+    }
+    printf("paused=%d sink write_bufsize=%u\n", paused, (unsigned)sink->write_bufsize);
+    hio_setcb_read(sink_peer, on_sink_peer_recv);
+    hio_read(sink_peer);
+}
+
+static void on_timeout(htimer_t* timer) {
+    hloop_stop(hevent_loop(timer));
+}
+
+int main(int argc, char** argv) {
+    int src_fds[2], sink_fds[2];
+    if (Socketpair(AF_UNIX, SOCK_STREAM, 0, src_fds) != 0 ||
+        Socketpair(AF_UNIX, SOCK_STREAM, 0, sink_fds) != 0) {
+        return -10;
+    }
+    static unsigned char buf[TOTAL_BYTES];
+    for (size_t i = 0; i < TOTAL_BYTES; ++i) {
+        buf[i] = data_byte(i);
+    }
+
+    hloop_t* loop = hloop_new(0);
+    hio_t* src_peer = hio_get(loop, src_fds[1]);
+    src = hio_get(loop, src_fds[0]);
+    sink = hio_get(loop, sink_fds[0]);
+    sink_peer = hio_get(loop, sink_fds[1]);
+    nonblocking(src_fds[0]);
+    nonblocking(src_fds[1]);
+    nonblocking(sink_fds[0]);
+    nonblocking(sink_fds[1]);
+
+    hio_set_write_water(sink, HIGH_WATER, LOW_WATER);
+    hio_setcb_drained(sink, on_drained);
+    hio_setup_upstream(src, sink);
+    hio_setcb_read(src, hio_write_upstream);
+    hio_read(src);
+    hio_write(src_peer, buf, TOTAL_BYTES);
+
+    htimer_add(loop, on_check_paused, 200, 1);
+    htimer_add(loop, on_timeout, 10000, 1);
+    hloop_run(loop);
+    hloop_free(&loop);
+
+    printf("paused=%d drained=%d resumed=%d errors=%d recv=%u\n",
+        paused, ndrained, nresumed, nerrors, (unsigned)nrecv);
+    if (!paused || ndrained == 0 || nresumed != ndrained ||
+        nerrors || nrecv != TOTAL_BYTES) {
+        printf("FAILED\n");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * hio_write_owned: free_cb must run exactly once whether the buffer is
+ * written at once, queued and flushed later, or dropped by close.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/write_owned_test
+ *
+ */
+
+#include <stdio.h>
+#include <assert.h>
+
+#include "hloop.h"
+#include "hbase.h"
+#include "hsocket.h"
+
+#define BIGSIZE     (4 << 20)
+
+static int nfree[3] = {0};
+static size_t nrecv = 0;
+static int nclose = 0;
+
+static void on_free(void* buf, void* userdata) {
+    ++*(int*)userdata;
+    HV_FREE(buf);
+}
+
+static int write_owned(hio_t* io, size_t len, int* counter) {
+    char* buf = NULL;
+    HV_ALLOC(buf, len);
+    return hio_write_owned(io, buf, len, on_free, counter);
+}
+
+static void on_peer_recv(hio_t* io, void* buf, int readbytes) {
+    nrecv += readbytes;
+    if (nrecv == BIGSIZE) {
+        hloop_stop(hevent_loop(io));
+    }
+}
+
+static void on_close(hio_t* io) {
+    ++nclose;
+    hloop_stop(hevent_loop(io));
+}
+
+int main(int argc, char** argv) {
+    int fds[2] = {-1, -1};
+    if (Socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return -10;
+    }
+    hloop_t* loop = hloop_new(0);
+    hio_t* io = hio_get(loop, fds[0]);
+    hio_t* peer = hio_get(loop, fds[1]);
+    nonblocking(fds[0]);
+    nonblocking(fds[1]);
+
+    // 1. written at once, released before return
+    int ret = write_owned(io, 1024, &nfree[0]);
+    assert(ret == 1024);
+    assert(nfree[0] == 1);
+    assert(hio_write_bufsize(io) == 0);
+    char tmp[1024];
+    ret = recv(fds[1], tmp, sizeof(tmp), 0);
+    assert(ret == sizeof(tmp));
+
+    // 2. queued, released once flushed
+    ret = write_owned(io, BIGSIZE, &nfree[1]);
+    assert(ret >= 0 && ret < BIGSIZE);
+    assert(nfree[1] == 0);
+    assert(hio_write_bufsize(io) == BIGSIZE - ret);
+    hio_setcb_read(peer, on_peer_recv);
+    hio_read(peer);
+    hloop_run(loop);
+    assert(nrecv == BIGSIZE);
+    assert(hio_write_bufsize(io) == 0);
+    assert(nfree[1] == 1);
+
+    // 3. queued, released by close
+    hio_read_stop(peer);
+    ret = write_owned(io, BIGSIZE, &nfree[2]);
+    assert(ret >= 0 && ret < BIGSIZE);
+    ret = write_owned(io, BIGSIZE, &nfree[2]);
+    assert(ret == 0);
+    assert(nfree[2] == 0);
+    hio_setcb_close(io, on_close);
+    hio_set_close_timeout(io, 100);
+    hio_close(io);
+    // close later, after close timeout
+    assert(nfree[2] == 0);
+    hloop_run(loop);
+    assert(nclose == 1);
+    assert(nfree[2] == 2);
+
+    hloop_free(&loop);
+    assert(nfree[0] == 1 && nfree[1] == 1 && nfree[2] == 2);
+    printf("hio_write_owned free_cb: written=%d flushed=%d closed=%d\n", nfree[0], nfree[1], nfree[2]);
+    return 0;
+}
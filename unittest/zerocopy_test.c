@@ -0,0 +1,108 @@
+/*
+ * MSG_ZEROCOPY benchmark: send blocks over loopback tcp with hio_write_owned.
+ *
+ * @build   make libhv && make unittest
+ * @usage   bin/zerocopy_test [zerocopy=1] [MB=1024] [blocksize=1048576] [port=20001]
+ *
+ * NOTE: loopback always falls back to copy, so this measures the overhead of
+ * notifications; run server and client on two hosts to see the real gain.
+ *
+ * max_write_bufsize is capped at 16 blocks, far below the total sent, so the
+ * test fails with ERR_OVER_LIMIT if zerocopy completions are not reaped.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hloop.h"
+#include "hbase.h"
+#include "htime.h"
+#include "hsocket.h"
+
+static int zerocopy = 1;
+static int blocksize = 1 << 20;
+static uint64_t total = 1024ULL << 20;
+static uint64_t nsend = 0;
+static uint64_t nrecv = 0;
+static int port = 20001;
+static int error = 0;
+
+static void on_recv(hio_t* io, void* buf, int readbytes) {
+    nrecv += readbytes;
+    if (nrecv >= total) {
+        hloop_stop(hevent_loop(io));
+    }
+}
+
+static void on_accept(hio_t* io) {
+    static char readbuf[1 << 20];
+    hio_setcb_read(io, on_recv);
+    hio_set_readbuf(io, readbuf, sizeof(readbuf));
+    hio_read(io);
+}
+
+static void send_block(hio_t* io) {
+    if (zerocopy) {
+        hio_set_zerocopy(io, HIO_DEFAULT_ZEROCOPY_THRESHOLD);
+    }
+    // keep two blocks in write_queue
+    while (nsend < total && hio_write_bufsize(io) < (size_t)blocksize) {
+        char* buf = NULL;
+        HV_ALLOC(buf, blocksize);
+        nsend += blocksize;
+        if (hio_write_owned(io, buf, blocksize, NULL, NULL) < 0) return;
+    }
+}
+
+static void on_write(hio_t* io, const void* buf, int writebytes) {
+    send_block(io);
+}
+
+static void on_close(hio_t* io) {
+    if (nrecv < total) {
+        printf("closed before done, error=%d\n", hio_error(io));
+        error = hio_error(io) ? hio_error(io) : -1;
+        hloop_stop(hevent_loop(io));
+    }
+}
+
+static void on_connect(hio_t* io) {
+    hio_set_max_write_bufsize(io, 8 * blocksize);
+    so_sndbuf(hio_fd(io), blocksize);
+    hio_setcb_close(io, on_close);
+    if (zerocopy && hio_set_zerocopy(io, HIO_DEFAULT_ZEROCOPY_THRESHOLD) != 0) {
+        printf("hio_set_zerocopy failed, fallback to copy\n");
+    }
+    hio_setcb_write(io, on_write);
+    send_block(io);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) zerocopy = atoi(argv[1]);
+    if (argc > 2) total = (uint64_t)atoi(argv[2]) << 20;
+    if (argc > 3) blocksize = atoi(argv[3]);
+    if (argc > 4) port = atoi(argv[4]);
+    if (total == 0 || blocksize <= 0) {
+        printf("Usage: %s [zerocopy] [MB] [blocksize] [port]\n", argv[0]);
+        return -10;
+    }
+
+    hloop_t* loop = hloop_new(0);
+    if (hloop_create_tcp_server(loop, "127.0.0.1", port, on_accept) == NULL) {
+        return -20;
+    }
+    hloop_create_tcp_client(loop, "127.0.0.1", port, on_connect, NULL);
+    uint64_t start_us = gethrtime_us();
+    hloop_run(loop);
+    uint64_t cost_us = gethrtime_us() - start_us;
+    if (cost_us == 0) cost_us = 1;
+
+    printf("zerocopy=%d blocksize=%d recv=%lluMB cost=%llums\n",
+        zerocopy, blocksize,
+        (unsigned long long)(nrecv >> 20),
+        (unsigned long long)cost_us / 1000);
+    printf("%.1f MB/s\n", (double)nrecv * 1000000 / cost_us / (1 << 20));
+    hloop_free(&loop);
+    return error;
+}